@@ -1,7 +1,9 @@
 #ifndef STORAGE_COMMON_H
 #define STORAGE_COMMON_H
 
+#include <functional>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
@@ -12,6 +14,18 @@ namespace jb_storage
 
 	using Value = std::variant<std::monostate, uint32_t, uint64_t, float, double, std::string, Blob>;
 
+	// takes a path relative to the scanned node and the value found there, returns false to stop the scan
+	using ScanCallback = std::function<bool(const std::string_view path, const Value& value)>;
+
+	// reductions over the numeric values (uint32_t, uint64_t, float and double) of a subtree
+	enum class Aggregation
+	{
+		Count,
+		Sum,
+		Min,
+		Max
+	};
+
 }
 
 #endif
@@ -0,0 +1,45 @@
+#ifndef STORAGE_HANDLE_H
+#define STORAGE_HANDLE_H
+
+#include "IStorage.h"
+
+#include <memory>
+
+namespace jb_storage
+{
+
+	struct IHandle;
+
+	// Path of Volume or Storage resolved once: the node it points to is pinned and the handle takes paths
+	// relative to that node, so repeated operations skip the walk from the root. The handle gets invalid
+	// (Get returns nothing, modifications fail) as soon as the node or any of its ancestors is deleted,
+	// the volume or storage it was opened on is destroyed, or the mount it was resolved through is removed.
+	class Handle final : public IStorage
+	{
+		friend class Storage;
+		friend class Volume;
+		using IHandlePtr = std::shared_ptr<const IHandle>;
+
+	private:
+		IHandlePtr	_impl;
+
+	public:
+		explicit operator bool () const noexcept;
+
+		std::optional<Value> Get(const std::string_view path) const override;
+		bool SetOrInsert(const std::string_view path, const Value& value) const override;
+		bool SetOrInsert(const std::string_view path, Value&& value) const override;
+		bool Delete(const std::string_view path) const override;
+
+		std::optional<Value> Get(const PathSegments path) const override;
+		bool SetOrInsert(const PathSegments path, const Value& value) const override;
+		bool SetOrInsert(const PathSegments path, Value&& value) const override;
+		bool Delete(const PathSegments path) const override;
+
+	private:
+		explicit Handle(IHandlePtr&& impl) noexcept;
+	};
+
+}
+
+#endif
@@ -2,6 +2,7 @@
 #define STORAGE_ISTORAGE_H
 
 #include <Common.h>
+#include <PathSegments.h>
 
 #include <optional>
 #include <string_view>
@@ -24,6 +25,11 @@ namespace jb_storage
 		virtual bool SetOrInsert(const std::string_view path, const Value& value) const = 0;
 		virtual bool SetOrInsert(const std::string_view path, Value&& value) const = 0;
 		virtual bool Delete(const std::string_view path) const = 0;
+
+		virtual std::optional<Value> Get(const PathSegments path) const = 0;
+		virtual bool SetOrInsert(const PathSegments path, const Value& value) const = 0;
+		virtual bool SetOrInsert(const PathSegments path, Value&& value) const = 0;
+		virtual bool Delete(const PathSegments path) const = 0;
 	};
 
 }
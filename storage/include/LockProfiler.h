@@ -0,0 +1,47 @@
+#ifndef STORAGE_LOCKPROFILER_H
+#define STORAGE_LOCKPROFILER_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace jb_storage
+{
+
+	struct LockStats
+	{
+		uint64_t	Acquisitions{ 0 };
+		uint64_t	WaitNanoseconds{ 0 };
+		uint64_t	MaxWaitNanoseconds{ 0 };
+		uint64_t	HoldNanoseconds{ 0 };
+	};
+
+	struct LockProfile
+	{
+		bool										Available{ false };
+		bool										Enabled{ false };
+		std::vector<LockStats>						ByDepth;		// index is the depth, root is 0; the 64th entry sums up all deeper ones
+		std::vector<std::pair<std::string, LockStats>>	HottestPaths;	// by total wait, longest first
+	};
+
+	// Process-wide profile of node locks taken while resolving paths of Volume, Storage and Handle
+	// (depth and paths of handle operations are relative to the handle's node). A lock of Storage's node
+	// includes locking the nodes mounted to it. Paths deeper than 16 levels are reported by their first
+	// 16 segments and depth. The profiler exists only when built with STORAGE_LOCK_PROFILER and is off
+	// until enabled; being off costs one relaxed atomic load per lock.
+	class LockProfiler final
+	{
+	public:
+		static bool IsAvailable() noexcept;
+
+		static void Enable(const bool enable = true) noexcept;
+
+		static LockProfile GetProfile(const size_t top = 10);
+
+		static void Reset();
+	};
+
+}
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef STORAGE_PATHSEGMENTS_H
+#define STORAGE_PATHSEGMENTS_H
+
+#include <array>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+
+namespace jb_storage
+{
+
+	// Path given as already split segments (for example std::vector<std::string_view> or the result of
+	// MakePath()), so that it needs neither concatenation nor parsing. The segments are referred to, not
+	// copied. Segments must be non-empty and must not contain '/', otherwise SetOrInsert() fails.
+	class PathSegments final
+	{
+	private:
+		const std::string_view*	_data;
+		size_t					_size;
+
+	public:
+		constexpr PathSegments(const std::string_view* data, const size_t size) noexcept : _data{ data }, _size{ size } { }
+
+		template < typename Container, typename = std::enable_if_t<std::is_same_v<std::decay_t<decltype(*std::data(std::declval<const Container&>()))>, std::string_view>> >
+		constexpr PathSegments(const Container& segments) noexcept : PathSegments{ std::data(segments), std::size(segments) } { }
+
+		constexpr size_t size() const noexcept						{ return _size; }
+		constexpr const std::string_view* begin() const noexcept	{ return _data; }
+		constexpr const std::string_view* end() const noexcept		{ return _data + _size; }
+	};
+
+	template < typename... Segments >
+	constexpr std::array<std::string_view, sizeof...(Segments)> MakePath(const Segments&... segments) noexcept
+	{ return { std::string_view{ segments }... }; }
+
+}
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef STORAGE_SNAPSHOT_H
+#define STORAGE_SNAPSHOT_H
+
+#include "Common.h"
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace jb_storage
+{
+
+	struct ISnapshot;
+
+	// Read-only view of Volume or Storage frozen at the moment it was taken: every read sees the values and
+	// children as they were then, however long after it's made. Writers are not blocked: a node keeps its
+	// states live snapshots may see as it changes, and drops them on a later change once none does, so
+	// that a snapshot costs memory for what changes while it's alive. Through Storage, mounted volumes are
+	// seen as of that moment, while mounts themselves are resolved as they are at the time of the read.
+	class Snapshot final
+	{
+		friend class Storage;
+		friend class Volume;
+
+	private:
+		std::unique_ptr<const ISnapshot>	_impl;
+
+	public:
+		Snapshot(Snapshot&&) noexcept;
+		Snapshot& operator = (Snapshot&&) noexcept;
+		~Snapshot();
+
+		std::optional<Value> Get(const std::string_view path) const;
+
+		// same as Volume::List() and Volume::Scan()
+		std::optional<std::vector<std::string>> List(const std::string_view path, const size_t limit = 0, const std::string_view after = { }) const;
+		std::string Scan(const std::string_view path, const ScanCallback& callback, const std::string_view resume = { }) const;
+
+	private:
+		explicit Snapshot(std::unique_ptr<const ISnapshot>&& impl) noexcept;
+	};
+
+}
+
+#endif
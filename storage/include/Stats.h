@@ -0,0 +1,108 @@
+#ifndef STORAGE_STATS_H
+#define STORAGE_STATS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace jb_storage
+{
+
+	namespace utility
+	{
+		class Metrics;
+	}
+
+	// Distribution of latencies in nanoseconds over log-linear buckets, HDR histogram style: values below 32
+	// are kept exactly, above that every power of two is split into 16 buckets, so that a percentile is
+	// reported within 1/16 of the actual value. Values above 2^39 ns (about 9 minutes) fall into the top bucket.
+	class LatencyHistogram final
+	{
+		friend class utility::Metrics;
+
+	public:
+		static constexpr size_t BucketCount{ 576 };
+
+	private:
+		std::array<uint64_t, BucketCount>	_buckets{ };
+		uint64_t							_count{ 0 };
+		uint64_t							_sum{ 0 };
+		uint64_t							_min{ 0 };
+		uint64_t							_max{ 0 };
+
+	public:
+		void Record(const uint64_t value) noexcept;
+		void Merge(const LatencyHistogram& other) noexcept;
+
+		uint64_t GetCount() const noexcept	{ return _count; }
+		uint64_t GetMin() const noexcept	{ return _min; }
+		uint64_t GetMax() const noexcept	{ return _max; }
+		double GetMean() const noexcept		{ return _count ? static_cast<double>(_sum) / _count : 0.; }
+
+		// value not exceeded by the given percentage (0 to 100) of recorded ones, 0 if nothing is recorded
+		uint64_t GetPercentile(const double percentile) const noexcept;
+
+		static size_t GetBucketIndex(const uint64_t value) noexcept;
+		static uint64_t GetBucketUpperBound(const size_t index) noexcept;
+	};
+
+	struct OperationStats
+	{
+		uint64_t			Calls{ 0 };
+		uint64_t			Hits{ 0 };		// Get and Delete found the node, SetOrInsert stored the value
+		LatencyHistogram	Latency;
+	};
+
+	// Totals of a subtree kept up to date by every change on its way up to the root, so that reading them
+	// costs no walk. A change is applied to one node after another, so totals of an ancestor may lag behind
+	// those of its descendants for a moment.
+	struct Usage
+	{
+		uint64_t	Nodes{ 0 };			// not counting the node itself
+		uint64_t	KeyBytes{ 0 };		// names of those nodes
+		uint64_t	ValueBytes{ 0 };	// the node's own value included, see Stats::ValueBytes
+	};
+
+	// Subtrees of a volume spilled to disk (see Volume::SetMemoryBudget()), counted whether statistics are
+	// enabled or not. Bytes are those of the estimate the budget is held against: keys, values and nodes.
+	struct SpillStats
+	{
+		uint64_t	Evictions{ 0 };		// subtrees written out
+		uint64_t	FaultIns{ 0 };		// subtrees read back in
+		uint64_t	Subtrees{ 0 };		// out on disk now
+		uint64_t	Bytes{ 0 };			// of those
+		uint64_t	ResidentBytes{ 0 };	// of the rest, in memory
+		uint64_t	FileBytes{ 0 };		// written to the file, space given up included
+		uint64_t	DeadBytes{ 0 };		// of those, given up and yet to be written over
+	};
+
+	// Garbage of deletes, such as subtrees taken out, waiting for the background thread that destroys it. It's
+	// shared by all volumes and storages, and counted whether statistics are enabled or not.
+	struct ReclaimStats
+	{
+		uint64_t	Queued{ 0 };		// retired and yet to be destroyed, cleanups deferred included
+		uint64_t	Inline{ 0 };		// destroyed by whoever retired it, the queue being full
+	};
+
+	// Counters cover calls made since statistics were enabled, through the volume or storage itself
+	// (asynchronous calls included); operations made through handles are not counted.
+	// Gauges are the Usage of the root. Storage leaves gauges zero.
+	struct Stats
+	{
+		bool			Enabled{ false };
+
+		OperationStats	Get;
+		OperationStats	SetOrInsert;
+		OperationStats	Delete;
+
+		uint64_t		Nodes{ 0 };			// not counting the root
+		uint64_t		KeyBytes{ 0 };
+		uint64_t		ValueBytes{ 0 };	// payload only: string and blob length, size of a number
+
+		SpillStats		Spill;
+		ReclaimStats	Reclaim;
+	};
+
+}
+
+#endif
@@ -28,7 +28,7 @@ namespace jb_storage
 		};
 
 	private:
-		std::unique_ptr<Impl>	_impl;
+		std::shared_ptr<Impl>	_impl;
 
 	public:
 		Storage();
@@ -39,7 +39,70 @@ namespace jb_storage
 		bool SetOrInsert(const std::string_view path, Value&& value) const override;
 		bool Delete(const std::string_view path) const override;
 
+		std::optional<Value> Get(const PathSegments path) const override;
+		bool SetOrInsert(const PathSegments path, const Value& value) const override;
+		bool SetOrInsert(const PathSegments path, Value&& value) const override;
+		bool Delete(const PathSegments path) const override;
+
+		// see Volume::CompareAndSwap()
+		bool CompareAndSwap(const std::string_view path, const uint32_t expected, const uint32_t desired) const;
+		bool CompareAndSwap(const std::string_view path, const uint64_t expected, const uint64_t desired) const;
+		std::optional<uint32_t> FetchAdd(const std::string_view path, const uint32_t delta) const;
+		std::optional<uint64_t> FetchAdd(const std::string_view path, const uint64_t delta) const;
+
+		// Names of the children of the node at path in key order, nothing if there's no such node. At most limit
+		// names are returned (0 means no limit), starting after the given one; to page through a wide node,
+		// pass the last name of a page as after for the next one.
+		std::optional<std::vector<std::string>> List(const std::string_view path, const size_t limit = 0, const std::string_view after = { }) const;
+
+		// Streams the subtree under path, not including the node itself, depth first with children in key order,
+		// until the callback returns false. Returns a resume token, the path of the last visited node relative
+		// to the scanned one, to be passed to the next call to carry on; empty once the whole subtree is visited.
+		// Memory used is bounded by the depth of the subtree and only one node is locked at a time, so the tree
+		// may change meanwhile: nodes added or deleted concurrently may be visited or not.
+		std::string Scan(const std::string_view path, const ScanCallback& callback, const std::string_view resume = { }) const;
+
+		// Calls back for every node below the root whose path matches the pattern, where "*" stands for any
+		// single segment, "**" for any number of them (none included) and '*' within a segment for any run
+		// of characters, e.g. "/shards/*/stats/qps" or "/**/qps". Matches are expanded in a single traversal,
+		// independent subtrees in parallel, and reported as they're found, in no particular order: one call
+		// at a time, but from any thread. Returning false from the callback stops the query. Returns the
+		// number of matches reported.
+		size_t Glob(const std::string_view pattern, const ScanCallback& callback) const;
+
+		// Reduces the numeric values of the subtree under path, the node itself included, in double precision;
+		// values of other types are skipped. Nothing if there's no such node, or for Min and Max if there are
+		// no numeric values. Values are read in place rather than copied out, and large subtrees are reduced
+		// in parallel; nodes are locked one at a time, so concurrent changes may or may not be seen.
+		std::optional<double> Aggregate(const std::string_view path, const Aggregation aggregation) const;
+
+		// Totals of the subtree under path, nothing if there's no such node. Under a mount point these are
+		// the totals of the mounted subtree; a node made by Storage sums up everything mounted at and below
+		// it, entries shadowed by a later mount included, plus the nodes made to lead to deeper mount points.
+		std::optional<Usage> GetUsage(const std::string_view path) const;
+
+		Handle Open(const std::string_view path) const;
+
+		// Transactions write to mounted volumes the way SetOrInsert() and Delete() do; mounts and unmounts
+		// in between are not checked on commit
+		Transaction BeginTransaction() const;
+
+		// consistent view of all the mounted volumes at this moment, see jb_storage::Snapshot
+		jb_storage::Snapshot Snapshot() const;
+
 		MountToken Mount(const std::string_view where, const Volume& volume, const std::string_view what) const;
+
+		// Asynchronous counterparts run in the library's thread pool
+		std::future<std::optional<Value>> GetAsync(const std::string_view path) const;
+		std::future<bool> SetOrInsertAsync(const std::string_view path, Value value) const;
+		std::future<bool> DeleteAsync(const std::string_view path) const;
+
+		// caps the number of asynchronous operations on this storage running at once, 0 means no limit
+		void SetAsyncConcurrency(const size_t limit) const;
+
+		// statistics are off by default; turning them off keeps what has been counted so far
+		void EnableStats(const bool enable = true) const;
+		Stats GetStats() const;
 	};
 
 }
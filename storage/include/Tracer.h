@@ -0,0 +1,29 @@
+#ifndef STORAGE_TRACER_H
+#define STORAGE_TRACER_H
+
+#include <ostream>
+
+namespace jb_storage
+{
+
+	// Spans of operations (path parsing, every level of traversal, lock waits, value copies, mount
+	// resolution, Save and Load) kept in per-thread ring buffers, the latest 16384 per thread; the buffer of a
+	// finished thread is taken over by the next one to start, under the same thread id. Exists only
+	// when built with STORAGE_TRACING and records nothing until enabled. Dump() writes what the buffers
+	// hold in Chrome trace event format, to be opened with chrome://tracing or Perfetto; it doesn't block
+	// the threads being traced.
+	class Tracer final
+	{
+	public:
+		static bool IsAvailable() noexcept;
+
+		static void Enable(const bool enable = true) noexcept;
+
+		static void Dump(std::ostream& os);
+
+		static void Reset();
+	};
+
+}
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef STORAGE_TRANSACTION_H
+#define STORAGE_TRANSACTION_H
+
+#include "Common.h"
+
+#include <memory>
+#include <optional>
+#include <string_view>
+
+namespace jb_storage
+{
+
+	struct ITransaction;
+
+	// Reads and writes of several paths of Volume or Storage applied all at once. Writes are buffered until
+	// Commit(), which locks only the nodes read and the ones the writes land on, checks that nothing read has
+	// changed since and applies the writes, as if the whole transaction took place at that moment; so
+	// transactions touching different nodes commit in parallel. Reads see the transaction's own writes.
+	// A transaction is not meant to be shared between threads.
+	class Transaction final
+	{
+		friend class Storage;
+		friend class Volume;
+
+	private:
+		std::unique_ptr<ITransaction>	_impl;
+
+	public:
+		Transaction(Transaction&&) noexcept;
+		Transaction& operator = (Transaction&&) noexcept;
+		~Transaction();
+
+		std::optional<Value> Get(const std::string_view path);
+
+		// false for a malformed path only, the outcome is known on commit
+		bool SetOrInsert(const std::string_view path, Value value);
+		bool Delete(const std::string_view path);
+
+		// False if something read was changed or deleted by someone else meanwhile, or the writes can't be
+		// applied (a path in Storage leads to no mounted volume, or the owner is gone); nothing is written
+		// then. Either way the transaction is empty afterwards and may be reused to retry.
+		bool Commit();
+
+	private:
+		explicit Transaction(std::unique_ptr<ITransaction>&& impl) noexcept;
+	};
+
+}
+
+#endif
@@ -1,11 +1,19 @@
 #ifndef STORAGE_VOLUME_H
 #define STORAGE_VOLUME_H
 
+#include "Handle.h"
 #include "IStorage.h"
+#include "Snapshot.h"
+#include "Stats.h"
+#include "Transaction.h"
 
+#include <chrono>
+#include <future>
 #include <istream>
 #include <memory>
 #include <ostream>
+#include <string>
+#include <vector>
 
 namespace jb_storage
 {
@@ -15,6 +23,7 @@ namespace jb_storage
 	class Volume final : public IStorage
 	{
 		friend class Storage;
+		friend class VolumeBuilder;
 
 	private:
 		std::shared_ptr<VolumeImpl>	_impl;
@@ -27,8 +36,108 @@ namespace jb_storage
 		bool SetOrInsert(const std::string_view path, Value&& value) const override;
 		bool Delete(const std::string_view path) const override;
 
+		std::optional<Value> Get(const PathSegments path) const override;
+		bool SetOrInsert(const PathSegments path, const Value& value) const override;
+		bool SetOrInsert(const PathSegments path, Value&& value) const override;
+		bool Delete(const PathSegments path) const override;
+
+		// SetOrInsert() with the node reading as missing from ttl from now on (steady clock, not saved);
+		// setting it again without a ttl keeps it for good. False for the root.
+		bool SetOrInsert(const std::string_view path, Value value, const std::chrono::milliseconds ttl) const;
+
+		// Atomic updates of an integer value: the node is locked shared only and the value is changed with
+		// a hardware atomic, so that concurrent updates of a counter don't serialize on its lock. Both fail,
+		// returning false and nothing respectively, if there's no such node or its value is of another type;
+		// FetchAdd() wraps around and returns the value before the addition.
+		bool CompareAndSwap(const std::string_view path, const uint32_t expected, const uint32_t desired) const;
+		bool CompareAndSwap(const std::string_view path, const uint64_t expected, const uint64_t desired) const;
+		std::optional<uint32_t> FetchAdd(const std::string_view path, const uint32_t delta) const;
+		std::optional<uint64_t> FetchAdd(const std::string_view path, const uint64_t delta) const;
+
+		// Names of the children of the node at path in key order, nothing if there's no such node. At most limit
+		// names are returned (0 means no limit), starting after the given one; to page through a wide node,
+		// pass the last name of a page as after for the next one.
+		std::optional<std::vector<std::string>> List(const std::string_view path, const size_t limit = 0, const std::string_view after = { }) const;
+
+		// Streams the subtree under path, not including the node itself, depth first with children in key order,
+		// until the callback returns false. Returns a resume token, the path of the last visited node relative
+		// to the scanned one, to be passed to the next call to carry on; empty once the whole subtree is visited.
+		// Memory used is bounded by the depth of the subtree and only one node is locked at a time, so the tree
+		// may change meanwhile: nodes added or deleted concurrently may be visited or not.
+		std::string Scan(const std::string_view path, const ScanCallback& callback, const std::string_view resume = { }) const;
+
+		// Calls back for every node below the root whose path matches the pattern, where "*" stands for any
+		// single segment, "**" for any number of them (none included) and '*' within a segment for any run
+		// of characters, e.g. "/shards/*/stats/qps" or "/**/qps". Matches are expanded in a single traversal,
+		// independent subtrees in parallel, and reported as they're found, in no particular order: one call
+		// at a time, but from any thread. Returning false from the callback stops the query. Returns the
+		// number of matches reported.
+		size_t Glob(const std::string_view pattern, const ScanCallback& callback) const;
+
+		// Reduces the numeric values of the subtree under path, the node itself included, in double precision;
+		// values of other types are skipped. Nothing if there's no such node, or for Min and Max if there are
+		// no numeric values. Values are read in place rather than copied out, and large subtrees are reduced
+		// in parallel; nodes are locked one at a time, so concurrent changes may or may not be seen.
+		std::optional<double> Aggregate(const std::string_view path, const Aggregation aggregation) const;
+
+		// Totals of the subtree under path, nothing if there's no such node; they are kept up to date by every
+		// change, so this costs a lookup of the path only
+		std::optional<Usage> GetUsage(const std::string_view path) const;
+
+		// Moves the subtree under from over to to, in constant time whatever its size: the node is relinked
+		// from one parent to the other with both locked, so that it's found at either path at any moment and
+		// a snapshot sees it at one of them. Fails if either path is the root, there's no node at from, to
+		// has no parent or is taken already, or it lies within from.
+		bool Rename(const std::string_view from, const std::string_view to) const;
+
+		// Rename() into another volume, the nodes handed over as they are; fails if either volume is frozen
+		// or this one is a clone, whose nodes are tied to the volume it's cloned from.
+		bool Move(const std::string_view from, const Volume& target, const std::string_view to) const;
+
+		Handle Open(const std::string_view path) const;
+
+		Transaction BeginTransaction() const;
+
+		// consistent view of the whole volume at this moment, see jb_storage::Snapshot
+		jb_storage::Snapshot Snapshot() const;
+
+		// independent copy of the volume as of this moment, made in constant time and copying nodes on first
+		// touch; it isn't mounted anywhere, has statistics off and asynchronous concurrency unlimited
+		Volume Clone() const;
+
+		// read-only copy of the volume as of this moment, packed into a few arrays read without locks and
+		// made in linear time; writes to it fail, transactions on it never commit
+		Volume Freeze() const;
+
 		bool Load(std::istream& is) const;
 		bool Save(std::ostream& os) const;
+
+		// Asynchronous counterparts run in the library's thread pool; streams passed to LoadAsync()
+		// and SaveAsync() must stay alive until the returned future is ready
+		std::future<std::optional<Value>> GetAsync(const std::string_view path) const;
+		std::future<bool> SetOrInsertAsync(const std::string_view path, Value value) const;
+		std::future<bool> DeleteAsync(const std::string_view path) const;
+		std::future<bool> LoadAsync(std::istream& is) const;
+		std::future<bool> SaveAsync(std::ostream& os) const;
+
+		// caps the number of asynchronous operations on this volume running at once, 0 means no limit
+		void SetAsyncConcurrency(const size_t limit) const;
+
+		// strings and blobs of at least min_size bytes set through SetOrInsert() from now on are kept once per
+		// distinct content, 0 (the default) turns it off
+		void SetDedupThreshold(const size_t min_size) const;
+
+		// keeps the volume within about budget bytes by spilling cold subtrees to a file at path, in the
+		// background, read back on touch; 0 turns it off. False for frozen volumes and clones, or if the file
+		// can't be made
+		bool SetMemoryBudget(const size_t budget, const std::string& path) const;
+
+		// statistics are off by default; turning them off keeps what has been counted so far
+		void EnableStats(const bool enable = true) const;
+		Stats GetStats() const;
+
+	private:
+		explicit Volume(std::shared_ptr<VolumeImpl>&& impl) noexcept;
 	};
 
 }
@@ -0,0 +1,129 @@
+#include "Aggregation.h"
+
+#include <algorithm>
+
+namespace jb_storage::utility
+{
+
+	namespace
+	{
+
+		// enough independent accumulators to fill a couple of vector registers of any width in use
+		constexpr size_t Lanes{ 8 };
+
+	}
+
+	void NumericAccumulator::Merge(NumericAccumulator& other) noexcept
+	{
+		Flush();
+		other.Flush();
+
+		_count += other._count;
+		_sum += other._sum;
+		_min = std::min(_min, other._min);
+		_max = std::max(_max, other._max);
+
+		AddIntegerSum(other._integer_sum, other._integer_carry);
+		_integer_min = std::min(_integer_min, other._integer_min);
+		_integer_max = std::max(_integer_max, other._integer_max);
+	}
+
+	std::optional<double> NumericAccumulator::GetResult(const Aggregation aggregation) noexcept
+	{
+		Flush();
+
+		// the bounds of no integers at all are crossed
+		const bool integers{ _integer_min <= _integer_max };
+
+		switch (aggregation)
+		{
+		case Aggregation::Count:
+			return static_cast<double>(_count);
+
+		case Aggregation::Sum:
+			return static_cast<double>(_integer_carry) * 18446744073709551616. + static_cast<double>(_integer_sum) + _sum;
+
+		case Aggregation::Min:
+			return _count ? std::optional<double>{ integers ? std::min(_min, static_cast<double>(_integer_min)) : _min } : std::nullopt;
+
+		case Aggregation::Max:
+			return _count ? std::optional<double>{ integers ? std::max(_max, static_cast<double>(_integer_max)) : _max } : std::nullopt;
+		}
+
+		return std::nullopt;
+	}
+
+	void NumericAccumulator::FlushReals() noexcept
+	{
+		// every lane reduces its own stride of the batch, which breaks the dependency chain of a single
+		// accumulator and lets the lanes be vectorized without reassociating floating point additions
+		std::array<double, Lanes> sum{ }, min, max;
+		min.fill(_min);
+		max.fill(_max);
+
+		size_t i{ 0 };
+		for (; i + Lanes <= _size; i += Lanes)
+			for (size_t lane{ 0 }; lane < Lanes; ++lane)
+			{
+				const double value{ _batch[i + lane] };
+				sum[lane] += value;
+				min[lane] = value < min[lane] ? value : min[lane];
+				max[lane] = value > max[lane] ? value : max[lane];
+			}
+
+		for (; i < _size; ++i)
+		{
+			sum[0] += _batch[i];
+			min[0] = std::min(min[0], _batch[i]);
+			max[0] = std::max(max[0], _batch[i]);
+		}
+
+		for (size_t lane{ 0 }; lane < Lanes; ++lane)
+		{
+			_sum += sum[lane];
+			_min = std::min(_min, min[lane]);
+			_max = std::max(_max, max[lane]);
+		}
+
+		_count += _size;
+		_size = 0;
+	}
+
+	// the same over integers, every lane counting the times its sum wraps around
+	void NumericAccumulator::FlushIntegers() noexcept
+	{
+		std::array<uint64_t, Lanes> sum{ }, carry{ }, min, max;
+		min.fill(_integer_min);
+		max.fill(_integer_max);
+
+		size_t i{ 0 };
+		for (; i + Lanes <= _integer_size; i += Lanes)
+			for (size_t lane{ 0 }; lane < Lanes; ++lane)
+			{
+				const uint64_t value{ _integers[i + lane] };
+				sum[lane] += value;
+				carry[lane] += sum[lane] < value;
+				min[lane] = value < min[lane] ? value : min[lane];
+				max[lane] = value > max[lane] ? value : max[lane];
+			}
+
+		for (; i < _integer_size; ++i)
+		{
+			sum[0] += _integers[i];
+			carry[0] += sum[0] < _integers[i];
+			min[0] = std::min(min[0], _integers[i]);
+			max[0] = std::max(max[0], _integers[i]);
+		}
+
+		for (size_t lane{ 0 }; lane < Lanes; ++lane)
+		{
+			AddIntegerSum(sum[lane], carry[lane]);
+			_integer_min = std::min(_integer_min, min[lane]);
+			_integer_max = std::max(_integer_max, max[lane]);
+		}
+
+		_count += _integer_size;
+		_integer_size = 0;
+	}
+
+}
@@ -0,0 +1,89 @@
+#ifndef STORAGE_AGGREGATION_H
+#define STORAGE_AGGREGATION_H
+
+#include "Atomic.h"
+#include "Common.h"
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <type_traits>
+
+namespace jb_storage::utility
+{
+
+	// Numeric values are gathered into a contiguous batch as they're met and the batch is reduced at once
+	// when full, by a kernel the compiler maps onto vector instructions. Integers have a batch of their own,
+	// summed exactly with the carry out of 64 bits, so that those past 2^53 are rounded once, in the result.
+	class NumericAccumulator final
+	{
+	public:
+		static constexpr size_t BatchSize{ 512 };
+
+	private:
+		std::array<double, BatchSize>	_batch;
+		size_t							_size{ 0 };
+		std::array<uint64_t, BatchSize>	_integers;
+		size_t							_integer_size{ 0 };
+
+		uint64_t						_count{ 0 };
+		double							_sum{ 0 };
+		double							_min{ std::numeric_limits<double>::infinity() };
+		double							_max{ -std::numeric_limits<double>::infinity() };
+
+		uint64_t						_integer_sum{ 0 };
+		uint64_t						_integer_carry{ 0 };	// times the sum wrapped around
+		uint64_t						_integer_min{ std::numeric_limits<uint64_t>::max() };
+		uint64_t						_integer_max{ 0 };
+
+	public:
+		// values of other types are skipped
+		void Add(const Value& value) noexcept
+		{
+			std::visit([this](const auto& value)
+			{
+				using Type = std::decay_t<decltype(value)>;
+
+				if constexpr (std::is_integral_v<Type>)
+					Add(static_cast<uint64_t>(AtomicLoad(value)));
+				else if constexpr (std::is_arithmetic_v<Type>)
+					Add(static_cast<double>(value));
+			}, value);
+		}
+
+		void Add(const double value) noexcept
+		{
+			_batch[_size++] = value;
+
+			if (_size == BatchSize)
+				FlushReals();
+		}
+
+		void Add(const uint64_t value) noexcept
+		{
+			_integers[_integer_size++] = value;
+
+			if (_integer_size == BatchSize)
+				FlushIntegers();
+		}
+
+		void Merge(NumericAccumulator& other) noexcept;
+
+		std::optional<double> GetResult(const Aggregation aggregation) noexcept;
+
+	private:
+		void Flush() noexcept { FlushReals(); FlushIntegers(); }
+		void FlushReals() noexcept;
+		void FlushIntegers() noexcept;
+
+		void AddIntegerSum(const uint64_t sum, const uint64_t carry) noexcept
+		{
+			_integer_sum += sum;
+			_integer_carry += carry + (_integer_sum < sum);
+		}
+	};
+
+}
+
+#endif
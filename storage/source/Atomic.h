@@ -0,0 +1,64 @@
+#ifndef STORAGE_ATOMIC_H
+#define STORAGE_ATOMIC_H
+
+#include "Common.h"
+
+#include <type_traits>
+
+#if __cplusplus > 201703L && __has_include(<version>)
+#include <version>
+#endif
+
+#ifdef __cpp_lib_atomic_ref
+#include <atomic>
+#endif
+
+namespace jb_storage::utility
+{
+
+	// Atomic access to plain integers, namely the integer alternatives of a Value, which CompareAndSwap() and
+	// FetchAdd() update in place with the node locked shared only: whoever reads those under a shared lock
+	// does it through these as well.
+#if defined(__cpp_lib_atomic_ref)
+	template < typename T >
+	T AtomicLoad(const T& value) noexcept
+	{ return std::atomic_ref<T>{ const_cast<T&>(value) }.load(std::memory_order_relaxed); }
+
+	template < typename T >
+	bool AtomicCompareExchange(T& value, T& expected, const T desired) noexcept
+	{ return std::atomic_ref<T>{ value }.compare_exchange_strong(expected, desired, std::memory_order_acq_rel, std::memory_order_acquire); }
+
+	template < typename T >
+	T AtomicFetchAdd(T& value, const T delta) noexcept
+	{ return std::atomic_ref<T>{ value }.fetch_add(delta, std::memory_order_acq_rel); }
+#elif defined(__GNUC__)
+	template < typename T >
+	T AtomicLoad(const T& value) noexcept
+	{ return __atomic_load_n(&value, __ATOMIC_RELAXED); }
+
+	template < typename T >
+	bool AtomicCompareExchange(T& value, T& expected, const T desired) noexcept
+	{ return __atomic_compare_exchange_n(&value, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE); }
+
+	template < typename T >
+	T AtomicFetchAdd(T& value, const T delta) noexcept
+	{ return __atomic_fetch_add(&value, delta, __ATOMIC_ACQ_REL); }
+#else
+#error No atomic access to plain integers
+#endif
+
+	// copy of a value whose integer alternatives may be updated meanwhile
+	inline Value LoadValue(const Value& value)
+	{
+		if (const auto integer{ std::get_if<uint64_t>(&value) })
+			return Value{ AtomicLoad(*integer) };
+
+		if (const auto integer{ std::get_if<uint32_t>(&value) })
+			return Value{ AtomicLoad(*integer) };
+
+		return value;
+	}
+
+}
+
+#endif
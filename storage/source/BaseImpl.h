@@ -1,60 +1,570 @@
 #ifndef STORAGE_BASEIMPL_H
 #define STORAGE_BASEIMPL_H
 
+#include "Aggregation.h"
+#include "Atomic.h"
+#include "GlobPattern.h"
 #include "INode.h"
 #include "PathView.h"
+#include "ProfiledLock.h"
+#include "Reclaimer.h"
+#include "ThreadPool.h"
+#include "Tracing.h"
 
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
 #include <mutex>
 #include <shared_mutex>
+#include <string>
+#include <tuple>
 #include <utility>
+#include <vector>
 
 namespace jb_storage
 {
 
+	// NodeType is either INode (polymorphic traversal, used where nodes of different kinds meet)
+	// or a final node class, so that every GetChild/lock call along the path is resolved statically
+	template < typename NodeType >
 	class BaseImpl
 	{
+	protected:
+		using NodePtr = std::shared_ptr<NodeType>;
+
 	private:
-		INodePtr	_root;
+		NodePtr	_root;
 
 	public:
-		std::optional<Value> Get(const std::string_view path) const;
-		bool Delete(const std::string_view path) const;
-		bool SetOrInsert(const std::string_view path, Value&& value) const;
+		std::optional<Value> Get(const utility::PathView& path) const
+		{
+			STORAGE_TRACE_SPAN("Get");
+
+			if (const NodePtr node{ GetNode(path) })
+			{
+				utility::SharedLock lock{ *node, path, path.GetDepth() };
+				STORAGE_TRACE_SPAN("copy value", path.GetDepth());
+				return node->GetValue();
+			}
+
+			return std::nullopt;
+		}
+
+		bool Delete(const utility::PathView& path) const
+		{
+			STORAGE_TRACE_SPAN("Delete");
+
+			if (!path.GetDepth())
+				return false;
+
+			NodePtr parent;
+			NodePtr current{ _root };
+			std::string_view key_name;
+			size_t depth{ 0 };
+
+			for (auto key{ path.begin() }, end{ path.end() }; key != end && current; ++key)
+			{
+				STORAGE_TRACE_SPAN("traverse", depth);
+				utility::SharedLock lock{ *current, path, depth++ };
+				parent = current;
+				current = current->FindChild(key_name = *key);
+			}
+
+			if (!current)
+				return false;
+
+			current.reset();
+
+			INodePtr detached;
+			{
+				STORAGE_TRACE_SPAN("detach", path.GetDepth() - 1);
+				utility::UniqueLock lock{ *parent, path, path.GetDepth() - 1 };
+				detached = parent->DetachChild(key_name);
+			}
+
+			if (!detached)
+				return false;
+
+			utility::Reclaimer::Instance().Retire(std::move(detached));
+
+			return true;
+		}
+
+		bool SetOrInsert(const utility::PathView& path, Value&& value) const
+		{
+			STORAGE_TRACE_SPAN("SetOrInsert");
+
+			return GrowBranchAndSetValue(
+					_root,
+					path,
+					[](const NodePtr& node, const std::string_view name) { return node->FindChild(name); },
+					[&value](const NodePtr& node, const utility::PathView& path) { return node->GrowBranchAndSetValue(path, std::move(value)); });
+		}
+
+		template < typename Integer >
+		bool CompareAndSwap(const utility::PathView& path, const Integer expected, const Integer desired) const
+		{
+			STORAGE_TRACE_SPAN("CompareAndSwap");
+
+			return UpdateValue(path, [expected, desired](Value& value)
+			{
+				Integer* const integer{ std::get_if<Integer>(&value) };
+				Integer current{ expected };
+
+				return integer && utility::AtomicCompareExchange(*integer, current, desired);
+			});
+		}
+
+		template < typename Integer >
+		std::optional<Integer> FetchAdd(const utility::PathView& path, const Integer delta) const
+		{
+			STORAGE_TRACE_SPAN("FetchAdd");
+
+			std::optional<Integer> previous;
+			UpdateValue(path, [delta, &previous](Value& value)
+			{
+				if (Integer* const integer{ std::get_if<Integer>(&value) })
+					previous = utility::AtomicFetchAdd(*integer, delta);
+
+				return previous.has_value();
+			});
+
+			return previous;
+		}
+
+		std::optional<std::vector<std::string>> List(const utility::PathView& path, const size_t limit, const std::string_view after) const
+		{
+			const NodePtr node{ GetNode(path) };
+			if (!node)
+				return std::nullopt;
+
+			Children children;
+			{
+				utility::SharedLock lock{ *node, path, path.GetDepth() };
+				node->ListChildren(after, limit ? limit : std::numeric_limits<size_t>::max(), children);
+			}
+
+			std::vector<std::string> names;
+			names.reserve(children.size());
+
+			for (auto& child : children)
+				names.push_back(std::move(child.first));
+
+			return names;
+		}
+
+		std::string Scan(const utility::PathView& path, const ScanCallback& callback, const std::string_view resume) const
+		{
+			const NodePtr root{ GetNode(path) };
+			if (!root)
+				return { };
+
+			return ScanFrom(root, callback, resume, LiveAccess{ });
+		}
+
+		// Independent subtrees are expanded by tasks of the thread pool while the caller helps running them
+		size_t Glob(const utility::PathView& pattern, const ScanCallback& callback) const
+		{
+			const auto query{ std::make_shared<GlobQuery>(pattern, callback) };
+
+			Expand(query, _root, { }, query->Pattern.GetInitialStates());
+			query->Group.Wait();
+
+			return query->Matches;
+		}
+
+		std::optional<double> Aggregate(const utility::PathView& path, const Aggregation aggregation) const
+		{
+			const NodePtr root{ GetNode(path) };
+			if (!root)
+				return std::nullopt;
+
+			const auto query{ std::make_shared<AggregateQuery>() };
+
+			Reduce(query, { root });
+			query->Group.Wait();
+
+			return query->Total.GetResult(aggregation);
+		}
+
+		std::optional<Usage> GetUsage(const utility::PathView& path) const
+		{
+			if (const NodePtr node{ GetNode(path) })
+			{
+				utility::SharedLock lock{ *node, path, path.GetDepth() };
+				return node->GetUsage();
+			}
+
+			return std::nullopt;
+		}
 
 	protected:
-		explicit BaseImpl(const INodePtr& root) noexcept : _root{ root } { }
+		using Children = std::vector<std::pair<std::string, NodePtr>>;
+
+		// the value is updated with the node locked shared, as for reading, so that updates of a hot counter
+		// don't wait for each other; exclusively only if it's to be kept for a snapshot first
+		bool UpdateValue(const utility::PathView& path, const std::function<bool(Value&)>& update) const
+		{
+			const NodePtr node{ GetNode(path) };
+			if (!node)
+				return false;
+
+			{
+				utility::SharedLock lock{ *node, path, path.GetDepth() };
+				if (const auto updated{ node->UpdateValue(update, false) })
+					return *updated;
+			}
+
+			utility::UniqueLock lock{ *node, path, path.GetDepth() };
+			return node->UpdateValue(update, true).value_or(false);
+		}
+
+		explicit BaseImpl(const NodePtr& root) noexcept : _root{ root } { }
+
+		// how ScanFrom() reads the tree as it is, each node under its own lock
+		struct LiveAccess
+		{
+			NodePtr GetChild(const NodePtr& node, const std::string_view name) const
+			{
+				std::shared_lock lock{ *node };
+				return node->FindChild(name);
+			}
+
+			// nothing is listed of a deleted node, so that a scan doesn't go on in a subtree that's gone
+			void ListChildren(const NodePtr& node, const std::string_view after, const size_t limit, Children& children) const
+			{
+				if (node->IsDetached())
+					return;
+
+				std::shared_lock lock{ *node };
+				node->ListChildren(after, limit, children);
+			}
+
+			std::optional<Value> GetValue(const NodePtr& node) const
+			{
+				std::shared_lock lock{ *node };
+				return node->GetValue();
+			}
+		};
+
+		// Depth first, children in key order. Children are fetched by pages, so that memory is bounded
+		// by the depth rather than by the width of the subtree; nodes are read through access (see
+		// LiveAccess), which holds a node's lock only while a page of its children or its value is copied,
+		// the callback is called with no lock held.
+		template < typename Access >
+		static std::string ScanFrom(const NodePtr& root, const ScanCallback& callback, const std::string_view resume, const Access& access)
+		{
+			static constexpr size_t PageSize{ 64 };
+
+			struct Frame
+			{
+				NodePtr			Node;
+				std::string		Path;
+				std::string		After;
+				Children		Page;
+				size_t			Next{ 0 };
+				bool			Exhausted{ false };
+			};
+
+			std::vector<Frame> stack;
+			stack.push_back(Frame{ root, { }, { }, { } });
+
+			// the resume token leads down to the last visited node: its children go next, then its
+			// following siblings and so on; nodes deleted since then are skipped over the same way
+			if (!resume.empty())
+				for (const auto& key : utility::PathView{ resume })
+				{
+					Frame& top{ stack.back() };
+					top.After = key;
 
-		INodePtr GetNode(const std::string_view path) const;
+					NodePtr child{ access.GetChild(top.Node, key) };
+					if (!child)
+						break;
+
+					stack.push_back(Frame{ std::move(child), top.Path + '/' + std::string{ key }, { }, { } });
+				}
+
+			while (!stack.empty())
+			{
+				Frame& top{ stack.back() };
+
+				if (top.Next == top.Page.size())
+				{
+					top.Page.clear();
+					top.Next = 0;
+
+					if (!top.Exhausted)
+						access.ListChildren(top.Node, top.After, PageSize, top.Page);
+
+					if (top.Page.empty())
+					{
+						stack.pop_back();
+						continue;
+					}
+
+					top.Exhausted = top.Page.size() < PageSize;
+					top.After = top.Page.back().first;
+				}
+
+				auto& [name, child] = top.Page[top.Next++];
+				std::string child_path{ top.Path + '/' + name };
+
+				const auto value{ access.GetValue(child) };
+				if (!callback(child_path, value ? *value : Value{ }))
+					return child_path;
+
+				stack.push_back(Frame{ std::move(child), std::move(child_path), { }, { } });
+			}
+
+			return { };
+		}
+
+		NodePtr GetNode(const utility::PathView& path) const
+		{
+			NodePtr current{ _root };
+			size_t depth{ 0 };
+
+			// the node stays pinned while locked, since a concurrent delete may leave current the only owner
+			for (auto key{ path.begin() }, end{ path.end() }; key != end && current; ++key)
+			{
+				STORAGE_TRACE_SPAN("traverse", depth);
+				const NodePtr node{ std::move(current) };
+				utility::SharedLock lock{ *node, path, depth++ };
+				current = node->FindChild(*key);
+			}
+
+			return current;
+		}
+
+		// every node from the root down to the one the path points to, empty if there's no such node
+		std::vector<NodePtr> GetBranch(const utility::PathView& path) const
+		{
+			auto branch{ GetExistingBranch(path) };
+			if (branch.size() != path.GetDepth() + 1)
+				return { };
+
+			return branch;
+		}
+
+		// nodes from the root down along the path for as long as they exist, and the times each had been moved
+		// once reached, if asked for (see INode::GetMoves())
+		std::vector<NodePtr> GetExistingBranch(const utility::PathView& path, std::vector<uint32_t>* const moves = nullptr) const
+		{
+			std::vector<NodePtr> branch{ _root };
+			branch.reserve(path.GetDepth() + 1);
+
+			if (moves)
+				moves->assign(1, _root->GetMoves());
+
+			for (const auto& key : path)
+			{
+				STORAGE_TRACE_SPAN("traverse", branch.size() - 1);
+				const NodePtr current{ branch.back() };
+				utility::SharedLock lock{ *current, path, branch.size() - 1 };
+
+				NodePtr child{ current->FindChild(key) };
+				if (!child)
+					break;
+
+				if (moves)
+					moves->push_back(child->GetMoves());
+
+				branch.push_back(std::move(child));
+			}
+
+			return branch;
+		}
+
+	private:
+		struct GlobQuery
+		{
+			const utility::GlobPattern	Pattern;
+			const ScanCallback&			Callback;
+			utility::TaskGroup			Group;			// cancelled once the callback asks to stop
+
+			std::mutex					Lock;			// serializes the callback
+			size_t						Matches{ 0 };
+
+			GlobQuery(const utility::PathView& pattern, const ScanCallback& callback)
+				: Pattern{ pattern }, Callback{ callback }
+			{ }
+
+			void Report(const std::string& path, const Value& value)
+			{
+				std::lock_guard lock{ Lock };
+				if (Group.IsCancelled())
+					return;
+
+				++Matches;
+				if (!Callback(path, value))
+					Group.Cancel();
+			}
+		};
+
+		using GlobQueryPtr = std::shared_ptr<GlobQuery>;
 
+		// goes down one child inline and hands its siblings over to the pool
+		static void Expand(const GlobQueryPtr& query, NodePtr node, std::string path, utility::GlobPattern::States states)
+		try
+		{
+			static constexpr size_t PageSize{ 256 };
+
+			const utility::GlobPattern& pattern{ query->Pattern };
+
+			while (node && !query->Group.IsCancelled())
+			{
+				Children candidates;
+
+				if (const auto literals{ pattern.GetLiterals(states) })
+				{
+					std::shared_lock lock{ *node };
+
+					for (const auto& literal : *literals)
+						if (NodePtr child{ node->FindChild(literal) })
+							candidates.emplace_back(literal, std::move(child));
+				}
+				else
+				{
+					// wide nodes are listed page by page so that writers get their turn
+					for (std::string after; ; after = candidates.back().first)
+					{
+						const auto listed{ candidates.size() };
+						{
+							std::shared_lock lock{ *node };
+							node->ListChildren(after, PageSize, candidates);
+						}
+
+						if (candidates.size() - listed < PageSize)
+							break;
+					}
+				}
+
+				std::vector<std::tuple<NodePtr, std::string, utility::GlobPattern::States>> descend;
+
+				for (auto& [name, child] : candidates)
+				{
+					auto next{ pattern.Step(states, name) };
+					if (next.empty())
+						continue;
+
+					std::string child_path{ path + '/' + name };
+
+					if (pattern.IsAccepting(next))
+					{
+						std::optional<Value> value;
+						{
+							std::shared_lock lock{ *child };
+							value = child->GetValue();
+						}
+
+						query->Report(child_path, value ? *value : Value{ });
+					}
+
+					if (pattern.CanGoDeeper(next))
+						descend.emplace_back(std::move(child), std::move(child_path), std::move(next));
+				}
+
+				if (descend.empty())
+					break;
+
+				for (size_t i{ 0 }, last{ descend.size() - 1 }; i < last; ++i)
+					query->Group.Submit([query, subtree = std::move(descend[i])]() mutable
+					{
+						auto& [node, path, states] = subtree;
+						Expand(query, std::move(node), std::move(path), std::move(states));
+					});
+
+				std::tie(node, path, states) = std::move(descend.back());
+			}
+		}
+		catch (...)
+		{ query->Group.Fail(std::current_exception()); }
+
+		struct AggregateQuery
+		{
+			utility::TaskGroup			Group;
+
+			std::mutex					Lock;
+			utility::NumericAccumulator	Total;
+		};
+
+		using AggregateQueryPtr = std::shared_ptr<AggregateQuery>;
+
+		// depth first over a stack of its own; once the stack grows while the pool has hands to spare, its
+		// bottom half, closer to the root and so likely the bigger share of the work, goes to another task
+		static void Reduce(const AggregateQueryPtr& query, std::vector<NodePtr> stack)
+		try
+		{
+			static constexpr size_t SplitSize{ 16 };
+
+			const size_t max_pending{ utility::ThreadPool::Instance().GetConcurrency() * 2 };
+
+			utility::NumericAccumulator accumulator;
+
+			while (!stack.empty() && !query->Group.IsCancelled())
+			{
+				const NodePtr node{ std::move(stack.back()) };
+				stack.pop_back();
+
+				{
+					std::shared_lock lock{ *node };
+
+					if (const Value* const value{ node->PeekValue() })
+						accumulator.Add(*value);
+
+					node->CollectChildren(stack);
+				}
+
+				if (stack.size() >= SplitSize && query->Group.GetPending() < max_pending)
+				{
+					const auto half{ stack.begin() + stack.size() / 2 };
+					std::vector<NodePtr> shared{ std::make_move_iterator(stack.begin()), std::make_move_iterator(half) };
+					stack.erase(stack.begin(), half);
+
+					query->Group.Submit([query, shared = std::move(shared)]() mutable { Reduce(query, std::move(shared)); });
+				}
+			}
+
+			std::lock_guard lock{ query->Lock };
+			query->Total.Merge(accumulator);
+		}
+		catch (...)
+		{ query->Group.Fail(std::current_exception()); }
+
+	protected:
 		template < typename NodePointerType, typename LockAdaptor = typename NodePointerType::element_type, typename ChildGetter, typename ValueSetter >
 		static bool GrowBranchAndSetValue(
 				const NodePointerType& root,
-				const std::string_view path_,
+				const utility::PathView& path,
 				ChildGetter&& child_getter,
 				ValueSetter&& value_setter)
 		{
-			const utility::PathView path{ path_ };
-
 			NodePointerType current{ root };
-			auto key{ path.begin() };
+			const auto begin{ path.begin() };
 			const auto end{ path.end() };
+			auto key{ begin };
 
 			do
 			{
 				for (; key != end; ++key)
 				{
-					std::shared_lock lock{ *current };
-					if (const NodePointerType child{ child_getter(current, *key) })
-						current = child;
+					STORAGE_TRACE_SPAN("traverse", static_cast<size_t>(key - begin));
+					const NodePointerType node{ current };
+					utility::SharedLock lock{ *node, path, static_cast<size_t>(key - begin) };
+					if (NodePointerType child{ child_getter(node, *key) })
+						current = std::move(child);
 					else
 						break;
 				}
 
-				std::unique_lock lock{ static_cast<LockAdaptor&>(*current) };
+				utility::UniqueLock lock{ static_cast<LockAdaptor&>(*current), path, static_cast<size_t>(key - begin) };
 
 				if (key != end && child_getter(current, *key))
 					continue;
 
+				STORAGE_TRACE_SPAN("grow branch", static_cast<size_t>(key - begin));
 				return value_setter(current, path.GetRest(key));
 			}
 			while (key != end);
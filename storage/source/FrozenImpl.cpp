@@ -0,0 +1,404 @@
+#include "FrozenImpl.h"
+
+#include "Aggregation.h"
+#include "GlobPattern.h"
+#include "Metrics.h"
+#include "Serialization.h"
+#include "SnapshotClock.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <mutex>
+#include <tuple>
+
+namespace jb_storage
+{
+
+	FrozenImpl::Node::Node(Node&& other) noexcept
+		: _owner{ other._owner },
+		_value{ std::move(other._value) },
+		_totals{ other._totals },
+		_name{ other._name },
+		_name_size{ other._name_size },
+		_child_count{ other._child_count },
+		_first_child{ other._first_child }
+	{ }
+
+	INodePtr FrozenImpl::Node::GetChild(const std::string_view name) const
+	{
+		const Node* const child{ _owner->FindChild(*this, name) };
+		return child ? _owner->Share(*child) : nullptr;
+	}
+
+	void FrozenImpl::Node::ListChildren(const std::string_view after, const size_t limit, INodeChildren& children) const
+	{
+		const auto end{ _owner->GetChildrenEnd(*this) };
+		auto child{ _owner->GetChildrenAfter(*this, after) };
+		if (child == end || !limit)
+			return;
+
+		const auto tree{ _owner->shared_from_this() };
+		for (size_t added{ 0 }; child != end && added < limit; ++child, ++added)
+		{
+			const Node& node{ _owner->_nodes[*child] };
+			children.emplace_back(_owner->GetName(node), Share(tree, node));
+		}
+	}
+
+	void FrozenImpl::Node::CollectChildren(std::vector<INodePtr>& children) const
+	{
+		const auto begin{ _owner->GetChildrenAfter(*this, { }) };
+		const auto end{ _owner->GetChildrenEnd(*this) };
+		if (begin == end)
+			return;
+
+		const auto tree{ _owner->shared_from_this() };
+		for (auto child{ begin }; child != end; ++child)
+			children.push_back(Share(tree, _owner->_nodes[*child]));
+	}
+
+	INodePtr FrozenImpl::Node::GetPast(const uint64_t time) const
+	{ return time < _owner->_stamp ? _owner->Share(_owner->_nodes.back()) : nullptr; }
+
+	std::optional<Value> FrozenImpl::Get(const utility::PathView& path) const
+	{
+		if (const Node* const node{ Find(path) })
+			return node->_value;
+
+		return std::nullopt;
+	}
+
+	std::optional<std::vector<std::string>> FrozenImpl::List(const utility::PathView& path, const size_t limit, const std::string_view after) const
+	{
+		const Node* const node{ Find(path) };
+		if (!node)
+			return std::nullopt;
+
+		const auto begin{ GetChildrenAfter(*node, after) };
+		const auto end{ limit ? std::min(begin + limit, GetChildrenEnd(*node)) : GetChildrenEnd(*node) };
+
+		std::vector<std::string> names;
+		names.reserve(end - begin);
+
+		for (auto child{ begin }; child != end; ++child)
+			names.emplace_back(GetName(_nodes[*child]));
+
+		return names;
+	}
+
+	// same order and resume tokens as BaseImpl::ScanFrom(), with no paging needed
+	std::string FrozenImpl::Scan(const utility::PathView& path, const ScanCallback& callback, const std::string_view resume) const
+	{
+		const Node* const root{ Find(path) };
+		if (!root)
+			return { };
+
+		struct Frame
+		{
+			const Node*		Parent;
+			std::string		Path;
+			const size_t*	Next;
+		};
+
+		std::vector<Frame> stack;
+		stack.push_back(Frame{ root, { }, GetChildrenAfter(*root, { }) });
+
+		if (!resume.empty())
+			for (const auto& key : utility::PathView{ resume })
+			{
+				Frame& top{ stack.back() };
+				top.Next = GetChildrenAfter(*top.Parent, key);
+
+				const Node* const child{ FindChild(*top.Parent, key) };
+				if (!child)
+					break;
+
+				stack.push_back(Frame{ child, top.Path + '/' + std::string{ key }, GetChildrenAfter(*child, { }) });
+			}
+
+		while (!stack.empty())
+		{
+			Frame& top{ stack.back() };
+
+			if (top.Next == GetChildrenEnd(*top.Parent))
+			{
+				stack.pop_back();
+				continue;
+			}
+
+			const Node& child{ _nodes[*top.Next++] };
+			std::string child_path{ top.Path + '/' + std::string{ GetName(child) } };
+
+			if (!callback(child_path, child._value))
+				return child_path;
+
+			stack.push_back(Frame{ &child, std::move(child_path), GetChildrenAfter(child, { }) });
+		}
+
+		return { };
+	}
+
+	// there are no locks to spread the work over, so the pattern is matched in a single walk
+	size_t FrozenImpl::Glob(const utility::PathView& pattern, const ScanCallback& callback) const
+	{
+		const utility::GlobPattern glob{ pattern };
+
+		std::vector<std::tuple<const Node*, std::string, utility::GlobPattern::States>> stack;
+		stack.emplace_back(&_nodes.front(), std::string{ }, glob.GetInitialStates());
+
+		size_t matches{ 0 };
+
+		while (!stack.empty())
+		{
+			const Node* node;
+			std::string path;
+			utility::GlobPattern::States states;
+			std::tie(node, path, states) = std::move(stack.back());
+			stack.pop_back();
+
+			const auto visit = [&](const Node& child)
+			{
+				auto next{ glob.Step(states, GetName(child)) };
+				if (next.empty())
+					return true;
+
+				std::string child_path{ path + '/' + std::string{ GetName(child) } };
+
+				if (glob.IsAccepting(next))
+				{
+					++matches;
+					if (!callback(child_path, child._value))
+						return false;
+				}
+
+				if (glob.CanGoDeeper(next))
+					stack.emplace_back(&child, std::move(child_path), std::move(next));
+
+				return true;
+			};
+
+			if (const auto literals{ glob.GetLiterals(states) })
+			{
+				for (const auto& literal : *literals)
+					if (const Node* const child{ FindChild(*node, literal) }; child && !visit(*child))
+						return matches;
+			}
+			else
+				for (auto child{ GetChildrenAfter(*node, { }) }, end{ GetChildrenEnd(*node) }; child != end; ++child)
+					if (!visit(_nodes[*child]))
+						return matches;
+		}
+
+		return matches;
+	}
+
+	// a subtree is a range of nodes, reduced in slices by the thread pool once it's large
+	std::optional<double> FrozenImpl::Aggregate(const utility::PathView& path, const Aggregation aggregation) const
+	{
+		static constexpr size_t SliceSize{ 1 << 16 };
+
+		const Node* const root{ Find(path) };
+		if (!root)
+			return std::nullopt;
+
+		const Node* const end{ root + root->_totals.Nodes + 1 };
+
+		std::mutex lock;
+		utility::NumericAccumulator total;
+		utility::TaskGroup group;
+
+		const auto reduce = [&lock, &total](const Node* begin, const Node* const end)
+		{
+			utility::NumericAccumulator accumulator;
+			for (; begin != end; ++begin)
+				accumulator.Add(begin->_value);
+
+			std::lock_guard guard{ lock };
+			total.Merge(accumulator);
+		};
+
+		const Node* begin{ root };
+		for (; end - begin > static_cast<ptrdiff_t>(SliceSize); begin += SliceSize)
+			group.Submit([&reduce, begin]() { reduce(begin, begin + SliceSize); });
+
+		reduce(begin, end);
+		group.Wait();
+
+		return total.GetResult(aggregation);
+	}
+
+	std::optional<Usage> FrozenImpl::GetUsage(const utility::PathView& path) const
+	{
+		if (const Node* const node{ Find(path) })
+			return node->_totals;
+
+		return std::nullopt;
+	}
+
+	INodePtr FrozenImpl::GetNode(const utility::PathView& path) const
+	{
+		const Node* const node{ Find(path) };
+		return node ? Share(*node) : nullptr;
+	}
+
+	// the nodes are found first, so that the tree is pinned once and only for a branch that's there
+	std::vector<INodePtr> FrozenImpl::GetBranch(const utility::PathView& path) const
+	{
+		std::vector<const Node*> nodes{ &_nodes.front() };
+		nodes.reserve(path.GetDepth() + 1);
+
+		for (const auto& key : path)
+		{
+			const Node* const node{ FindChild(*nodes.back(), key) };
+			if (!node)
+				return { };
+
+			nodes.push_back(node);
+		}
+
+		const auto tree{ shared_from_this() };
+
+		std::vector<INodePtr> branch;
+		branch.reserve(nodes.size());
+		for (const Node* const node : nodes)
+			branch.push_back(Share(tree, *node));
+
+		return branch;
+	}
+
+	// nodes are in the order they're saved in, the empty one at the end aside
+	void FrozenImpl::Save(std::ostream& os) const
+	{
+		for (auto node{ _nodes.begin() }, end{ std::prev(_nodes.end()) }; node != end; ++node)
+		{
+			if (node != _nodes.begin())
+				utility::Serialize(std::string{ GetName(*node) }, os);
+
+			utility::Serialize(node->_value, os);
+			utility::Serialize(static_cast<uint64_t>(node->_child_count), os);
+		}
+	}
+
+	FrozenImpl::FrozenImpl(std::vector<Node>&& nodes, std::vector<size_t>&& children, std::string&& names, const uint64_t stamp) noexcept
+		: _nodes{ std::move(nodes) }, _children{ std::move(children) }, _names{ std::move(names) }, _stamp{ stamp }
+	{
+		for (auto& node : _nodes)
+			node._owner = this;
+	}
+
+	const FrozenImpl::Node* FrozenImpl::Find(const utility::PathView& path) const noexcept
+	{
+		const Node* node{ &_nodes.front() };
+		for (auto key{ path.begin() }, end{ path.end() }; key != end && node; ++key)
+			node = FindChild(*node, *key);
+
+		return node;
+	}
+
+	const FrozenImpl::Node* FrozenImpl::FindChild(const Node& node, const std::string_view name) const noexcept
+	{
+		const auto child{ GetChildrenAfter(node, { }) };
+		const auto end{ GetChildrenEnd(node) };
+		const auto found{ std::lower_bound(child, end, name, [this](const size_t index, const std::string_view name) { return GetName(_nodes[index]) < name; }) };
+
+		return found != end && GetName(_nodes[*found]) == name ? &_nodes[*found] : nullptr;
+	}
+
+	const size_t* FrozenImpl::GetChildrenAfter(const Node& node, const std::string_view after) const noexcept
+	{
+		const auto begin{ _children.data() + node._first_child };
+		if (after.empty())
+			return begin;
+
+		return std::upper_bound(begin, GetChildrenEnd(node), after, [this](const std::string_view after, const size_t index) { return after < GetName(_nodes[index]); });
+	}
+
+	INodePtr FrozenImpl::Share(const Node& node) const
+	{ return Share(shared_from_this(), node); }
+
+	INodePtr FrozenImpl::Share(const std::shared_ptr<const FrozenImpl>& tree, const Node& node)
+	{ return INodePtr{ tree, const_cast<Node*>(&node) }; }
+
+	FrozenImpl::Builder::Builder()
+	{
+		_nodes.emplace_back();
+		_stack.push_back(Frame{ 0, { }, { } });
+	}
+
+	bool FrozenImpl::Builder::Add(const utility::PathView& path, Value&& value)
+	{
+		// the part of the path that's still open, the root aside
+		size_t common{ 0 };
+		auto key{ path.begin() };
+		for (const auto end{ path.end() }; key != end && common + 1 < _stack.size() && *key == GetName(_stack[common + 1]); ++key)
+			++common;
+
+		// the value of an open node is set by the call that opens it, the root's only before anything else
+		if (key == path.end() && (_started || common))
+			return false;
+
+		if (common + 1 < _stack.size() && *key <= GetName(_stack[common + 1]))
+			return false;
+
+		while (_stack.size() > common + 1)
+			Close();
+
+		for (const auto end{ path.end() }; key != end; ++key)
+			Open(*key);
+
+		auto& top{ _stack.back() };
+		top.Totals.ValueBytes += utility::GetValueSize(value);
+		_nodes[top.Index]._value = std::move(value);
+		_started = true;
+
+		return true;
+	}
+
+	std::shared_ptr<const FrozenImpl> FrozenImpl::Builder::Finish()
+	{
+		while (!_stack.empty())
+			Close();
+
+		_nodes.emplace_back();
+
+		const std::shared_ptr<const FrozenImpl> frozen{ new FrozenImpl{ std::move(_nodes), std::move(_children), std::move(_names), utility::SnapshotClock::Instance().GetTime() } };
+		*this = Builder{ };
+
+		return frozen;
+	}
+
+	void FrozenImpl::Builder::Open(const std::string_view name)
+	{
+		const size_t index{ _nodes.size() };
+
+		Node& node{ _nodes.emplace_back() };
+		node._name = _names.size();
+		node._name_size = static_cast<uint32_t>(name.size());
+		_names.append(name);
+
+		_stack.back().Children.push_back(index);
+		_stack.push_back(Frame{ index, { }, { } });
+	}
+
+	// children are laid out once all of them are known, totals go up to the parent
+	void FrozenImpl::Builder::Close()
+	{
+		Frame frame{ std::move(_stack.back()) };
+		_stack.pop_back();
+
+		Node& node{ _nodes[frame.Index] };
+		node._totals = frame.Totals;
+		node._first_child = _children.size();
+		node._child_count = static_cast<uint32_t>(frame.Children.size());
+		_children.insert(_children.end(), frame.Children.begin(), frame.Children.end());
+
+		if (!_stack.empty())
+		{
+			Usage& totals{ _stack.back().Totals };
+			totals.Nodes += frame.Totals.Nodes + 1;
+			totals.KeyBytes += frame.Totals.KeyBytes + node._name_size;
+			totals.ValueBytes += frame.Totals.ValueBytes;
+		}
+	}
+
+}
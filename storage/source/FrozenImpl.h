@@ -0,0 +1,143 @@
+#ifndef STORAGE_FROZENIMPL_H
+#define STORAGE_FROZENIMPL_H
+
+#include "INode.h"
+#include "PathView.h"
+
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace jb_storage
+{
+
+	// Read-only tree packed into arrays: nodes in depth first order, so that a subtree is a range of them,
+	// each with a range of child indices sorted by name, names packed into a single buffer and values kept
+	// in the nodes themselves. Nothing changes once it's built, so reads take no locks and walk the tree by
+	// index rather than through shared pointers. Nodes are INodes as well, for mounts, handles and snapshots,
+	// shared pointers to them owning the whole tree; writes through them fail.
+	class FrozenImpl final : public std::enable_shared_from_this<FrozenImpl>
+	{
+	public:
+		class Builder;
+
+	private:
+		class Node final : public INode
+		{
+			friend class FrozenImpl;
+			friend class Builder;
+
+		private:
+			const FrozenImpl*	_owner{ nullptr };
+			Value				_value;
+			Usage				_totals;
+			size_t				_name{ 0 };			// offset in the names
+			uint32_t			_name_size{ 0 };
+			uint32_t			_child_count{ 0 };
+			size_t				_first_child{ 0 };	// offset in the child indices
+
+		public:
+			Node() = default;
+			Node(Node&& other) noexcept;
+
+			std::optional<Value> GetValue() const override					{ return _value; }
+			const Value* PeekValue() const override							{ return &_value; }
+			bool GrowBranchAndSetValue(const utility::PathView&, Value&&) override	{ return false; }
+			std::optional<bool> UpdateValue(const std::function<bool(Value&)>&, const bool) override	{ return false; }
+
+			INodePtr GetChild(const std::string_view name) const override;
+			INodePtr DetachChild(const std::string_view) override			{ return nullptr; }
+			void ListChildren(const std::string_view after, const size_t limit, INodeChildren& children) const override;
+			void CollectChildren(std::vector<INodePtr>& children) const override;
+			// nothing in a frozen volume is set to expire
+			INodePtr GetChildAsOf(const std::string_view name, const int64_t) const override	{ return GetChild(name); }
+			void ListChildrenAsOf(const std::string_view after, const size_t limit, INodeChildren& children, const int64_t) const override	{ ListChildren(after, limit, children); }
+			Usage GetUsage() const override									{ return _totals; }
+			uint64_t GetVersion() const override							{ return 0; }
+			bool CollectMountedNodes(std::vector<INodePtr>&) const override	{ return false; }
+
+			void lock() override				{ }
+			bool try_lock() override			{ return true; }
+			void unlock() override				{ }
+			void lock_shared() override			{ }
+			bool try_lock_shared() override		{ return true; }
+			void unlock_shared() override		{ }
+
+			INodePtr GetPast(const uint64_t time) const override;
+		};
+
+		std::vector<Node>		_nodes;		// followed by an empty one, for snapshots taken before
+		std::vector<size_t>		_children;
+		std::string				_names;
+		const uint64_t			_stamp;		// time the tree was made at (see SnapshotClock)
+
+	public:
+		std::optional<Value> Get(const utility::PathView& path) const;
+		std::optional<std::vector<std::string>> List(const utility::PathView& path, const size_t limit, const std::string_view after) const;
+		std::string Scan(const utility::PathView& path, const ScanCallback& callback, const std::string_view resume) const;
+		size_t Glob(const utility::PathView& pattern, const ScanCallback& callback) const;
+		std::optional<double> Aggregate(const utility::PathView& path, const Aggregation aggregation) const;
+		std::optional<Usage> GetUsage(const utility::PathView& path) const;
+
+		INodePtr GetNode(const utility::PathView& path) const;
+		// every node from the root down to the one the path points to, empty if there's no such node
+		std::vector<INodePtr> GetBranch(const utility::PathView& path) const;
+
+		// in the format VolumeImpl::Load() reads
+		void Save(std::ostream& os) const;
+
+	private:
+		FrozenImpl(std::vector<Node>&& nodes, std::vector<size_t>&& children, std::string&& names, const uint64_t stamp) noexcept;
+
+		const Node* Find(const utility::PathView& path) const noexcept;
+		const Node* FindChild(const Node& node, const std::string_view name) const noexcept;
+		// child indices of the node that follow after in key order
+		const size_t* GetChildrenAfter(const Node& node, const std::string_view after) const noexcept;
+		const size_t* GetChildrenEnd(const Node& node) const noexcept	{ return _children.data() + node._first_child + node._child_count; }
+		std::string_view GetName(const Node& node) const noexcept		{ return { _names.data() + node._name, node._name_size }; }
+		// Nodes are owned by the tree, which each one shared pins. An operation sharing several pins it
+		// once and shares them all through it, rather than taking the tree's control block for each.
+		INodePtr Share(const Node& node) const;
+		static INodePtr Share(const std::shared_ptr<const FrozenImpl>& tree, const Node& node);
+	};
+
+	// Makes a frozen tree out of nodes given in depth first order, children in key order after their parent
+	class FrozenImpl::Builder final
+	{
+	private:
+		struct Frame
+		{
+			size_t				Index;
+			std::vector<size_t>	Children;
+			Usage				Totals;
+		};
+
+		std::vector<Node>		_nodes;
+		std::vector<size_t>		_children;
+		std::string				_names;
+		std::vector<Frame>		_stack;
+		bool					_started{ false };
+
+	public:
+		Builder();
+
+		// Sets the value of the node at path, making the nodes on the way that aren't there yet. False if the
+		// path doesn't come after all those added so far, or a node it goes through is already left behind.
+		bool Add(const utility::PathView& path, Value&& value);
+
+		// the builder is left empty
+		std::shared_ptr<const FrozenImpl> Finish();
+
+	private:
+		std::string_view GetName(const Frame& frame) const noexcept
+		{ return { _names.data() + _nodes[frame.Index]._name, _nodes[frame.Index]._name_size }; }
+
+		void Open(const std::string_view name);
+		void Close();
+	};
+
+}
+
+#endif
@@ -0,0 +1,103 @@
+#include "GlobPattern.h"
+
+#include <algorithm>
+
+namespace jb_storage::utility
+{
+
+	GlobPattern::GlobPattern(const PathView& pattern)
+		: _segments{ pattern.begin(), pattern.end() }
+	{ }
+
+	GlobPattern::States GlobPattern::GetInitialStates() const
+	{
+		States states;
+		AddWithClosure(states, 0);
+
+		return states;
+	}
+
+	GlobPattern::States GlobPattern::Step(const States& states, const std::string_view name) const
+	{
+		States next;
+		for (const auto state : states)
+		{
+			if (state == _segments.size())
+				continue;
+
+			if (IsAnyDepth(state))
+				AddWithClosure(next, state);
+			else if (MatchSegment(_segments[state], name))
+				AddWithClosure(next, state + 1);
+		}
+
+		return next;
+	}
+
+	std::optional<std::vector<std::string_view>> GlobPattern::GetLiterals(const States& states) const
+	{
+		std::vector<std::string_view> literals;
+		for (const auto state : states)
+		{
+			if (state == _segments.size())
+				continue;
+
+			if (_segments[state].find('*') != std::string_view::npos)
+				return std::nullopt;
+
+			literals.push_back(_segments[state]);
+		}
+
+		std::sort(literals.begin(), literals.end());
+		literals.erase(std::unique(literals.begin(), literals.end()), literals.end());
+
+		return literals;
+	}
+
+	bool GlobPattern::MatchSegment(const std::string_view pattern, const std::string_view name) noexcept
+	{
+		// greedy matching with backtracking to the last star, linear for patterns with a single star
+		size_t p{ 0 }, n{ 0 };
+		size_t star{ std::string_view::npos }, resume{ 0 };
+
+		while (n < name.size())
+		{
+			if (p < pattern.size() && pattern[p] == '*')
+			{
+				star = p++;
+				resume = n;
+			}
+			else if (p < pattern.size() && pattern[p] == name[n])
+			{
+				++p;
+				++n;
+			}
+			else if (star != std::string_view::npos)
+			{
+				p = star + 1;
+				n = ++resume;
+			}
+			else
+				return false;
+		}
+
+		while (p < pattern.size() && pattern[p] == '*')
+			++p;
+
+		return p == pattern.size();
+	}
+
+	void GlobPattern::AddWithClosure(States& states, uint32_t state) const
+	{
+		// "**" may match no segment at all, so the state past it is reached as well
+		for (;; ++state)
+		{
+			if (const auto found{ std::lower_bound(states.begin(), states.end(), state) }; found == states.end() || *found != state)
+				states.insert(found, state);
+
+			if (!IsAnyDepth(state))
+				break;
+		}
+	}
+
+}
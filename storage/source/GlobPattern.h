@@ -0,0 +1,55 @@
+#ifndef STORAGE_GLOBPATTERN_H
+#define STORAGE_GLOBPATTERN_H
+
+#include "PathView.h"
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace jb_storage::utility
+{
+
+	// Path pattern matched segment by segment as an NFA: a state is the number of pattern segments
+	// matched so far. "**" matches any number of segments, zero included; any other segment is a glob
+	// where '*' matches any run of characters, so "*" alone matches any single segment.
+	class GlobPattern final
+	{
+	public:
+		using States = std::vector<uint32_t>;
+
+	private:
+		std::vector<std::string_view>	_segments;
+
+	public:
+		// segments are borrowed from the pattern
+		explicit GlobPattern(const PathView& pattern);
+
+		States GetInitialStates() const;
+
+		// states after matching a segment named so, empty if nothing may match anymore
+		States Step(const States& states, const std::string_view name) const;
+
+		bool IsAccepting(const States& states) const noexcept
+		{ return !states.empty() && states.back() == _segments.size(); }
+
+		// whether some longer path may still match
+		bool CanGoDeeper(const States& states) const noexcept
+		{ return !states.empty() && states.front() < _segments.size(); }
+
+		// names that the states can be stepped by, nothing if any of them takes a wildcard
+		std::optional<std::vector<std::string_view>> GetLiterals(const States& states) const;
+
+		static bool MatchSegment(const std::string_view pattern, const std::string_view name) noexcept;
+
+	private:
+		bool IsAnyDepth(const uint32_t state) const noexcept
+		{ return state < _segments.size() && _segments[state] == "**"; }
+
+		void AddWithClosure(States& states, uint32_t state) const;
+	};
+
+}
+
+#endif
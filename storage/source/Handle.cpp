@@ -0,0 +1,39 @@
+#include "Handle.h"
+
+#include "HandleImpl.h"
+
+namespace jb_storage
+{
+
+	Handle::operator bool () const noexcept
+	{ return _impl && _impl->IsValid(); }
+
+	std::optional<Value> Handle::Get(const std::string_view path) const
+	{ return _impl ? _impl->Get(path) : std::nullopt; }
+
+	bool Handle::SetOrInsert(const std::string_view path, const Value& value) const
+	{ return _impl && _impl->SetOrInsert(path, value); }
+
+	bool Handle::SetOrInsert(const std::string_view path, Value&& value) const
+	{ return _impl && _impl->SetOrInsert(path, std::move(value)); }
+
+	bool Handle::Delete(const std::string_view path) const
+	{ return _impl && _impl->Delete(path); }
+
+	std::optional<Value> Handle::Get(const PathSegments path) const
+	{ return _impl ? _impl->Get(path) : std::nullopt; }
+
+	bool Handle::SetOrInsert(const PathSegments path, const Value& value) const
+	{ return _impl && _impl->SetOrInsert(path, value); }
+
+	bool Handle::SetOrInsert(const PathSegments path, Value&& value) const
+	{ return _impl && _impl->SetOrInsert(path, std::move(value)); }
+
+	bool Handle::Delete(const PathSegments path) const
+	{ return _impl && _impl->Delete(path); }
+
+	Handle::Handle(IHandlePtr&& impl) noexcept
+		: _impl{ std::move(impl) }
+	{ }
+
+}
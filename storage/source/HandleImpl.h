@@ -0,0 +1,94 @@
+#ifndef STORAGE_HANDLEIMPL_H
+#define STORAGE_HANDLEIMPL_H
+
+#include "BaseImpl.h"
+#include "IStorage.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace jb_storage
+{
+
+	struct IHandle : IStorage
+	{
+		virtual bool IsValid() const noexcept = 0;
+	};
+
+	using IHandlePtr = std::shared_ptr<const IHandle>;
+
+	template < typename NodeType >
+	class HandleImpl final : public IHandle, private BaseImpl<NodeType>
+	{
+		using Base = BaseImpl<NodeType>;
+		using NodePtr = typename Base::NodePtr;
+
+	private:
+		std::vector<NodePtr>		_branch;
+		std::weak_ptr<const void>	_owner;
+
+	public:
+		// branch goes from the root of the owner down to the anchored node
+		HandleImpl(std::vector<NodePtr>&& branch, std::weak_ptr<const void>&& owner) noexcept
+			: Base{ branch.back() }, _branch{ std::move(branch) }, _owner{ std::move(owner) }
+		{ }
+
+		bool IsValid() const noexcept override
+		{ return !_owner.expired() && IsAttached(); }
+
+		std::optional<Value> Get(const std::string_view path) const override
+		{ return Get(utility::PathView{ path }); }
+
+		bool SetOrInsert(const std::string_view path, const Value& value) const override
+		{ return SetOrInsert(utility::PathView{ path }, Value{ value }); }
+
+		bool SetOrInsert(const std::string_view path, Value&& value) const override
+		{ return SetOrInsert(utility::PathView{ path }, std::move(value)); }
+
+		bool Delete(const std::string_view path) const override
+		{ return Delete(utility::PathView{ path }); }
+
+		std::optional<Value> Get(const PathSegments path) const override
+		{ return Get(utility::PathView{ path }); }
+
+		bool SetOrInsert(const PathSegments path, const Value& value) const override
+		{ return utility::PathView::IsValid(path) && SetOrInsert(utility::PathView{ path }, Value{ value }); }
+
+		bool SetOrInsert(const PathSegments path, Value&& value) const override
+		{ return utility::PathView::IsValid(path) && SetOrInsert(utility::PathView{ path }, std::move(value)); }
+
+		bool Delete(const PathSegments path) const override
+		{ return Delete(utility::PathView{ path }); }
+
+	private:
+		std::optional<Value> Get(const utility::PathView& path) const
+		{
+			if (const auto owner{ _owner.lock() }; owner && IsAttached())
+				return Base::Get(path);
+
+			return std::nullopt;
+		}
+
+		bool SetOrInsert(const utility::PathView& path, Value&& value) const
+		{
+			if (const auto owner{ _owner.lock() }; owner && IsAttached())
+				return Base::SetOrInsert(path, std::move(value));
+
+			return false;
+		}
+
+		bool Delete(const utility::PathView& path) const
+		{
+			if (const auto owner{ _owner.lock() }; owner && IsAttached())
+				return Base::Delete(path);
+
+			return false;
+		}
+
+		bool IsAttached() const noexcept
+		{ return std::none_of(_branch.begin(), _branch.end(), [](const NodePtr& node) { return node->IsDetached(); }); }
+	};
+
+}
+
+#endif
@@ -2,15 +2,22 @@
 #define STORAGE_SOURCE_INODE_H
 
 #include "Common.h"
+#include "Stats.h"
 #include "PathView.h"
 
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <optional>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace jb_storage
 {
 
 	using INodePtr = std::shared_ptr<struct INode>;
+	using INodeChildren = std::vector<std::pair<std::string, INodePtr>>;
 
 	struct INode
 	{
@@ -21,15 +28,62 @@ namespace jb_storage
 		INode& operator = (const INode&) = delete;
 
 		virtual std::optional<Value> GetValue() const = 0;
+		// the value in place, valid while the node is locked; nothing if the node has none
+		virtual const Value* PeekValue() const = 0;
 		virtual bool GrowBranchAndSetValue(const utility::PathView& path, Value&& value) = 0;
+		// lets update change the value in place, with the node locked shared only unless exclusive, so only
+		// atomically (see Atomic.h); the update tells whether it changed anything. Nothing if the value is
+		// to be kept for snapshots first: the call is to be repeated with the node locked exclusively.
+		virtual std::optional<bool> UpdateValue(const std::function<bool(Value&)>& update, const bool exclusive) = 0;
 
 		virtual INodePtr GetChild(const std::string_view name) const = 0;
-		virtual bool DeleteChild(const std::string_view name) = 0;
+		// unlinks the child and hands it over to the caller, so that its destruction can be deferred
+		virtual INodePtr DetachChild(const std::string_view name) = 0;
+		// appends at most limit children whose names follow after (all of them if it's empty) in key order
+		virtual void ListChildren(const std::string_view after, const size_t limit, INodeChildren& children) const = 0;
+		// appends all the children ListChildren() would list, when their names are of no interest
+		virtual void CollectChildren(std::vector<INodePtr>& children) const = 0;
+		// the same as GetChild() and ListChildren(), with children set to expire judged as of the tick rather
+		// than now (see utility::GetTick()), for snapshots to read them as of the time they're taken at
+		virtual INodePtr GetChildAsOf(const std::string_view name, const int64_t tick) const = 0;
+		virtual void ListChildrenAsOf(const std::string_view after, const size_t limit, INodeChildren& children, const int64_t tick) const = 0;
+		// totals of the subtree, to be called with the node locked
+		virtual Usage GetUsage() const = 0;
+		// changes along with the value or the set of children, to be called with the node locked
+		virtual uint64_t GetVersion() const = 0;
+		// for a node standing for mounted ones, appends these, newest first, and returns true; to be called
+		// with the node locked
+		virtual bool CollectMountedNodes(std::vector<INodePtr>& nodes) const = 0;
 
 		virtual void lock() = 0;
+		virtual bool try_lock() = 0;
 		virtual void unlock() = 0;
 		virtual void lock_shared() = 0;
+		virtual bool try_lock_shared() = 0;
 		virtual void unlock_shared() = 0;
+
+		// The node as the snapshot taken at time (see SnapshotClock) sees it, nothing if that's its current
+		// state; to be called with the node locked shared. What's returned is not to be changed, and it's
+		// read with this node still locked.
+		virtual INodePtr GetPast(const uint64_t time) const = 0;
+
+		// lookups used by BaseImpl traversal; final node classes hide them with ones returning their own pointer type
+		INodePtr FindChild(const std::string_view name) const { return GetChild(name); }
+		INodePtr FindChildAsOf(const std::string_view name, const int64_t tick) const { return GetChildAsOf(name, tick); }
+		INodePtr FindPast(const uint64_t time) const { return GetPast(time); }
+
+		// set once the node is unlinked from its parent, so that those who pin it can tell
+		bool IsDetached() const noexcept	{ return _detached.load(std::memory_order_acquire); }
+		void Detach() noexcept				{ _detached.store(true, std::memory_order_release); }
+
+		// counts the times the node is handed over to another parent or name, with the parent it leaves locked
+		// exclusively, so that those who reached it through that parent can tell their path is gone
+		uint32_t GetMoves() const noexcept	{ return _moves.load(std::memory_order_acquire); }
+		void AddMove() noexcept				{ _moves.fetch_add(1, std::memory_order_acq_rel); }
+
+	private:
+		std::atomic<bool>		_detached{ false };
+		std::atomic<uint32_t>	_moves{ 0 };
 	};
 
 }
@@ -0,0 +1,220 @@
+#include "LockProfiler.h"
+
+#include "ProfiledLock.h"
+
+#ifdef STORAGE_LOCK_PROFILER
+#include "ThreadSlots.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+#endif
+
+namespace jb_storage
+{
+
+#ifdef STORAGE_LOCK_PROFILER
+	namespace utility
+	{
+
+		namespace
+		{
+
+			constexpr size_t MaxDepth{ 64 };
+			constexpr size_t MaxPathSegments{ 16 };
+			constexpr size_t MaxPathsPerThread{ 4096 };
+
+			struct PathEntry
+			{
+				std::string	Path;
+				LockStats	Stats;
+			};
+
+			// every thread records into its own table (see ThreadSlots), the lock is contended only while a
+			// profile is taken; tables outlive their threads, for their figures to be reported
+			struct ThreadTable
+			{
+				std::mutex								Lock;
+				std::vector<LockStats>					ByDepth;
+				std::unordered_map<uint64_t, PathEntry>	Paths;
+			};
+
+			using Registry = ThreadSlots<ThreadTable>;
+
+			const std::shared_ptr<Registry>& GetRegistry()
+			{
+				static const auto registry{ std::make_shared<Registry>() };
+				return registry;
+			}
+
+			ThreadTable& GetThreadTable()
+			{
+				thread_local const ThreadSlot<ThreadTable> table{ GetRegistry() };
+				return table.Get();
+			}
+
+			// the tables are locked one at a time, each for as long as the function takes
+			template < typename Function >
+			void ForEachTable(Function&& function)
+			{
+				GetRegistry()->ForEach([&function](ThreadTable& table)
+				{
+					std::lock_guard lock{ table.Lock };
+					function(table);
+				});
+			}
+
+			void Accumulate(LockStats& stats, const uint64_t wait, const uint64_t hold) noexcept
+			{
+				++stats.Acquisitions;
+				stats.WaitNanoseconds += wait;
+				stats.MaxWaitNanoseconds = std::max(stats.MaxWaitNanoseconds, wait);
+				stats.HoldNanoseconds += hold;
+			}
+
+			void Merge(LockStats& stats, const LockStats& other) noexcept
+			{
+				stats.Acquisitions += other.Acquisitions;
+				stats.WaitNanoseconds += other.WaitNanoseconds;
+				stats.MaxWaitNanoseconds = std::max(stats.MaxWaitNanoseconds, other.MaxWaitNanoseconds);
+				stats.HoldNanoseconds += other.HoldNanoseconds;
+			}
+
+			// FNV-1a over the segments the path is reported by, and its depth
+			uint64_t HashPath(const PathView& path, const size_t depth) noexcept
+			{
+				uint64_t hash{ 14695981039346656037ull };
+				const auto mix = [&hash](const uint64_t byte) { hash = (hash ^ byte) * 1099511628211ull; };
+
+				for (size_t i{ 0 }, shown{ std::min(depth, MaxPathSegments) }; i < shown; ++i)
+				{
+					for (const char c : path[i])
+						mix(static_cast<unsigned char>(c));
+
+					mix('/');
+				}
+
+				mix(depth);
+
+				return hash;
+			}
+
+			std::string DescribePath(const PathView& path, const size_t depth)
+			{
+				if (!depth)
+					return "/";
+
+				std::string result;
+				for (size_t i{ 0 }, shown{ std::min(depth, MaxPathSegments) }; i < shown; ++i)
+					(result += '/') += path[i];
+
+				if (depth > MaxPathSegments)
+					result += "/... (depth " + std::to_string(depth) + ")";
+
+				return result;
+			}
+
+		}
+
+		std::atomic<bool> lock_profiler_enabled{ false };
+
+		void RecordLock(const PathView& path, const size_t depth, const uint64_t wait, const uint64_t hold)
+		{
+			ThreadTable& table{ GetThreadTable() };
+			std::lock_guard lock{ table.Lock };
+
+			const auto depth_index{ std::min(depth, MaxDepth - 1) };
+			if (table.ByDepth.size() <= depth_index)
+				table.ByDepth.resize(depth_index + 1);
+
+			Accumulate(table.ByDepth[depth_index], wait, hold);
+
+			const auto hash{ HashPath(path, depth) };
+			auto entry{ table.Paths.find(hash) };
+
+			if (entry == table.Paths.end())
+			{
+				if (table.Paths.size() >= MaxPathsPerThread)
+					return;
+
+				entry = table.Paths.emplace(hash, PathEntry{ DescribePath(path, depth), { } }).first;
+			}
+
+			Accumulate(entry->second.Stats, wait, hold);
+		}
+
+	}
+
+	bool LockProfiler::IsAvailable() noexcept
+	{ return true; }
+
+	void LockProfiler::Enable(const bool enable) noexcept
+	{ utility::lock_profiler_enabled.store(enable, std::memory_order_relaxed); }
+
+	LockProfile LockProfiler::GetProfile(const size_t top)
+	{
+		LockProfile profile;
+		profile.Available = true;
+		profile.Enabled = utility::lock_profiler_enabled.load(std::memory_order_relaxed);
+
+		std::unordered_map<uint64_t, std::pair<std::string, LockStats>> paths;
+
+		utility::ForEachTable([&profile, &paths](const utility::ThreadTable& table)
+		{
+			if (profile.ByDepth.size() < table.ByDepth.size())
+				profile.ByDepth.resize(table.ByDepth.size());
+
+			for (size_t depth{ 0 }, size{ table.ByDepth.size() }; depth < size; ++depth)
+				utility::Merge(profile.ByDepth[depth], table.ByDepth[depth]);
+
+			for (const auto& [hash, entry] : table.Paths)
+			{
+				auto& merged{ paths[hash] };
+				if (merged.first.empty())
+					merged.first = entry.Path;
+
+				utility::Merge(merged.second, entry.Stats);
+			}
+		});
+
+		profile.HottestPaths.reserve(paths.size());
+		for (auto& path : paths)
+			profile.HottestPaths.push_back(std::move(path.second));
+
+		const auto hotter = [](const auto& left, const auto& right)
+		{
+			return std::tie(left.second.WaitNanoseconds, left.second.Acquisitions) > std::tie(right.second.WaitNanoseconds, right.second.Acquisitions);
+		};
+
+		const auto count{ std::min(top, profile.HottestPaths.size()) };
+		std::partial_sort(profile.HottestPaths.begin(), profile.HottestPaths.begin() + count, profile.HottestPaths.end(), hotter);
+		profile.HottestPaths.resize(count);
+
+		return profile;
+	}
+
+	void LockProfiler::Reset()
+	{
+		utility::ForEachTable([](utility::ThreadTable& table)
+		{
+			table.ByDepth.clear();
+			table.Paths.clear();
+		});
+	}
+#else
+	bool LockProfiler::IsAvailable() noexcept
+	{ return false; }
+
+	void LockProfiler::Enable(const bool) noexcept
+	{ }
+
+	LockProfile LockProfiler::GetProfile(const size_t)
+	{ return { }; }
+
+	void LockProfiler::Reset()
+	{ }
+#endif
+
+}
@@ -0,0 +1,179 @@
+#include "Metrics.h"
+
+#include "Reclaimer.h"
+
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+#include <unordered_map>
+
+namespace jb_storage::utility
+{
+
+	namespace
+	{
+
+		void UpdateMin(std::atomic<uint64_t>& min, const uint64_t value) noexcept
+		{
+			for (auto current{ min.load(std::memory_order_relaxed) }; value < current; )
+				if (min.compare_exchange_weak(current, value, std::memory_order_relaxed))
+					break;
+		}
+
+		void UpdateMax(std::atomic<uint64_t>& max, const uint64_t value) noexcept
+		{
+			for (auto current{ max.load(std::memory_order_relaxed) }; value > current; )
+				if (max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+					break;
+		}
+
+	}
+
+	void Metrics::Enable(const bool enable)
+	{
+		if (enable)
+			std::call_once(_allocation, [this]()
+			{
+				_pool = std::make_shared<ShardPool>();
+				_allocated.store(true, std::memory_order_release);
+			});
+
+		_enabled.store(enable, std::memory_order_release);
+	}
+
+	Stats Metrics::GetStats() const
+	{
+		Stats stats;
+		stats.Enabled = IsEnabled();
+		Reclaimer::Instance().GetStats(stats.Reclaim);
+
+		if (!_allocated.load(std::memory_order_acquire))
+			return stats;
+
+		OperationStats* const targets[]{ &stats.Get, &stats.SetOrInsert, &stats.Delete };
+
+		_pool->ForEach([&targets](const Shard& shard)
+		{
+			for (size_t op{ 0 }; op < static_cast<size_t>(Operation::Count); ++op)
+			{
+				const OperationShard& source{ shard.Operations[op] };
+
+				LatencyHistogram histogram;
+				for (size_t bucket{ 0 }; bucket < LatencyHistogram::BucketCount; ++bucket)
+					histogram._count += histogram._buckets[bucket] = source.Buckets[bucket].load(std::memory_order_relaxed);
+
+				if (!histogram._count)
+					continue;
+
+				histogram._sum = source.Sum.load(std::memory_order_relaxed);
+				histogram._max = source.Max.load(std::memory_order_relaxed);
+				histogram._min = std::min(source.Min.load(std::memory_order_relaxed), histogram._max); // racing a first record
+
+				OperationStats& target{ *targets[op] };
+				target.Calls += histogram._count;
+				target.Hits += source.Hits.load(std::memory_order_relaxed);
+				target.Latency.Merge(histogram);
+			}
+		});
+
+		return stats;
+	}
+
+	// a record that finds no memory for a shard is dropped rather than failing the operation measured
+	void Metrics::Record(const Operation operation, const bool hit, const uint64_t nanoseconds) const noexcept
+	try
+	{
+		OperationShard& shard{ GetThreadShard(_pool).Operations[static_cast<size_t>(operation)] };
+
+		if (hit)
+			shard.Hits.fetch_add(1, std::memory_order_relaxed);
+
+		shard.Sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+		UpdateMin(shard.Min, nanoseconds);
+		UpdateMax(shard.Max, nanoseconds);
+		shard.Buckets[LatencyHistogram::GetBucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+	}
+	catch (...)
+	{ }
+
+	// a shard handed over from a finished thread goes on with the counts it has
+	std::unique_ptr<Metrics::Shard> Metrics::MakeShard(size_t)
+	{
+		auto shard{ std::make_unique<Shard>() };
+		for (auto& operation : shard->Operations)
+			operation.Min.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+
+		return shard;
+	}
+
+	// Every thread maps the pools it recorded to onto its shards, keeping the last entry looked up at hand, so
+	// that a thread recording to a single instance doesn't even hash. An entry of a pool that's gone is told by
+	// its weak pointer, which isn't locked for that, as the count would be contended; a pool that's in use is
+	// alive, so an expired entry found for its address is a stale one. Stale entries are dropped as new ones
+	// are added, shards still in use go back to their pools once the thread finishes.
+	Metrics::Shard& Metrics::GetThreadShard(const std::shared_ptr<ShardPool>& pool)
+	{
+		struct Entry
+		{
+			std::weak_ptr<ShardPool>	Pool;
+			Shard*						Owned;
+		};
+
+		class ThreadShards final
+		{
+		private:
+			std::unordered_map<const ShardPool*, Entry>	_entries;
+			const ShardPool*							_last_pool{ nullptr };
+			const Entry*								_last{ nullptr };
+
+		public:
+			~ThreadShards()
+			{
+				for (const auto& entry : _entries)
+					if (const auto pool{ entry.second.Pool.lock() })
+						pool->Release(*entry.second.Owned);
+			}
+
+			Shard& Get(const std::shared_ptr<ShardPool>& pool)
+			{
+				if (_last_pool == pool.get() && !_last->Pool.expired())
+					return *_last->Owned;
+
+				_last_pool = nullptr;
+
+				auto found{ _entries.find(pool.get()) };
+				if (found == _entries.end() || found->second.Pool.expired())
+				{
+					for (auto entry{ _entries.begin() }; entry != _entries.end(); )
+						entry = entry->second.Pool.expired() ? _entries.erase(entry) : std::next(entry);
+
+					found = _entries.insert_or_assign(pool.get(), Entry{ pool, &pool->Acquire(MakeShard) }).first;
+				}
+
+				_last_pool = pool.get();
+				_last = &found->second;
+
+				return *_last->Owned;
+			}
+		};
+
+		thread_local ThreadShards shards;
+		return shards.Get(pool);
+	}
+
+	size_t GetValueSize(const Value& value) noexcept
+	{
+		return std::visit([](const auto& payload) -> size_t
+		{
+			using Payload = std::decay_t<decltype(payload)>;
+
+			if constexpr (std::is_same_v<Payload, std::monostate>)
+				return 0;
+			else if constexpr (std::is_arithmetic_v<Payload>)
+				return sizeof(Payload);
+			else
+				return payload.size();
+		}, value);
+	}
+
+}
@@ -0,0 +1,93 @@
+#ifndef STORAGE_METRICS_H
+#define STORAGE_METRICS_H
+
+#include "Common.h"
+#include "Stats.h"
+#include "ThreadSlots.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace jb_storage::utility
+{
+
+	enum class Operation : size_t
+	{
+		Get,
+		SetOrInsert,
+		Delete,
+		Count
+	};
+
+	// Operation counters of one volume or storage. Every thread records into its own shard (see ThreadSlots)
+	// with relaxed increments, so threads don't contend for cache lines; GetStats() merges the shards while
+	// traffic goes on.
+	class Metrics final
+	{
+		struct OperationShard
+		{
+			std::atomic<uint64_t>										Hits;
+			std::atomic<uint64_t>										Sum;
+			std::atomic<uint64_t>										Min;
+			std::atomic<uint64_t>										Max;
+			std::array<std::atomic<uint64_t>, LatencyHistogram::BucketCount>	Buckets;
+		};
+
+		struct alignas(64) Shard
+		{
+			std::array<OperationShard, static_cast<size_t>(Operation::Count)>	Operations;
+		};
+
+		// shards of one instance; threads keep track of theirs by weak pointers, so that a pool outlives
+		// neither its owner nor the threads' interest in it
+		using ShardPool = ThreadSlots<Shard>;
+
+	private:
+		std::atomic<bool>			_enabled{ false };
+		std::once_flag				_allocation;
+		std::shared_ptr<ShardPool>	_pool;		// made when statistics are enabled for the first time
+		std::atomic<bool>			_allocated{ false };
+
+	public:
+		void Enable(const bool enable);
+
+		bool IsEnabled() const noexcept
+		{ return _enabled.load(std::memory_order_acquire); }
+
+		// runs the operation and, when enabled, records its latency and whether its result is truthy
+		template < typename Function >
+		auto Measure(const Operation operation, Function&& function) const
+		{
+			if (!IsEnabled())
+				return function();
+
+			const auto start{ std::chrono::steady_clock::now() };
+			auto result{ function() };
+			const auto elapsed{ std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start) };
+
+			Record(operation, static_cast<bool>(result), static_cast<uint64_t>(elapsed.count()));
+
+			return result;
+		}
+
+		// counters and the state of the reclaimer, which every owner shares; gauges of its own are up to the owner
+		Stats GetStats() const;
+
+	private:
+		void Record(const Operation operation, const bool hit, const uint64_t nanoseconds) const noexcept;
+
+		static std::unique_ptr<Shard> MakeShard(size_t);
+
+		// the shard of the calling thread, taken from the pool on first use
+		static Shard& GetThreadShard(const std::shared_ptr<ShardPool>& pool);
+	};
+
+	// payload size accounted by Stats::ValueBytes
+	size_t GetValueSize(const Value& value) noexcept;
+
+}
+
+#endif
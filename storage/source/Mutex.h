@@ -5,6 +5,9 @@
 #include <shared_mutex>
 #endif
 
+#include <atomic>
+#include <thread>
+
 namespace jb_storage
 {
 
@@ -14,6 +17,27 @@ namespace jb_storage
 #error No mutex type choosen
 #endif
 
+	// for critical sections of a few instructions, where a mutex would take more room than what it guards
+	class SpinLock final
+	{
+	private:
+		std::atomic<bool>	_locked{ false };
+
+	public:
+		void lock() noexcept
+		{
+			while (_locked.exchange(true, std::memory_order_acquire))
+				while (_locked.load(std::memory_order_relaxed))
+					std::this_thread::yield();
+		}
+
+		bool try_lock() noexcept
+		{ return !_locked.load(std::memory_order_relaxed) && !_locked.exchange(true, std::memory_order_acquire); }
+
+		void unlock() noexcept
+		{ _locked.store(false, std::memory_order_release); }
+	};
+
 }
 
 #endif
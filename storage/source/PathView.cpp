@@ -1,19 +1,109 @@
 #include "PathView.h"
 
+#include "Tracing.h"
+
+#include <algorithm>
+#include <functional>
 #include <stdexcept>
+#include <string>
 
 namespace jb_storage::utility
 {
 
+	namespace
+	{
+
+		template < typename Container >
+		bool Owns(const Container& container, const std::string_view* ptr) noexcept
+		{
+			const std::less_equal<const std::string_view*> less_equal;
+			return less_equal(container.data(), ptr) && less_equal(ptr, container.data() + container.size());
+		}
+
+	}
+
 	PathView::PathView(const std::string_view path)
-		: _begin{ path }, _end{ path.substr(path.length()) }, _depth{ static_cast<size_t>(std::distance(_begin, _end)) }
+		: PathView{ }
+	{
+		if (!Parse(path))
+			throw std::invalid_argument{ std::string{ path } };
+	}
+
+	PathView::PathView(const PathView& other)
+		: _inline{ other._inline }, _overflow{ other._overflow }, _begin{ other._begin }, _end{ other._end }
+	{
+		// rebase onto own storage unless other is a suffix view borrowing someone else's segments
+		if (Owns(other._inline, other._begin))
+		{
+			_begin = _inline.data() + (other._begin - other._inline.data());
+			_end = _inline.data() + (other._end - other._inline.data());
+		}
+		else if (!other._overflow.empty() && Owns(other._overflow, other._begin))
+		{
+			_begin = _overflow.data() + (other._begin - other._overflow.data());
+			_end = _overflow.data() + (other._end - other._overflow.data());
+		}
+	}
+
+	std::optional<PathView> PathView::TryParse(const std::string_view path)
+	{
+		std::optional<PathView> view{ PathView{ } };
+		if (!view->Parse(path))
+			view.reset();
+
+		return view;
+	}
+
+	bool PathView::IsValid(const PathSegments segments) noexcept
 	{
-		if (path.front() != s_separator)
-			throw std::invalid_argument{ path.data() };
+		return std::all_of(segments.begin(), segments.end(), [](const std::string_view segment)
+		{ return !segment.empty() && segment.find(s_separator) == std::string_view::npos; });
 	}
 
-	PathView::PathView(const PathView& whole, const const_iterator& current)
-		: _begin{ current }, _end{ whole._end }, _depth{ static_cast<size_t>(std::distance(_begin, _end)) }
+	PathView::PathView() noexcept
+		: _begin{ _inline.data() }, _end{ _inline.data() }
+	{ }
+
+	PathView::PathView(const const_iterator& begin, const const_iterator& end) noexcept
+		: _begin{ begin }, _end{ end }
 	{ }
 
+	bool PathView::Parse(const std::string_view path)
+	{
+		STORAGE_TRACE_SPAN("parse path");
+
+		if (path.empty() || path.front() != s_separator)
+			return false;
+
+		size_t depth{ 0 };
+
+		// string_view::find boils down to memchr which is vectorized by any decent libc
+		for (size_t offset{ path.find_first_not_of(s_separator) }; offset < path.length(); )
+		{
+			const auto separator{ std::min(path.find(s_separator, offset), path.length()) };
+			const std::string_view segment{ path.substr(offset, separator - offset) };
+
+			if (depth < s_inline_capacity)
+				_inline[depth] = segment;
+			else
+			{
+				if (depth == s_inline_capacity)
+					_overflow.assign(_inline.begin(), _inline.end());
+
+				_overflow.push_back(segment);
+			}
+
+			++depth;
+
+			offset = separator;
+			while (offset < path.length() && path[offset] == s_separator)
+				++offset;
+		}
+
+		_begin = depth > s_inline_capacity ? _overflow.data() : _inline.data();
+		_end = _begin + depth;
+
+		return true;
+	}
+
 }
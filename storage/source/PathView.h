@@ -1,82 +1,64 @@
 #ifndef STORAGE_PATH_H
 #define STORAGE_PATH_H
 
-#include <algorithm>
-#include <iterator>
+#include "PathSegments.h"
+
+#include <array>
+#include <optional>
 #include <string_view>
+#include <vector>
 
 namespace jb_storage::utility
 {
 
+	// Splits an absolute path into its segments in a single pass. Segments are kept as views into
+	// the source string, the first s_inline_capacity of them without any allocation, which gives
+	// O(1) depth, random access and suffix views. A view returned by GetRest() refers to the segment
+	// index of the whole path, so it must not outlive it.
 	class PathView final
 	{
 	public:
-		class const_iterator final
-		{
-			friend class PathView;
-
-		public:
-			using value_type = std::string_view;
-			using difference_type = std::ptrdiff_t;
-			using reference = value_type;
-			using iterator_category = std::input_iterator_tag;
-
-			class PtrProxy final
-			{
-				friend class const_iterator;
-
-			private:
-				value_type	_val;
-
-			public:
-				const value_type* operator -> () const noexcept { return &_val; }
-
-			private:
-				explicit PtrProxy(value_type&& val) noexcept : _val{ std::move(val) } { }
-			};
-
-			using pointer = PtrProxy;
-
-		private:
-			std::string_view	_rest;
-			std::string_view	_current;
-
-		public:
-			reference operator * () const noexcept { return _current; }
-			pointer operator -> () const noexcept { return PtrProxy{ **this }; }
-			const_iterator& operator ++ () { return *this = const_iterator{ _rest.substr(_current.length()) }; }
-			const_iterator operator ++ (int) { const auto copy{ *this }; ++(*this); return copy; }
-			bool operator == (const const_iterator& other) const noexcept { return _current.data() == other._current.data(); }
-			bool operator != (const const_iterator& other) const noexcept { return !(*this == other); }
-
-		private:
-			explicit const_iterator(const std::string_view path)
-				:	_rest{ path.substr(std::min(path.length(), path.find_first_not_of(s_separator))) },
-					_current{ _rest.substr(0, std::min(_rest.length(), _rest.find_first_of(s_separator))) }
-			{ }
-		};
+		using const_iterator = const std::string_view*;
 
 	private:
 		static constexpr char s_separator{ '/' };
+		static constexpr size_t s_inline_capacity{ 16 };
 
-		const_iterator		_begin;
-		const_iterator		_end;
-		size_t				_depth;
+		std::array<std::string_view, s_inline_capacity>	_inline;
+		std::vector<std::string_view>					_overflow;
+		const_iterator									_begin;
+		const_iterator									_end;
 
 	public:
 		explicit PathView(const std::string_view path);
+		explicit PathView(const PathSegments segments) noexcept : PathView{ segments.begin(), segments.end() } { }
+		PathView(const PathView& other);
+		PathView& operator = (const PathView&) = delete;
+
+		// same as constructor but reports malformed path by returning std::nullopt instead of throwing
+		static std::optional<PathView> TryParse(const std::string_view path);
+
+		// checks that segments could have been produced by parsing some path
+		static bool IsValid(const PathSegments segments) noexcept;
 
-		size_t GetDepth() const noexcept 					{ return _depth; }
-		bool IsEmpty() const noexcept 						{ return GetDepth() == 0; }
-		PathView GetRest(const const_iterator& it) const	{ return PathView{ *this, it }; }
+		size_t GetDepth() const noexcept 								{ return static_cast<size_t>(_end - _begin); }
+		bool IsEmpty() const noexcept 									{ return _begin == _end; }
+		PathView GetRest(const const_iterator& it) const noexcept		{ return PathView{ it, _end }; }
+		// of a path that isn't empty, with the same lifetime constraint as GetRest()
+		PathView GetParent() const noexcept								{ return PathView{ _begin, _end - 1 }; }
 
-		const_iterator cbegin() const noexcept				{ return _begin; }
-		const_iterator cend() const noexcept				{ return _end; }
-		const_iterator begin() const noexcept				{ return cbegin(); }
-		const_iterator end() const noexcept					{ return cend(); }
+		std::string_view operator [] (const size_t index) const noexcept	{ return _begin[index]; }
+
+		const_iterator cbegin() const noexcept							{ return _begin; }
+		const_iterator cend() const noexcept							{ return _end; }
+		const_iterator begin() const noexcept							{ return cbegin(); }
+		const_iterator end() const noexcept								{ return cend(); }
 
 	private:
-		PathView(const PathView& whole, const const_iterator& current);
+		PathView() noexcept;
+		PathView(const const_iterator& begin, const const_iterator& end) noexcept;
+
+		bool Parse(const std::string_view path);
 	};
 
 }
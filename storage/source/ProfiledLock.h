@@ -0,0 +1,123 @@
+#ifndef STORAGE_PROFILEDLOCK_H
+#define STORAGE_PROFILEDLOCK_H
+
+#include "PathView.h"
+#include "Tracing.h"
+
+#ifdef STORAGE_LOCK_PROFILER
+#include <atomic>
+#include <chrono>
+#endif
+
+namespace jb_storage::utility
+{
+
+#ifdef STORAGE_LOCK_PROFILER
+	extern std::atomic<bool> lock_profiler_enabled;
+
+	void RecordLock(const PathView& path, const size_t depth, const uint64_t wait, const uint64_t hold);
+#endif
+
+	// Guard for a node met while resolving a path, depth being the number of segments leading to the node;
+	// with STORAGE_LOCK_PROFILER it reports its wait and hold times to LockProfiler when that is enabled
+	template < typename Lockable, bool Exclusive >
+	class ProfiledLock
+	{
+	private:
+		Lockable&	_lockable;
+
+#ifdef STORAGE_LOCK_PROFILER
+		using Clock = std::chrono::steady_clock;
+
+		const PathView*		_path{ nullptr };
+		size_t				_depth{ 0 };
+		Clock::time_point	_requested;
+		Clock::time_point	_acquired;
+#endif
+
+	public:
+		ProfiledLock(const ProfiledLock&) = delete;
+		ProfiledLock& operator = (const ProfiledLock&) = delete;
+
+		~ProfiledLock()
+		{
+#ifdef STORAGE_LOCK_PROFILER
+			if (_path)
+			{
+				const auto released{ Clock::now() };
+				Unlock();
+				RecordLock(*_path, _depth, Nanoseconds(_acquired - _requested), Nanoseconds(released - _acquired));
+				return;
+			}
+#endif
+			Unlock();
+		}
+
+	protected:
+		ProfiledLock(Lockable& lockable, [[maybe_unused]] const PathView& path, [[maybe_unused]] const size_t depth)
+			: _lockable{ lockable }
+		{
+#ifdef STORAGE_LOCK_PROFILER
+			if (lock_profiler_enabled.load(std::memory_order_relaxed))
+			{
+				_path = &path;
+				_depth = depth;
+				_requested = Clock::now();
+				LockTraced();
+				_acquired = Clock::now();
+				return;
+			}
+#endif
+			LockTraced();
+		}
+
+	private:
+		void LockTraced()
+		{
+			STORAGE_TRACE_SPAN("lock wait");
+			Lock();
+		}
+
+		void Lock()
+		{
+			if constexpr (Exclusive)
+				_lockable.lock();
+			else
+				_lockable.lock_shared();
+		}
+
+		void Unlock()
+		{
+			if constexpr (Exclusive)
+				_lockable.unlock();
+			else
+				_lockable.unlock_shared();
+		}
+
+#ifdef STORAGE_LOCK_PROFILER
+		static uint64_t Nanoseconds(const Clock::duration duration) noexcept
+		{ return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()); }
+#endif
+	};
+
+	template < typename Lockable >
+	class SharedLock final : public ProfiledLock<Lockable, false>
+	{
+	public:
+		SharedLock(Lockable& lockable, const PathView& path, const size_t depth)
+			: ProfiledLock<Lockable, false>{ lockable, path, depth }
+		{ }
+	};
+
+	template < typename Lockable >
+	class UniqueLock final : public ProfiledLock<Lockable, true>
+	{
+	public:
+		UniqueLock(Lockable& lockable, const PathView& path, const size_t depth)
+			: ProfiledLock<Lockable, true>{ lockable, path, depth }
+		{ }
+	};
+
+}
+
+#endif
@@ -0,0 +1,123 @@
+#include "Reclaimer.h"
+
+namespace jb_storage::utility
+{
+
+	Reclaimer& Reclaimer::Instance()
+	{
+		static Reclaimer instance;
+		return instance;
+	}
+
+	Reclaimer::Reclaimer()
+		: _in_flight{ 0 }, _inline{ 0 }, _busy{ false }, _stop{ false }, _thread{ [this]() { Run(); } }
+	{ }
+
+	Reclaimer::~Reclaimer()
+	{
+		{
+			std::lock_guard lock{ _lock };
+			_stop = true;
+		}
+
+		_wakeup.notify_one();
+		_thread.join();
+	}
+
+	void Reclaimer::Retire(Garbage&& garbage)
+	{
+		if (!garbage)
+			return;
+
+		bool queued{ false };
+		{
+			std::lock_guard lock{ _lock };
+			if (_queue.size() + _in_flight < Capacity)
+			{
+				_queue.push_back(std::move(garbage));
+				queued = true;
+			}
+		}
+
+		// destroyed right here, off the lock
+		if (!queued)
+		{
+			_inline.fetch_add(1, std::memory_order_relaxed);
+			garbage.reset();
+			return;
+		}
+
+		_wakeup.notify_one();
+	}
+
+	void Reclaimer::RetireLocked(Garbage&& garbage)
+	{
+		if (!garbage)
+			return;
+
+		{
+			std::lock_guard lock{ _lock };
+			_queue.push_back(std::move(garbage));
+		}
+
+		_wakeup.notify_one();
+	}
+
+	void Reclaimer::Defer(std::function<void()>&& task)
+	{
+		{
+			std::lock_guard lock{ _lock };
+			_tasks.push_back(std::move(task));
+		}
+
+		_wakeup.notify_one();
+	}
+
+	void Reclaimer::GetStats(ReclaimStats& stats) const
+	{
+		{
+			std::lock_guard lock{ _lock };
+			stats.Queued = _queue.size() + _in_flight + _tasks.size();
+		}
+
+		stats.Inline = _inline.load(std::memory_order_relaxed);
+	}
+
+	void Reclaimer::Drain()
+	{
+		std::unique_lock lock{ _lock };
+		_drained.wait(lock, [this]() { return _queue.empty() && _tasks.empty() && !_busy; });
+	}
+
+	// tasks run before the garbage of the same batch is destroyed, what they retire goes with the next one
+	void Reclaimer::Run()
+	{
+		std::vector<Garbage> batch;
+		std::vector<std::function<void()>> tasks;
+
+		for (std::unique_lock lock{ _lock }; ; )
+		{
+			_wakeup.wait(lock, [this]() { return _stop || !_queue.empty() || !_tasks.empty(); });
+
+			if (_queue.empty() && _tasks.empty())
+				return;
+
+			batch.swap(_queue);
+			tasks.swap(_tasks);
+			_in_flight = batch.size();
+			_busy = true;
+
+			lock.unlock();
+			for (const auto& task : tasks)
+				task();
+			tasks.clear();
+			batch.clear();
+			lock.lock();
+
+			_in_flight = 0;
+			_busy = false;
+			_drained.notify_all();
+		}
+	}
+
+}
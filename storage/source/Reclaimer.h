@@ -0,0 +1,70 @@
+#ifndef STORAGE_RECLAIMER_H
+#define STORAGE_RECLAIMER_H
+
+#include "Stats.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace jb_storage::utility
+{
+
+	// Background thread destroying what is retired to it, so that a caller unlinking a huge subtree
+	// neither pays for its destruction nor holds any lock meanwhile; it runs cleanups deferred to it as well.
+	// Garbage waiting for it, the batch being destroyed included, is capped: past that, callers destroy what
+	// they retire themselves, so that a burst of deletes is paced by the destruction instead of piling up.
+	class Reclaimer final
+	{
+		using Garbage = std::shared_ptr<const void>;
+
+	public:
+		static constexpr size_t Capacity{ 1024 };
+
+	private:
+		mutable std::mutex					_lock;
+		std::condition_variable				_wakeup;
+		std::condition_variable				_drained;
+		std::vector<Garbage>				_queue;
+		std::vector<std::function<void()>>	_tasks;
+		size_t								_in_flight;		// garbage of the batch being destroyed
+		std::atomic<uint64_t>				_inline;
+		bool								_busy;
+		bool								_stop;
+		std::thread							_thread;
+
+	public:
+		static Reclaimer& Instance();
+
+		Reclaimer();
+		~Reclaimer();
+
+		Reclaimer(const Reclaimer&) = delete;
+		Reclaimer& operator = (const Reclaimer&) = delete;
+
+		void Retire(Garbage&& garbage);
+
+		// the same, for callers holding node locks that destroying the garbage in place would keep held for
+		// the whole teardown: it's queued past the cap as well
+		void RetireLocked(Garbage&& garbage);
+
+		// runs the task on the thread, for one that takes locks its caller may hold; tasks aren't capped, as
+		// they can't be run in place
+		void Defer(std::function<void()>&& task);
+
+		void GetStats(ReclaimStats& stats) const;
+
+		// waits until everything retired so far is destroyed, and every task deferred so far is run
+		void Drain();
+
+	private:
+		void Run();
+	};
+
+}
+
+#endif
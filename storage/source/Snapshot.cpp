@@ -0,0 +1,25 @@
+#include "Snapshot.h"
+
+#include "SnapshotImpl.h"
+
+namespace jb_storage
+{
+
+	Snapshot::Snapshot(Snapshot&&) noexcept = default;
+	Snapshot& Snapshot::operator = (Snapshot&&) noexcept = default;
+	Snapshot::~Snapshot() = default;
+
+	std::optional<Value> Snapshot::Get(const std::string_view path) const
+	{ return _impl->Get(utility::PathView{ path }); }
+
+	std::optional<std::vector<std::string>> Snapshot::List(const std::string_view path, const size_t limit, const std::string_view after) const
+	{ return _impl->List(utility::PathView{ path }, limit, after); }
+
+	std::string Snapshot::Scan(const std::string_view path, const ScanCallback& callback, const std::string_view resume) const
+	{ return _impl->Scan(utility::PathView{ path }, callback, resume); }
+
+	Snapshot::Snapshot(std::unique_ptr<const ISnapshot>&& impl) noexcept
+		: _impl{ std::move(impl) }
+	{ }
+
+}
@@ -0,0 +1,128 @@
+#include "SnapshotClock.h"
+
+#include "Reclaimer.h"
+
+namespace jb_storage::utility
+{
+
+	SnapshotClock& SnapshotClock::Instance()
+	{
+		static SnapshotClock instance;
+		return instance;
+	}
+
+	// the reclaimer is made first, so that it outlives the clock, and is done with the keepers before it's gone
+	SnapshotClock::SnapshotClock()
+	{ Reclaimer::Instance(); }
+
+	SnapshotClock::~SnapshotClock()
+	{ Reclaimer::Instance().Drain(); }
+
+	uint64_t SnapshotClock::Take(Scope* const scope)
+	{
+		std::lock_guard lock{ _lock };
+
+		const auto time{ _time.load(std::memory_order_relaxed) };
+		if (scope)
+		{
+			Insert(*scope, time);
+			_scoped.fetch_add(1, std::memory_order_release);
+		}
+		else
+		{
+			_live.insert(time);
+			_newest.store(time, std::memory_order_release);
+			_oldest.store(*_live.begin(), std::memory_order_release);
+		}
+		_time.store(time + 1, std::memory_order_release);
+
+		return time;
+	}
+
+	void SnapshotClock::Release(const uint64_t time, Scope* const scope)
+	{
+		std::vector<std::weak_ptr<IKeeper>> kept;
+		{
+			std::lock_guard lock{ _lock };
+
+			if (scope)
+				Erase(*scope, time);
+			else
+			{
+				if (const auto found{ _live.find(time) }; found != _live.end())
+					_live.erase(found);
+
+				_newest.store(_live.empty() ? 0 : *_live.rbegin(), std::memory_order_release);
+				_oldest.store(_live.empty() ? std::numeric_limits<uint64_t>::max() : *_live.begin(), std::memory_order_release);
+			}
+
+			kept.swap(_kept);
+		}
+
+		if (!kept.empty())
+			Prune(std::move(kept));
+	}
+
+	void SnapshotClock::Keep(std::weak_ptr<IKeeper>&& keeper)
+	{
+		std::lock_guard lock{ _lock };
+		_kept.push_back(std::move(keeper));
+	}
+
+	void SnapshotClock::Share(Scope& from, const std::shared_ptr<Scope>& to)
+	{
+		std::lock_guard lock{ _lock };
+
+		if (&from == to.get())
+			return;
+
+		for (const auto time : from._live)
+		{
+			Insert(*to, time);
+			_scoped.fetch_add(1, std::memory_order_release);
+			from._shared.emplace(time, to);
+		}
+	}
+
+	void SnapshotClock::Prune(std::vector<std::weak_ptr<IKeeper>>&& kept)
+	{
+		Reclaimer::Instance().Defer([this, kept{ std::move(kept) }]()
+		{
+			for (const auto& keeper : kept)
+				if (const auto alive{ keeper.lock() }; alive && alive->Prune())
+					Keep(alive);
+		});
+	}
+
+	void SnapshotClock::Insert(Scope& scope, const uint64_t time)
+	{
+		scope._live.insert(time);
+		scope._newest.store(*scope._live.rbegin(), std::memory_order_release);
+		scope._oldest.store(*scope._live.begin(), std::memory_order_release);
+	}
+
+	// the time goes from the scopes it was shared with as well, and from those they shared it with in turn;
+	// each share is taken back once
+	void SnapshotClock::Erase(Scope& scope, const uint64_t time)
+	{
+		if (const auto found{ scope._live.find(time) }; found != scope._live.end())
+		{
+			scope._live.erase(found);
+			_scoped.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		scope._newest.store(scope._live.empty() ? 0 : *scope._live.rbegin(), std::memory_order_release);
+		scope._oldest.store(scope._live.empty() ? std::numeric_limits<uint64_t>::max() : *scope._live.begin(), std::memory_order_release);
+
+		std::vector<std::shared_ptr<Scope>> shared;
+		const auto [begin, end] = scope._shared.equal_range(time);
+		for (auto share{ begin }; share != end; ++share)
+			shared.push_back(std::move(share->second));
+
+		scope._shared.erase(begin, end);
+
+		for (const auto& to : shared)
+			Erase(*to, time);
+	}
+
+}
@@ -0,0 +1,169 @@
+#ifndef STORAGE_SNAPSHOTCLOCK_H
+#define STORAGE_SNAPSHOTCLOCK_H
+
+#include "TimerWheel.h"
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace jb_storage::utility
+{
+
+	// Process wide clock of snapshots, shared by all volumes so that a snapshot of a storage is one point
+	// in time for every volume mounted. The time moves on only when a snapshot is taken: a change is stamped
+	// with the time it's made at and a snapshot taken at some time sees the changes stamped with it or
+	// before. The time is moved on after the snapshot is registered, so whoever reads the new time sees
+	// the snapshot as live. A snapshot taken within a scope is seen by the nodes of that scope only.
+	// States kept for snapshots are dropped as they're released, by keepers run off the caller's thread.
+	class SnapshotClock final
+	{
+	public:
+		// what keeps states for snapshots; drops those no live one sees, tells whether any are left
+		struct IKeeper
+		{
+			virtual ~IKeeper() = default;
+			virtual bool Prune() = 0;
+		};
+
+		// Snapshots of one tree, such as the clones of a volume, that only the nodes of the tree keep states
+		// for; the sets are guarded by the lock of the clock.
+		class Scope final
+		{
+			friend class SnapshotClock;
+
+		private:
+			std::atomic<uint64_t>								_newest{ 0 };
+			std::atomic<uint64_t>								_oldest{ std::numeric_limits<uint64_t>::max() };
+			std::multiset<uint64_t>								_live;
+			std::multimap<uint64_t, std::shared_ptr<Scope>>	_shared;	// scopes given the times too, see Share()
+
+		public:
+			bool IsSeen(const uint64_t stamp) const noexcept
+			{
+				const auto newest{ _newest.load(std::memory_order_acquire) };
+				return newest && newest >= stamp;
+			}
+
+			bool IsSeen(const uint64_t since, const uint64_t until) const noexcept
+			{ return IsSeen(since) && _oldest.load(std::memory_order_acquire) < until; }
+		};
+
+	private:
+		std::atomic<uint64_t>	_time{ 1 };
+		std::atomic<uint64_t>	_newest{ 0 };	// of live snapshots, 0 if there are none
+		std::atomic<uint64_t>	_oldest{ std::numeric_limits<uint64_t>::max() };
+		std::atomic<size_t>		_scoped{ 0 };	// times live in any scope
+
+		std::mutex								_lock;
+		std::multiset<uint64_t>					_live;
+		std::vector<std::weak_ptr<IKeeper>>		_kept;
+
+	public:
+		// Changes this thread makes while a pin is alive are stamped with the same time, so that a snapshot
+		// sees either all of them or none; for changes of several nodes made with all of them locked.
+		class Pin final
+		{
+		private:
+			const uint64_t	_saved;
+
+		public:
+			Pin() noexcept : _saved{ Pinned() } { Pinned() = Instance().GetTime(); }
+			~Pin() { Pinned() = _saved; }
+
+			Pin(const Pin&) = delete;
+			Pin& operator = (const Pin&) = delete;
+		};
+
+		// keeps a snapshot live for as long as it's alive, within the scope if given one; nodes set to expire
+		// are read as of the tick it's taken at (see utility::GetTick()), so that the snapshot reads the same
+		// all along
+		class Lease final
+		{
+		private:
+			const std::shared_ptr<Scope>	_scope;
+			const uint64_t					_time;
+			const int64_t					_tick;
+
+		public:
+			explicit Lease(std::shared_ptr<Scope> scope = nullptr)
+				: _scope{ std::move(scope) }, _time{ Instance().Take(_scope.get()) }, _tick{ utility::GetTick() }
+			{ }
+			~Lease() { Instance().Release(_time, _scope.get()); }
+
+			Lease(const Lease&) = delete;
+			Lease& operator = (const Lease&) = delete;
+
+			uint64_t GetTime() const noexcept { return _time; }
+			int64_t GetTick() const noexcept { return _tick; }
+		};
+
+		static SnapshotClock& Instance();
+
+		SnapshotClock();
+		~SnapshotClock();
+
+		SnapshotClock(const SnapshotClock&) = delete;
+		SnapshotClock& operator = (const SnapshotClock&) = delete;
+
+		// registers a snapshot, within the scope if given one, returns the time it's taken at
+		uint64_t Take(Scope* const scope = nullptr);
+		void Release(const uint64_t time, Scope* const scope = nullptr);
+
+		// the keeper is run once a snapshot is released, and again after every release for as long as it
+		// has states left
+		void Keep(std::weak_ptr<IKeeper>&& keeper);
+
+		// snapshots live in one scope are seen by the nodes of the other as well, till they're released; for
+		// nodes handed over from one tree to another
+		void Share(Scope& from, const std::shared_ptr<Scope>& to);
+
+		uint64_t GetTime() const noexcept
+		{
+			const auto pinned{ Pinned() };
+			return pinned ? pinned : _time.load(std::memory_order_acquire);
+		}
+
+		// whether any scope has a live snapshot, for nodes to look theirs up only then
+		bool IsScoped() const noexcept
+		{ return _scoped.load(std::memory_order_acquire) != 0; }
+
+		// whether a live snapshot, one of the scope's if given one or one in none, sees a state stamped so,
+		// until it's changed
+		bool IsSeen(const uint64_t stamp, const Scope* const scope = nullptr) const noexcept
+		{
+			const auto newest{ _newest.load(std::memory_order_acquire) };
+			return (newest && newest >= stamp) || (scope && scope->IsSeen(stamp));
+		}
+
+		// whether a live snapshot may see a state that was current from since until until; the live ones
+		// are known by their bounds only, so it's a maybe
+		bool IsSeen(const uint64_t since, const uint64_t until, const Scope* const scope = nullptr) const noexcept
+		{
+			const auto newest{ _newest.load(std::memory_order_acquire) };
+			return (newest && newest >= since && _oldest.load(std::memory_order_acquire) < until) || (scope && scope->IsSeen(since, until));
+		}
+
+	private:
+		// to be called under the lock
+		static void Insert(Scope& scope, const uint64_t time);
+		void Erase(Scope& scope, const uint64_t time);
+
+		// runs the keepers on the reclaimer's thread, as those lock what the one releasing may hold
+		void Prune(std::vector<std::weak_ptr<IKeeper>>&& kept);
+
+		static uint64_t& Pinned() noexcept
+		{
+			thread_local uint64_t pinned{ 0 };
+			return pinned;
+		}
+	};
+
+}
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef STORAGE_SNAPSHOTIMPL_H
+#define STORAGE_SNAPSHOTIMPL_H
+
+#include "BaseImpl.h"
+#include "SnapshotClock.h"
+
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
+
+namespace jb_storage
+{
+
+	struct ISnapshot
+	{
+		virtual ~ISnapshot() = default;
+
+		virtual std::optional<Value> Get(const utility::PathView& path) const = 0;
+		virtual std::optional<std::vector<std::string>> List(const utility::PathView& path, const size_t limit, const std::string_view after) const = 0;
+		virtual std::string Scan(const utility::PathView& path, const ScanCallback& callback, const std::string_view resume) const = 0;
+	};
+
+	// Reads go node by node as the live ones do, each node read either in its current state, under its lock,
+	// or in the past state it keeps for the time the snapshot was taken at (see INode::GetPast())
+	template < typename NodeType >
+	class SnapshotImpl final : public ISnapshot, private BaseImpl<NodeType>
+	{
+		using Base = BaseImpl<NodeType>;
+		using NodePtr = typename Base::NodePtr;
+		using Children = typename Base::Children;
+
+		// how ScanFrom() reads nodes as of the snapshot, those set to expire as of its tick
+		struct Access
+		{
+			uint64_t	Time;
+			int64_t		Tick;
+
+			NodePtr GetChild(const NodePtr& node, const std::string_view name) const
+			{ return Read(node, [this, name](const NodeType& view) { return view.FindChildAsOf(name, Tick); }); }
+
+			void ListChildren(const NodePtr& node, const std::string_view after, const size_t limit, Children& children) const
+			{ Read(node, [&](const NodeType& view) { view.ListChildrenAsOf(after, limit, children, Tick); }); }
+
+			std::optional<Value> GetValue(const NodePtr& node) const
+			{
+				const auto read = [](const NodeType& view) { return view.GetValue(); };
+				auto value{ Read(node, read) };
+
+				// an integer may be updated in place under a shared lock by someone who found no snapshot to
+				// keep the value for just before this one was taken, which the exclusive lock waits out
+				if (value && (std::holds_alternative<uint32_t>(*value) || std::holds_alternative<uint64_t>(*value)))
+					value = Read<std::unique_lock<NodeType>>(node, read);
+
+				return value;
+			}
+
+			template < typename Lock = std::shared_lock<NodeType>, typename Reader >
+			auto Read(const NodePtr& node, const Reader& reader) const
+			{
+				Lock lock{ *node };
+				const auto past{ node->FindPast(Time) };
+				return reader(past ? *past : *node);
+			}
+		};
+
+	private:
+		NodePtr									_root;
+		const utility::SnapshotClock::Lease		_lease;
+
+	public:
+		explicit SnapshotImpl(const NodePtr& root)
+			: Base{ root }, _root{ root }
+		{ }
+
+		std::optional<Value> Get(const utility::PathView& path) const override
+		{
+			STORAGE_TRACE_SPAN("Snapshot Get");
+
+			if (const NodePtr node{ Find(path) })
+				return Access{ _lease.GetTime(), _lease.GetTick() }.GetValue(node);
+
+			return std::nullopt;
+		}
+
+		std::optional<std::vector<std::string>> List(const utility::PathView& path, const size_t limit, const std::string_view after) const override
+		{
+			const NodePtr node{ Find(path) };
+			if (!node)
+				return std::nullopt;
+
+			Children children;
+			Access{ _lease.GetTime(), _lease.GetTick() }.ListChildren(node, after, limit ? limit : std::numeric_limits<size_t>::max(), children);
+
+			std::vector<std::string> names;
+			names.reserve(children.size());
+
+			for (auto& child : children)
+				names.push_back(std::move(child.first));
+
+			return names;
+		}
+
+		std::string Scan(const utility::PathView& path, const ScanCallback& callback, const std::string_view resume) const override
+		{
+			const NodePtr node{ Find(path) };
+			if (!node)
+				return { };
+
+			return Base::ScanFrom(node, callback, resume, Access{ _lease.GetTime(), _lease.GetTick() });
+		}
+
+	private:
+		NodePtr Find(const utility::PathView& path) const
+		{
+			const Access access{ _lease.GetTime(), _lease.GetTick() };
+
+			NodePtr node{ _root };
+			for (auto key{ path.begin() }, end{ path.end() }; key != end && node; ++key)
+				node = access.GetChild(node, *key);
+
+			return node;
+		}
+	};
+
+}
+
+#endif
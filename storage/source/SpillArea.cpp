@@ -0,0 +1,51 @@
+#include "SpillArea.h"
+
+namespace jb_storage
+{
+
+	bool SpillArea::Open(const std::string& path)
+	{
+		std::lock_guard lock{ _open_lock };
+		if (_file)
+			return true;
+
+		auto file{ std::make_unique<utility::SpillFile>(path) };
+		if (!file->IsOpen())
+			return false;
+
+		_file = std::move(file);
+		return true;
+	}
+
+	void SpillArea::Keep(const uint64_t footprint) noexcept
+	{
+		_evictions.fetch_add(1, std::memory_order_relaxed);
+		_subtrees.fetch_add(1, std::memory_order_relaxed);
+		_bytes.fetch_add(footprint, std::memory_order_relaxed);
+	}
+
+	void SpillArea::Read(const utility::SpillFile::Extent& extent, const uint64_t footprint, const std::function<void(std::istream&)>& read)
+	{
+		_file->Read(extent, read);
+		_fault_ins.fetch_add(1, std::memory_order_relaxed);
+		Forget(extent, footprint);
+	}
+
+	void SpillArea::Forget(const utility::SpillFile::Extent& extent, const uint64_t footprint) noexcept
+	{
+		_file->Free(extent);
+		_subtrees.fetch_sub(1, std::memory_order_relaxed);
+		_bytes.fetch_sub(footprint, std::memory_order_relaxed);
+	}
+
+	void SpillArea::GetStats(SpillStats& stats) const
+	{
+		stats.Evictions = _evictions.load(std::memory_order_relaxed);
+		stats.FaultIns = _fault_ins.load(std::memory_order_relaxed);
+		stats.Subtrees = _subtrees.load(std::memory_order_relaxed);
+		stats.Bytes = _bytes.load(std::memory_order_relaxed);
+		stats.FileBytes = _file ? _file->GetSize() : 0;
+		stats.DeadBytes = _file ? _file->GetDeadSize() : 0;
+	}
+
+}
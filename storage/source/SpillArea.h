@@ -0,0 +1,92 @@
+#ifndef STORAGE_SPILLAREA_H
+#define STORAGE_SPILLAREA_H
+
+#include "SpillFile.h"
+#include "Stats.h"
+#include "ValueStore.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+
+namespace jb_storage
+{
+
+	// Where the children of a volume's stubs are (see SpilledNode): the file, opened once a budget is
+	// set, and the counters Stats::Spill reports. Stubs keep the area, so that it outlives them.
+	class SpillArea final
+	{
+	private:
+		inline static std::atomic<uint32_t>			s_epoch{ 1 };	// of eviction passes, over all volumes
+
+		std::mutex									_open_lock;
+		std::unique_ptr<utility::SpillFile>			_file;
+		std::atomic<uint64_t>						_budget{ 0 };
+		std::atomic<bool>							_due{ false };	// a pass is scheduled and yet to start
+		std::mutex									_pass_lock;
+		std::mutex									_fault_lock;
+		const std::shared_ptr<utility::ValueStore>	_values;
+
+		std::atomic<uint64_t>						_evictions{ 0 };
+		std::atomic<uint64_t>						_fault_ins{ 0 };
+		std::atomic<uint64_t>						_subtrees{ 0 };
+		std::atomic<uint64_t>						_bytes{ 0 };
+
+	public:
+		// payloads read back are shared through the store
+		explicit SpillArea(std::shared_ptr<utility::ValueStore> values) noexcept : _values{ std::move(values) } { }
+
+		static uint32_t GetEpoch() noexcept		{ return s_epoch.load(std::memory_order_relaxed); }
+		static uint32_t NextEpoch() noexcept	{ return s_epoch.fetch_add(1, std::memory_order_relaxed) + 1; }
+
+		// the file is made on the first call, later ones find it there whatever the path
+		bool Open(const std::string& path);
+
+		void SetBudget(const uint64_t budget) noexcept	{ _budget.store(budget, std::memory_order_relaxed); }
+		uint64_t GetBudget() const noexcept				{ return _budget.load(std::memory_order_relaxed); }
+
+		// true for the one to schedule a pass, if none is due yet
+		bool MarkDue() noexcept		{ return !_due.exchange(true, std::memory_order_acq_rel); }
+		// as a pass starts, so that those finding the volume over budget meanwhile schedule another one
+		void ClearDue() noexcept	{ _due.store(false, std::memory_order_release); }
+
+		// held by an eviction pass, and by a save to keep passes off
+		std::mutex& GetPassLock() noexcept		{ return _pass_lock; }
+		// held by a stub reading its children back, so that it's done once
+		std::mutex& GetFaultLock() noexcept		{ return _fault_lock; }
+		utility::ValueStore* GetValues() const noexcept	{ return _values.get(); }
+
+		// the extent of a subtree written out, since the file is open by then; counted once a stub keeps it
+		std::optional<utility::SpillFile::Extent> Write(const std::function<void(std::ostream&)>& write)
+		{ return _file->Append(write); }
+
+		// a stub stands for the extent of a subtree of the footprint given from now on
+		void Keep(const uint64_t footprint) noexcept;
+
+		// a subtree written out that couldn't be spilled after all
+		void Discard(const utility::SpillFile::Extent& extent) noexcept
+		{ _file->Free(extent); }
+
+		void Read(const utility::SpillFile::Extent& extent, const uint64_t footprint, const std::function<void(std::istream&)>& read);
+
+		// reads the extent for a save, the subtree staying out there
+		void Copy(const utility::SpillFile::Extent& extent, const std::function<void(std::istream&)>& read)
+		{ _file->Read(extent, read); }
+
+		// a stub destroyed with its subtree out there, the extent left for the next to take
+		void Forget(const utility::SpillFile::Extent& extent, const uint64_t footprint) noexcept;
+
+		uint64_t GetBytes() const noexcept	{ return _bytes.load(std::memory_order_relaxed); }
+
+		void GetStats(SpillStats& stats) const;
+	};
+
+}
+
+#endif
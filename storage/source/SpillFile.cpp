@@ -0,0 +1,157 @@
+#include "SpillFile.h"
+
+#include <cstdio>
+#include <sstream>
+
+namespace jb_storage::utility
+{
+
+	SpillFile::SpillFile(std::string path)
+		: _stream{ path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc }, _path{ std::move(path) }
+	{ }
+
+	SpillFile::~SpillFile()
+	{
+		if (!IsOpen())
+			return;
+
+		_stream.close();
+		std::remove(_path.c_str());
+	}
+
+	// the extent is written to memory first, off the lock, for its size to pick the place by; the end moves on,
+	// or the free extent is taken, only once it's written in full, a failed one is written over by the next
+	std::optional<SpillFile::Extent> SpillFile::Append(const std::function<void(std::ostream&)>& write)
+	{
+		std::ostringstream buffer;
+		buffer.exceptions(std::ios::failbit | std::ios::badbit);
+
+		try
+		{ write(buffer); }
+		catch (const std::exception&)
+		{ return std::nullopt; }
+
+		const auto bytes{ buffer.str() };
+
+		std::lock_guard lock{ _lock };
+
+		_stream.clear();
+		_stream.exceptions(std::ios::failbit | std::ios::badbit);
+
+		std::optional<Extent> extent;
+		try
+		{
+			const auto fit{ _fits.lower_bound(bytes.size()) };
+			const uint64_t offset{ fit != _fits.end() ? fit->second : _end };
+
+			_stream.seekp(static_cast<std::streamoff>(offset));
+			_stream.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+			_stream.flush();
+
+			extent = Extent{ offset, bytes.size() };
+			if (fit != _fits.end())
+				Take(fit, bytes.size());
+			else
+				_end += bytes.size();
+		}
+		catch (const std::exception&)
+		{ }
+
+		_stream.exceptions(std::ios::goodbit);
+
+		return extent;
+	}
+
+	void SpillFile::Read(const Extent& extent, const std::function<void(std::istream&)>& read)
+	{
+		std::lock_guard lock{ _lock };
+
+		_stream.clear();
+		_stream.exceptions(std::ios::failbit | std::ios::badbit);
+
+		try
+		{
+			_stream.seekg(static_cast<std::streamoff>(extent.Offset));
+			read(_stream);
+		}
+		catch (...)
+		{
+			_stream.exceptions(std::ios::goodbit);
+			throw;
+		}
+
+		_stream.exceptions(std::ios::goodbit);
+	}
+
+	void SpillFile::Free(const Extent& extent) noexcept
+	{
+		try
+		{
+			std::lock_guard lock{ _lock };
+			Insert(extent.Offset, extent.Size);
+		}
+		catch (const std::exception&)
+		{ }
+	}
+
+	uint64_t SpillFile::GetSize() const
+	{
+		std::lock_guard lock{ _lock };
+		return _end;
+	}
+
+	uint64_t SpillFile::GetDeadSize() const
+	{
+		std::lock_guard lock{ _lock };
+		return _dead;
+	}
+
+	// the rest of the free extent past the size taken stays free
+	void SpillFile::Take(const std::multimap<uint64_t, uint64_t>::iterator fit, const uint64_t size)
+	{
+		const auto [free_size, offset] = *fit;
+
+		_fits.erase(fit);
+		_free.erase(offset);
+		_dead -= free_size;
+
+		if (free_size != size)
+			Insert(offset + size, free_size - size);
+	}
+
+	// merged with the free neighbours on either side
+	void SpillFile::Insert(uint64_t offset, uint64_t size)
+	{
+		const auto erase = [this](const std::map<uint64_t, uint64_t>::iterator free)
+		{
+			const auto [begin, end] = _fits.equal_range(free->second);
+			for (auto fit{ begin }; fit != end; ++fit)
+				if (fit->second == free->first)
+				{
+					_fits.erase(fit);
+					break;
+				}
+
+			_dead -= free->second;
+			_free.erase(free);
+		};
+
+		if (const auto next{ _free.find(offset + size) }; next != _free.end())
+		{
+			size += next->second;
+			erase(next);
+		}
+
+		if (auto previous{ _free.lower_bound(offset) }; previous != _free.begin() && (--previous)->first + previous->second == offset)
+		{
+			offset = previous->first;
+			size += previous->second;
+			erase(previous);
+		}
+
+		_free.emplace(offset, size);
+		_fits.emplace(size, offset);
+		_dead += size;
+	}
+
+}
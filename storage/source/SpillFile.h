@@ -0,0 +1,68 @@
+#ifndef STORAGE_SPILLFILE_H
+#define STORAGE_SPILLFILE_H
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <istream>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+
+namespace jb_storage::utility
+{
+
+	// File subtrees are spilled to (see Volume::SetMemoryBudget()): every extent is written once and read back
+	// as many times as asked. The space of those given up is reused by the smallest free extent an extent fits
+	// in, the rest of it kept free, or else the extent is appended. The file is made anew when opened and
+	// removed when closed.
+	class SpillFile final
+	{
+	public:
+		struct Extent
+		{
+			uint64_t	Offset{ 0 };
+			uint64_t	Size{ 0 };
+		};
+
+	private:
+		mutable std::mutex					_lock;
+		std::fstream						_stream;
+		const std::string					_path;
+		uint64_t							_end{ 0 };
+		std::map<uint64_t, uint64_t>		_free;		// sizes of free extents by offset, neighbours merged
+		std::multimap<uint64_t, uint64_t>	_fits;		// offsets of those by size
+		uint64_t							_dead{ 0 };	// bytes in them
+
+	public:
+		explicit SpillFile(std::string path);
+		~SpillFile();
+
+		SpillFile(const SpillFile&) = delete;
+		SpillFile& operator = (const SpillFile&) = delete;
+
+		bool IsOpen() const noexcept	{ return _stream.is_open(); }
+
+		// Extent of what the callback writes, nothing if it throws or the stream fails; streams throw on
+		// failure while they're handed over, the way Load() and Save() set them.
+		std::optional<Extent> Append(const std::function<void(std::ostream&)>& write);
+
+		// the callback reads the extent; a failure is thrown on
+		void Read(const Extent& extent, const std::function<void(std::istream&)>& read);
+
+		// the extent is given up, to be written over; space that can't be listed as free is lost to reuse
+		void Free(const Extent& extent) noexcept;
+
+		uint64_t GetSize() const;
+		uint64_t GetDeadSize() const;
+
+	private:
+		void Take(std::multimap<uint64_t, uint64_t>::iterator fit, uint64_t size);
+		void Insert(uint64_t offset, uint64_t size);
+	};
+
+}
+
+#endif
@@ -0,0 +1,126 @@
+#include "SpilledNode.h"
+
+#include "Metrics.h"
+#include "Reclaimer.h"
+
+#include <mutex>
+#include <vector>
+
+namespace jb_storage
+{
+
+	SpilledNode::SpilledNode(VolumeNode& node, std::shared_ptr<SpillArea> area, const utility::SpillFile::Extent& extent, const uint64_t footprint)
+		: _area{ std::move(area) }, _extent{ extent }, _footprint{ footprint }
+	{
+		Assign(std::move(node._value), std::move(node._payload));
+		_version.store(node._version.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		_stamp = node._stamp;
+		_usage_stamp = node._usage_stamp;
+		_access.store(node._access.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		_stub.store(true, std::memory_order_relaxed);
+	}
+
+	SpilledNode::~SpilledNode()
+	{
+		if (_stub.load(std::memory_order_relaxed))
+			_area->Forget(_extent, _footprint);
+	}
+
+	bool SpilledNode::Spill(VolumeNode& parent, const std::string_view name, NodePtr& child, const std::shared_ptr<SpillArea>& area)
+	{
+		std::unique_lock child_lock{ *child };
+		if (child->IsDetached() || child->_children.empty() || !CanSpill(*child))
+			return false;
+
+		std::vector<const VolumeNode*> stack{ child.get() };
+		while (!stack.empty())
+		{
+			const VolumeNode* const node{ stack.back() };
+			stack.pop_back();
+
+			for (const auto& entry : node->_children)
+			{
+				// whoever reaches a node pins it before letting go of its parent, and the lock taken in passing
+				// orders the reads below after the last change made through it
+				const NodePtr& below{ entry.second };
+				if (below.use_count() != 1)
+					return false;
+
+				if (std::unique_lock guard{ *below, std::try_to_lock }; !guard || !CanSpill(*below))
+					return false;
+
+				stack.push_back(below.get());
+			}
+		}
+
+		const uint64_t footprint{ GetFootprint(child->GetCounters()) - utility::GetValueSize(child->GetOwnValue()) };
+		const auto extent{ area->Write([&child](std::ostream& os) { child->Serialize(os); }) };
+		if (!extent)
+			return false;
+
+		std::unique_lock parent_lock{ parent, std::try_to_lock };
+		if (parent_lock && !parent.IsDetached() && child.use_count() == 2)
+			if (const auto entry{ parent._children.find(name) }; entry != parent._children.end() && entry->second == child)
+			{
+				// the totals are those that made it up to the parent, nothing below changes anymore
+				const auto usage{ child->Unlink() };
+				auto stub{ std::make_shared<SpilledNode>(*child, area, *extent, footprint) };
+				stub->SetTotals(usage.Nodes, usage.KeyBytes, usage.ValueBytes);
+				stub->SetParent(&parent);
+				entry->second = std::move(stub);
+				area->Keep(footprint);
+
+				child->Detach();
+				child_lock.unlock();
+				parent_lock.unlock();
+
+				// the nodes below are destroyed off the locks along with it
+				utility::Reclaimer::Instance().Retire(std::move(child));
+				return true;
+			}
+
+		area->Discard(*extent);
+		return false;
+	}
+
+	bool SpilledNode::CanSpill(const VolumeNode& node) noexcept
+	{
+		if (node.GetOrigin() || node._stub.load(std::memory_order_relaxed) || node.GetDeadline() || !node._past.empty())
+			return false;
+
+		const auto extra{ node.FindExtra() };
+		return !extra || extra->PastTotals.empty();
+	}
+
+	void SpilledNode::FaultIn()
+	{
+		std::lock_guard lock{ _area->GetFaultLock() };
+		if (!_stub.load(std::memory_order_relaxed))
+			return;
+
+		const auto creature{ std::make_shared<VolumeNode>() };
+		_area->Read(_extent, _footprint, [this, &creature](std::istream& is) { creature->Deserialize(is, _area->GetValues()); });
+
+		// the totals of this node count the children all along
+		_children.swap(creature->_children);
+		for (const auto& child : _children)
+			child.second->SetParent(this);
+
+		_stub.store(false, std::memory_order_release);
+	}
+
+	void SpilledNode::SerializeOwn(std::ostream& os, utility::SharedValueWriter& writer, const int64_t now, SerializedChildren& children) const
+	{
+		{
+			std::lock_guard lock{ _area->GetFaultLock() };
+			if (_stub.load(std::memory_order_relaxed))
+			{
+				_area->Copy(_extent, [&os, &writer](std::istream& is) { CopySerialized(is, writer, os); });
+				return;
+			}
+		}
+
+		VolumeNode::SerializeOwn(os, writer, now, children);
+	}
+
+}
@@ -0,0 +1,56 @@
+#ifndef STORAGE_SPILLEDNODE_H
+#define STORAGE_SPILLEDNODE_H
+
+#include "SpillArea.h"
+#include "SpillFile.h"
+#include "VolumeNode.h"
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string_view>
+
+namespace jb_storage
+{
+
+	// A stub, put in place of a node whose children are spilled to disk (see Spill()) with its value, totals
+	// and stamp; the node itself goes off with the nodes below. The children are read back on first touch,
+	// the stub going on as a plain node from then on.
+	class SpilledNode final : public VolumeNode
+	{
+		using NodePtr = std::shared_ptr<VolumeNode>;
+
+	private:
+		const std::shared_ptr<SpillArea>	_area;
+		const utility::SpillFile::Extent	_extent;
+		const uint64_t						_footprint;
+
+	public:
+		// takes over what the node has besides its children and totals; the node is out of anyone else's reach
+		SpilledNode(VolumeNode& node, std::shared_ptr<SpillArea> area, const utility::SpillFile::Extent& extent, const uint64_t footprint);
+		~SpilledNode() override;
+
+		// Writes the subtree of the child out and puts a stub in its place in the parent; to be called with
+		// the child pinned and nothing locked. Nothing's done unless the child and every node below it are out
+		// of anyone else's reach, kept for no snapshot, set to expire never, and neither a stub nor a node of
+		// a clone, since the nodes read back are made anew. The parent is locked ahead of its children by
+		// everyone else, so it's only tried once the subtree is out, and the child is to be where it was then.
+		// Returns whether it's done, the child being let go of then.
+		static bool Spill(VolumeNode& parent, const std::string_view name, NodePtr& child, const std::shared_ptr<SpillArea>& area);
+
+	private:
+		// to be called with the node locked
+		static bool CanSpill(const VolumeNode& node) noexcept;
+
+		// the first of those touching the stub reads the children back, the others wait for it; it stays a stub
+		// if reading fails, for the next touch to try again
+		void FaultIn() override;
+
+		// the subtree is copied from the file as it is, nothing read back; it's not to be forgotten meanwhile
+		void SerializeOwn(std::ostream& os, utility::SharedValueWriter& writer, const int64_t now, SerializedChildren& children) const override;
+	};
+
+}
+
+#endif
@@ -0,0 +1,82 @@
+#include "Spiller.h"
+
+#include "Reclaimer.h"
+#include "SnapshotClock.h"
+
+namespace jb_storage::utility
+{
+
+	Spiller& Spiller::Instance()
+	{
+		static Spiller instance;
+		return instance;
+	}
+
+	// the singletons passes use are made first, so that they outlive the thread
+	Spiller::Spiller()
+		: _busy{ false }, _stop{ false }
+	{
+		SnapshotClock::Instance();
+		Reclaimer::Instance();
+
+		_thread = std::thread{ [this]() { Run(); } };
+	}
+
+	Spiller::~Spiller()
+	{
+		{
+			std::lock_guard lock{ _lock };
+			_stop = true;
+		}
+
+		_wakeup.notify_one();
+		_thread.join();
+	}
+
+	void Spiller::Schedule(Pass&& pass)
+	{
+		{
+			std::lock_guard lock{ _lock };
+			_passes.push_back(std::move(pass));
+		}
+
+		_wakeup.notify_one();
+	}
+
+	void Spiller::Drain()
+	{
+		std::unique_lock lock{ _lock };
+		_drained.wait(lock, [this]() { return _passes.empty() && !_busy; });
+	}
+
+	void Spiller::Run()
+	{
+		for (std::unique_lock lock{ _lock }; ; )
+		{
+			_wakeup.wait(lock, [this]() { return _stop || !_passes.empty(); });
+
+			if (_stop)
+			{
+				_passes.clear();
+				_drained.notify_all();
+				return;
+			}
+
+			Pass pass{ std::move(_passes.front()) };
+			_passes.pop_front();
+			_busy = true;
+
+			lock.unlock();
+			try
+			{ pass(); }
+			catch (...)
+			{ } // a pass that fails leaves the volume over budget, for the next one to try again
+			pass = nullptr;
+			lock.lock();
+
+			_busy = false;
+			_drained.notify_all();
+		}
+	}
+
+}
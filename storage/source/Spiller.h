@@ -0,0 +1,50 @@
+#ifndef STORAGE_SPILLER_H
+#define STORAGE_SPILLER_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace jb_storage::utility
+{
+
+	// Background thread running eviction passes of volumes over their memory budgets, one at a time and in
+	// the order they're asked for, so that no operation pays for a walk of the tree or a write to disk: one
+	// that finds its volume over budget only schedules a pass, if there's none due yet (see VolumeImpl).
+	// Passes still due once the thread stops are dropped.
+	class Spiller final
+	{
+		using Pass = std::function<void()>;
+
+	private:
+		std::mutex				_lock;
+		std::condition_variable	_wakeup;
+		std::condition_variable	_drained;
+		std::deque<Pass>		_passes;
+		bool					_busy;
+		bool					_stop;
+		std::thread				_thread;
+
+	public:
+		static Spiller& Instance();
+
+		Spiller();
+		~Spiller();
+
+		Spiller(const Spiller&) = delete;
+		Spiller& operator = (const Spiller&) = delete;
+
+		void Schedule(Pass&& pass);
+
+		// waits until every pass scheduled so far is run
+		void Drain();
+
+	private:
+		void Run();
+	};
+
+}
+
+#endif
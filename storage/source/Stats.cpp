@@ -0,0 +1,97 @@
+#include "Stats.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace jb_storage
+{
+
+	namespace
+	{
+
+		constexpr unsigned	SubBucketBits{ 4 };
+		constexpr uint64_t	SubBucketCount{ uint64_t{ 1 } << SubBucketBits };
+		constexpr uint64_t	ExactLimit{ SubBucketCount * 2 };
+		constexpr unsigned	MaxShift{ (LatencyHistogram::BucketCount - ExactLimit) / SubBucketCount };
+		constexpr uint64_t	MaxValue{ (uint64_t{ 1 } << (MaxShift + SubBucketBits + 1)) - 1 };
+
+		static_assert(ExactLimit + MaxShift * SubBucketCount == LatencyHistogram::BucketCount);
+
+		unsigned GetMostSignificantBit(uint64_t value) noexcept
+		{
+			unsigned result{ 0 };
+			for (unsigned shift{ 32 }; shift; shift /= 2)
+				if (value >> shift)
+				{
+					value >>= shift;
+					result += shift;
+				}
+
+			return result;
+		}
+
+	}
+
+	void LatencyHistogram::Record(const uint64_t value) noexcept
+	{
+		++_buckets[GetBucketIndex(value)];
+
+		_min = _count ? std::min(_min, value) : value;
+		_max = std::max(_max, value);
+		_sum += value;
+		++_count;
+	}
+
+	void LatencyHistogram::Merge(const LatencyHistogram& other) noexcept
+	{
+		if (!other._count)
+			return;
+
+		for (size_t i{ 0 }; i < BucketCount; ++i)
+			_buckets[i] += other._buckets[i];
+
+		_min = _count ? std::min(_min, other._min) : other._min;
+		_max = std::max(_max, other._max);
+		_sum += other._sum;
+		_count += other._count;
+	}
+
+	uint64_t LatencyHistogram::GetPercentile(const double percentile) const noexcept
+	{
+		if (!_count)
+			return 0;
+
+		const auto share{ std::clamp(percentile, 0., 100.) / 100. };
+		const auto rank{ std::max(uint64_t{ 1 }, static_cast<uint64_t>(std::ceil(share * _count))) };
+
+		uint64_t seen{ 0 };
+		for (size_t i{ 0 }; i < BucketCount; ++i)
+			if ((seen += _buckets[i]) >= rank)
+				return std::clamp(GetBucketUpperBound(i), _min, _max);
+
+		return _max;
+	}
+
+	size_t LatencyHistogram::GetBucketIndex(const uint64_t value) noexcept
+	{
+		if (value < ExactLimit)
+			return static_cast<size_t>(value);
+
+		const auto clamped{ std::min(value, MaxValue) };
+		const auto shift{ GetMostSignificantBit(clamped) - SubBucketBits };
+
+		return static_cast<size_t>(ExactLimit + (shift - 1) * SubBucketCount + ((clamped >> shift) - SubBucketCount));
+	}
+
+	uint64_t LatencyHistogram::GetBucketUpperBound(const size_t index) noexcept
+	{
+		if (index < ExactLimit)
+			return index;
+
+		const auto shift{ (index - ExactLimit) / SubBucketCount + 1 };
+		const auto sub_bucket{ (index - ExactLimit) % SubBucketCount + SubBucketCount };
+
+		return ((sub_bucket + 1) << shift) - 1;
+	}
+
+}
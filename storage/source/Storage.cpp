@@ -1,10 +1,16 @@
 #include "Storage.h"
 
 #include "Mutex.h"
+#include "SnapshotImpl.h"
+#include "Tracing.h"
+#include "TransactionImpl.h"
 #include "VolumeImpl.h"
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include <map>
+#include <tuple>
 
 namespace jb_storage
 {
@@ -26,6 +32,11 @@ namespace jb_storage
 				_node = volume->GetNode(path);
 			}
 
+			// for views of snapshots, which keep no volume in use
+			explicit MountHolder(INodePtr&& node) noexcept
+				: _node{ std::move(node) }
+			{ }
+
 			MountHolder(MountHolder&&) = default;
 
 			~MountHolder()
@@ -48,8 +59,10 @@ namespace jb_storage
 
 		public:
 			void lock()				{ _lock.lock(); }
+			bool try_lock()			{ return _lock.try_lock(); }
 			void unlock()			{ _lock.unlock(); }
 			void lock_shared()		{ _lock.lock_shared();}
+			bool try_lock_shared()	{ return _lock.try_lock_shared(); }
 			void unlock_shared()	{ _lock.unlock_shared();}
 
 		};
@@ -74,6 +87,14 @@ namespace jb_storage
 				return std::nullopt;
 			}
 
+			const Value* PeekValue() const override
+			{
+				if (!_mounted.empty())
+					return _mounted.back()->GetNode()->PeekValue();
+
+				return nullptr;
+			}
+
 			bool GrowBranchAndSetValue(const utility::PathView& path, Value&& value) override
 			{
 				if (!_mounted.empty())
@@ -82,29 +103,113 @@ namespace jb_storage
 				return false;
 			}
 
+			std::optional<bool> UpdateValue(const std::function<bool(Value&)>& update, const bool exclusive) override
+			{
+				if (!_mounted.empty())
+					return _mounted.back()->GetNode()->UpdateValue(update, exclusive);
+
+				return false;
+			}
+
 			INodePtr GetChild(const std::string_view name) const override
+			{ return GetChildWithHolder(name).first; }
+
+			INodePtr GetChildAsOf(const std::string_view name, const int64_t tick) const override
 			{
 				for (auto rmounted{ _mounted.rbegin() }, rend{ _mounted.rend() }; rmounted != rend; ++rmounted)
-					if (const INodePtr child{ (*rmounted)->GetNode()->GetChild(name) })
+					if (INodePtr child{ (*rmounted)->GetNode()->GetChildAsOf(name, tick) })
 						return child;
 
 				return GetVirtualChild(name);
 			}
 
-			bool DeleteChild(const std::string_view name) override
+			INodePtr DetachChild(const std::string_view name) override
 			{
 				for (auto rmounted{ _mounted.rbegin() }, rend{ _mounted.rend() }; rmounted != rend; ++rmounted)
-					if ((*rmounted)->GetNode()->DeleteChild(name))
-						return true;
+					if (INodePtr child{ (*rmounted)->GetNode()->DetachChild(name) })
+						return child;
 
 				// std::map::erase with equivalent key comparison appears in c++23 only
 				if (const auto child{ _virtual_children.find(name) }; child != _virtual_children.end())
 				{
+					INodePtr detached{ std::move(child->second) };
 					_virtual_children.erase(child);
-					return true;
+
+					detached->Detach();
+					return detached;
 				}
 
-				return false;
+				return nullptr;
+			}
+
+			void ListChildren(const std::string_view after, const size_t limit, INodeChildren& children) const override
+			{ MergeChildren(after, limit, children, [&](const INode& node, INodeChildren& layer) { node.ListChildren(after, limit, layer); }); }
+
+			void ListChildrenAsOf(const std::string_view after, const size_t limit, INodeChildren& children, const int64_t tick) const override
+			{ MergeChildren(after, limit, children, [&](const INode& node, INodeChildren& layer) { node.ListChildrenAsOf(after, limit, layer, tick); }); }
+
+			void CollectChildren(std::vector<INodePtr>& children) const override
+			{
+				INodeChildren listed;
+				ListChildren({ }, std::numeric_limits<size_t>::max(), listed);
+
+				for (auto& child : listed)
+					children.push_back(std::move(child.second));
+			}
+
+			// mounts are summed up as they are, entries shadowed by other layers included
+			Usage GetUsage() const override
+			{
+				Usage usage;
+
+				for (const auto& mounted : _mounted)
+				{
+					const auto mounted_usage{ mounted->GetNode()->GetUsage() };
+					usage.Nodes += mounted_usage.Nodes;
+					usage.KeyBytes += mounted_usage.KeyBytes;
+					usage.ValueBytes += mounted_usage.ValueBytes;
+				}
+
+				for (const auto& [name, child] : _virtual_children)
+				{
+					std::shared_lock lock{ *child };
+					const auto child_usage{ child->GetUsage() };
+					usage.Nodes += child_usage.Nodes + 1;
+					usage.KeyBytes += child_usage.KeyBytes + name.size();
+					usage.ValueBytes += child_usage.ValueBytes;
+				}
+
+				return usage;
+			}
+
+			// nothing of a virtual node itself is ever read through transactions, they go by the mounted ones
+			uint64_t GetVersion() const override
+			{ return 0; }
+
+			// A view merging the mounts as the snapshot sees them, which are the very nodes mounted where they
+			// haven't changed since, and virtual children as they are: mounts are not a part of snapshots.
+			// The view reads these without locking, while this node is kept locked.
+			INodePtr GetPast(const uint64_t time) const override
+			{
+				const auto view{ std::make_shared<VirtualNode>() };
+
+				for (const auto& mounted : _mounted)
+					if (INodePtr past{ mounted->GetNode()->GetPast(time) })
+						view->Mount(std::make_shared<MountHolder>(std::move(past)));
+					else
+						view->Mount(MountHolderPtr{ mounted });
+
+				view->_virtual_children = _virtual_children;
+
+				return view;
+			}
+
+			bool CollectMountedNodes(std::vector<INodePtr>& nodes) const override
+			{
+				for (auto rmounted{ _mounted.rbegin() }, rend{ _mounted.rend() }; rmounted != rend; ++rmounted)
+					nodes.push_back((*rmounted)->GetNode());
+
+				return true;
 			}
 
 			void lock() override
@@ -113,6 +218,24 @@ namespace jb_storage
 				std::for_each(_mounted.begin(), _mounted.end(), [](const auto& mounted) { mounted->GetNode()->lock(); } );
 			}
 
+			bool try_lock() override
+			{
+				if (!NonPolymorphicBase::try_lock())
+					return false;
+
+				for (size_t i{ 0 }; i < _mounted.size(); ++i)
+					if (!_mounted[i]->GetNode()->try_lock())
+					{
+						while (i)
+							_mounted[--i]->GetNode()->unlock();
+
+						NonPolymorphicBase::unlock();
+						return false;
+					}
+
+				return true;
+			}
+
 			void unlock() override
 			{
 				std::for_each(_mounted.rbegin(), _mounted.rend(), [](const auto& mounted) { mounted->GetNode()->unlock(); } );
@@ -125,6 +248,24 @@ namespace jb_storage
 				std::for_each(_mounted.begin(), _mounted.end(), [](const auto& mounted) { mounted->GetNode()->lock_shared(); } );
 			}
 
+			bool try_lock_shared() override
+			{
+				if (!NonPolymorphicBase::try_lock_shared())
+					return false;
+
+				for (size_t i{ 0 }; i < _mounted.size(); ++i)
+					if (!_mounted[i]->GetNode()->try_lock_shared())
+					{
+						while (i)
+							_mounted[--i]->GetNode()->unlock_shared();
+
+						NonPolymorphicBase::unlock_shared();
+						return false;
+					}
+
+				return true;
+			}
+
 			void unlock_shared() override
 			{
 				std::for_each(_mounted.rbegin(), _mounted.rend(), [](const auto& mounted) { mounted->GetNode()->unlock_shared(); } );
@@ -157,6 +298,18 @@ namespace jb_storage
 				return nullptr; //avoid using shared_from_this() here
 			}
 
+			// same as GetChild() but also tells which mount the child comes from, if any
+			std::pair<INodePtr, MountHolderPtr> GetChildWithHolder(const std::string_view name) const
+			{
+				STORAGE_TRACE_SPAN("resolve mount");
+
+				for (auto rmounted{ _mounted.rbegin() }, rend{ _mounted.rend() }; rmounted != rend; ++rmounted)
+					if (INodePtr child{ (*rmounted)->GetNode()->GetChild(name) })
+						return { std::move(child), *rmounted };
+
+				return { GetVirtualChild(name), nullptr };
+			}
+
 			VirtualNodePtr GetVirtualChild(const std::string_view name) const
 			{
 				const auto child{ _virtual_children.find(name) };
@@ -176,22 +329,82 @@ namespace jb_storage
 
 			void Mount(MountHolderPtr&& holder)
 			{ _mounted.push_back(std::move(holder)); }
+
+			// layers are merged by priority as GetChildWithHolder() resolves names: mounts from the newest one,
+			// then own virtual children; since every layer is sorted, limit children from each are enough
+			template < typename Lister >
+			void MergeChildren(const std::string_view after, const size_t limit, INodeChildren& children, const Lister& list) const
+			{
+				std::vector<INodeChildren> layers(_mounted.size() + 1);
+
+				for (size_t i{ 0 }, size{ _mounted.size() }; i < size; ++i)
+					list(*_mounted[size - 1 - i]->GetNode(), layers[i]);
+
+				auto child{ _virtual_children.upper_bound(after) };
+				for (size_t added{ 0 }; child != _virtual_children.end() && added < limit; ++child, ++added)
+					layers.back().emplace_back(child->first, child->second);
+
+				std::vector<size_t> heads(layers.size(), 0);
+				for (size_t added{ 0 }; added < limit; ++added)
+				{
+					std::optional<size_t> winner;
+					for (size_t i{ 0 }, size{ layers.size() }; i < size; ++i)
+						if (heads[i] < layers[i].size() && (!winner || layers[i][heads[i]].first < layers[*winner][heads[*winner]].first))
+							winner = i;
+
+					if (!winner)
+						break;
+
+					auto& entry{ layers[*winner][heads[*winner]++] };
+
+					// same name in layers of lower priority is shadowed
+					for (size_t i{ *winner + 1 }, size{ layers.size() }; i < size; ++i)
+						if (heads[i] < layers[i].size() && layers[i][heads[i]].first == entry.first)
+							++heads[i];
+
+					children.push_back(std::move(entry));
+				}
+			}
 		};
 
 	}
 
-	class Storage::Impl final : public BaseImpl
+	class Storage::Impl final : public BaseImpl<INode>, public std::enable_shared_from_this<Storage::Impl>
 	{
 		using MountTokenImplPtr = MountToken::MountTokenImplPtr;
 
 	private:
-		VirtualNodePtr	_root;
+		VirtualNodePtr						_root;
+		mutable utility::ConcurrencyLimiter	_limiter;
+		mutable utility::Metrics			_metrics;
 
 	public:
 		Impl() : Impl{ std::make_shared<VirtualNode>() } { };
 
+		std::optional<Value> Get(const utility::PathView& path) const
+		{ return _metrics.Measure(utility::Operation::Get, [&]() { return BaseImpl::Get(path); }); }
+
+		bool Delete(const utility::PathView& path) const
+		{ return _metrics.Measure(utility::Operation::Delete, [&]() { return BaseImpl::Delete(path); }); }
+
+		bool SetOrInsert(const utility::PathView& path, Value&& value) const
+		{ return _metrics.Measure(utility::Operation::SetOrInsert, [&]() { return BaseImpl::SetOrInsert(path, std::move(value)); }); }
+
 		MountTokenImplPtr Mount(const std::string_view where, const VolumeImplPtr& volume, const std::string_view what) const;
 
+		IHandlePtr Open(const std::string_view path) const;
+
+		std::unique_ptr<ITransaction> BeginTransaction() const
+		{ return std::make_unique<TransactionImpl<INode>>(_root, weak_from_this()); }
+
+		std::unique_ptr<const ISnapshot> TakeSnapshot() const
+		{ return std::make_unique<SnapshotImpl<INode>>(_root); }
+
+		utility::ConcurrencyLimiter& GetLimiter() const noexcept { return _limiter; }
+
+		void EnableStats(const bool enable) const { _metrics.Enable(enable); }
+		Stats GetStats() const { return _metrics.GetStats(); }
+
 	private:
 		Impl(VirtualNodePtr&& root) noexcept : BaseImpl{ root }, _root{ std::move(root) } { }
 	};
@@ -230,7 +443,7 @@ namespace jb_storage
 
 			GrowBranchAndSetValue<VirtualNodePtr, VirtualNodeNonPolymorphicLockMixin>(
 					_root,
-					where,
+					utility::PathView{ where },
 					[](const VirtualNodePtr& storage_node, const std::string_view name) { return storage_node->GetVirtualChild(name); },
 					[&holderPtr, &ownerWeak](const VirtualNodePtr& storage_node, const utility::PathView& path)
 					{
@@ -245,6 +458,36 @@ namespace jb_storage
 		return nullptr;
 	}
 
+	IHandlePtr Storage::Impl::Open(const std::string_view path) const
+	{
+		const utility::PathView view{ path };
+		std::vector<INodePtr> branch{ _root };
+		MountHolderPtr holder;
+
+		for (const auto& key : view)
+		{
+			const INodePtr current{ branch.back() };
+			utility::SharedLock lock{ *current, view, branch.size() - 1 };
+
+			INodePtr child;
+			if (holder) // we're inside of mounted volume already
+				child = current->GetChild(key);
+			else
+				std::tie(child, holder) = std::static_pointer_cast<VirtualNode>(current)->GetChildWithHolder(key);
+
+			if (!child)
+				return nullptr;
+
+			branch.push_back(std::move(child));
+		}
+
+		std::weak_ptr<const void> owner{ weak_from_this() };
+		if (holder)
+			owner = holder;
+
+		return std::make_shared<HandleImpl<INode>>(std::move(branch), std::move(owner));
+	}
+
 	Storage::MountToken::operator bool () const noexcept
 	{ return !!_impl; }
 
@@ -253,24 +496,93 @@ namespace jb_storage
 	{ }
 
 	Storage::Storage()
-		: _impl{ std::make_unique<Impl>() }
+		: _impl{ std::make_shared<Impl>() }
 	{ }
 
 	Storage::~Storage() = default;
 
 	std::optional<Value> Storage::Get(const std::string_view path) const
-	{ return _impl->Get(path); }
+	{ return _impl->Get(utility::PathView{ path }); }
 
 	bool Storage::SetOrInsert(const std::string_view path, const Value& value) const
-	{ return _impl->SetOrInsert(path, Value{ value }); }
+	{ return _impl->SetOrInsert(utility::PathView{ path }, Value{ value }); }
 
 	bool Storage::SetOrInsert(const std::string_view path, Value&& value) const
-	{ return _impl->SetOrInsert(path, std::move(value)); }
+	{ return _impl->SetOrInsert(utility::PathView{ path }, std::move(value)); }
 
 	bool Storage::Delete(const std::string_view path) const
-	{ return _impl->Delete(path); }
+	{ return _impl->Delete(utility::PathView{ path }); }
+
+	std::optional<Value> Storage::Get(const PathSegments path) const
+	{ return _impl->Get(utility::PathView{ path }); }
+
+	bool Storage::SetOrInsert(const PathSegments path, const Value& value) const
+	{ return utility::PathView::IsValid(path) && _impl->SetOrInsert(utility::PathView{ path }, Value{ value }); }
+
+	bool Storage::SetOrInsert(const PathSegments path, Value&& value) const
+	{ return utility::PathView::IsValid(path) && _impl->SetOrInsert(utility::PathView{ path }, std::move(value)); }
+
+	bool Storage::Delete(const PathSegments path) const
+	{ return _impl->Delete(utility::PathView{ path }); }
+
+	bool Storage::CompareAndSwap(const std::string_view path, const uint32_t expected, const uint32_t desired) const
+	{ return _impl->CompareAndSwap(utility::PathView{ path }, expected, desired); }
+
+	bool Storage::CompareAndSwap(const std::string_view path, const uint64_t expected, const uint64_t desired) const
+	{ return _impl->CompareAndSwap(utility::PathView{ path }, expected, desired); }
+
+	std::optional<uint32_t> Storage::FetchAdd(const std::string_view path, const uint32_t delta) const
+	{ return _impl->FetchAdd(utility::PathView{ path }, delta); }
+
+	std::optional<uint64_t> Storage::FetchAdd(const std::string_view path, const uint64_t delta) const
+	{ return _impl->FetchAdd(utility::PathView{ path }, delta); }
+
+	std::optional<std::vector<std::string>> Storage::List(const std::string_view path, const size_t limit, const std::string_view after) const
+	{ return _impl->List(utility::PathView{ path }, limit, after); }
+
+	std::string Storage::Scan(const std::string_view path, const ScanCallback& callback, const std::string_view resume) const
+	{ return _impl->Scan(utility::PathView{ path }, callback, resume); }
+
+	size_t Storage::Glob(const std::string_view pattern, const ScanCallback& callback) const
+	{ return _impl->Glob(utility::PathView{ pattern }, callback); }
+
+	std::optional<double> Storage::Aggregate(const std::string_view path, const Aggregation aggregation) const
+	{ return _impl->Aggregate(utility::PathView{ path }, aggregation); }
+
+	std::optional<Usage> Storage::GetUsage(const std::string_view path) const
+	{ return _impl->GetUsage(utility::PathView{ path }); }
+
+	Handle Storage::Open(const std::string_view path) const
+	{ return Handle{ _impl->Open(path) }; }
+
+	Transaction Storage::BeginTransaction() const
+	{ return Transaction{ _impl->BeginTransaction() }; }
+
+	Snapshot Storage::Snapshot() const
+	{ return jb_storage::Snapshot{ _impl->TakeSnapshot() }; }
 
 	Storage::MountToken Storage::Mount(const std::string_view where, const Volume& volume, const std::string_view what) const
 	{ return MountToken{ _impl->Mount(where, volume._impl, what) }; }
 
+	std::future<std::optional<Value>> Storage::GetAsync(const std::string_view path) const
+	{ return _impl->GetLimiter().Async([impl = _impl, path = std::string{ path }]() { return impl->Get(utility::PathView{ path }); }); }
+
+	std::future<bool> Storage::SetOrInsertAsync(const std::string_view path, Value value) const
+	{
+		return _impl->GetLimiter().Async([impl = _impl, path = std::string{ path }, value = std::move(value)]() mutable
+		{ return impl->SetOrInsert(utility::PathView{ path }, std::move(value)); });
+	}
+
+	std::future<bool> Storage::DeleteAsync(const std::string_view path) const
+	{ return _impl->GetLimiter().Async([impl = _impl, path = std::string{ path }]() { return impl->Delete(utility::PathView{ path }); }); }
+
+	void Storage::SetAsyncConcurrency(const size_t limit) const
+	{ _impl->GetLimiter().SetLimit(limit); }
+
+	void Storage::EnableStats(const bool enable) const
+	{ _impl->EnableStats(enable); }
+
+	Stats Storage::GetStats() const
+	{ return _impl->GetStats(); }
+
 }
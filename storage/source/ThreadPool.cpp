@@ -0,0 +1,249 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace jb_storage::utility
+{
+
+	namespace
+	{
+
+		thread_local const ThreadPool* current_pool{ nullptr };
+		thread_local size_t current_worker{ 0 };
+
+	}
+
+	ThreadPool& ThreadPool::Instance()
+	{
+		static ThreadPool instance{ std::max(2u, std::thread::hardware_concurrency()) };
+		return instance;
+	}
+
+	ThreadPool::ThreadPool(const size_t concurrency)
+		: _pending{ 0 }, _next{ 0 }, _stop{ false }
+	{
+		for (size_t i{ 0 }; i < concurrency; ++i)
+			_workers.push_back(std::make_unique<Worker>());
+
+		for (size_t i{ 0 }; i < concurrency; ++i)
+			_threads.emplace_back([this, i]() { Run(i); });
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard lock{ _sleep_lock };
+			_stop = true;
+		}
+
+		_wakeup.notify_all();
+
+		for (auto& thread : _threads)
+			thread.join();
+	}
+
+	void ThreadPool::Submit(Task&& task)
+	{
+		const auto index{ current_pool == this ? current_worker : _next.fetch_add(1, std::memory_order_relaxed) % _workers.size() };
+
+		{
+			Worker& worker{ *_workers[index] };
+			std::lock_guard lock{ worker.Lock };
+			worker.Tasks.push_back(std::move(task));
+		}
+
+		_pending.fetch_add(1, std::memory_order_release);
+
+		{ std::lock_guard lock{ _sleep_lock }; } // a worker is either before its predicate check or waiting already
+		_wakeup.notify_one();
+	}
+
+	std::optional<Task> ThreadPool::Take(const size_t self)
+	{
+		if (!_pending.load(std::memory_order_acquire))
+			return std::nullopt;
+
+		for (size_t i{ 0 }, size{ _workers.size() }; i < size; ++i)
+		{
+			Worker& worker{ *_workers[(self + i) % size] };
+			std::lock_guard lock{ worker.Lock };
+
+			if (!worker.Tasks.empty())
+			{
+				// own deque is served LIFO to keep caches warm, victims are robbed FIFO
+				Task task{ std::move(i ? worker.Tasks.front() : worker.Tasks.back()) };
+				i ? worker.Tasks.pop_front() : worker.Tasks.pop_back();
+
+				_pending.fetch_sub(1, std::memory_order_relaxed);
+				return task;
+			}
+		}
+
+		return std::nullopt;
+	}
+
+	void ThreadPool::Run(const size_t self)
+	{
+		current_pool = this;
+		current_worker = self;
+
+		for (;;)
+		{
+			if (auto task{ Take(self) })
+			{
+				try
+				{ (*task)(); }
+				catch (...)
+				{ } // tasks report their failures through futures, nothing sane to do here
+
+				continue;
+			}
+
+			std::unique_lock lock{ _sleep_lock };
+			_wakeup.wait(lock, [this]() { return _stop || _pending.load(std::memory_order_acquire); });
+
+			if (_stop && !_pending.load(std::memory_order_acquire))
+				return;
+		}
+	}
+
+	void TaskGroup::Submit(Task&& task)
+	{
+		_pending.fetch_add(1, std::memory_order_relaxed);
+
+		{
+			std::lock_guard lock{ _queue->Lock };
+			_queue->Tasks.push_back([this, task = std::move(task)]()
+			{
+				if (!IsCancelled())
+					try
+					{ task(); }
+					catch (...)
+					{ Fail(std::current_exception()); }
+
+				Finish();
+			});
+		}
+
+		ThreadPool::Instance().Submit([queue = _queue]()
+		{
+			if (auto task{ queue->Take() })
+				(*task)();
+		});
+	}
+
+	void TaskGroup::Fail(std::exception_ptr&& error)
+	{
+		{
+			std::lock_guard lock{ _lock };
+			if (!_error)
+				_error = std::move(error);
+		}
+
+		Cancel();
+	}
+
+	void TaskGroup::Wait()
+	{
+		Finish();
+
+		// help with the group's own tasks until none is queued; those left are running elsewhere by then, and
+		// the last one to finish wakes us up
+		while (auto task{ _queue->Take() })
+			(*task)();
+
+		std::unique_lock lock{ _lock };
+		_done.wait(lock, [this]() { return !_pending.load(std::memory_order_acquire); });
+
+		if (_error)
+			std::rethrow_exception(_error);
+	}
+
+	std::optional<Task> TaskGroup::Queue::Take()
+	{
+		std::lock_guard lock{ Lock };
+		if (Tasks.empty())
+			return std::nullopt;
+
+		Task task{ std::move(Tasks.front()) };
+		Tasks.pop_front();
+
+		return task;
+	}
+
+	// the count drops under the lock, so that the waiter, which checks it under the lock as well, can't see it
+	// drop and destroy the group before the last one is done with it
+	void TaskGroup::Finish()
+	{
+		std::lock_guard lock{ _lock };
+		if (_pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			_done.notify_all();
+	}
+
+	void ConcurrencyLimiter::SetLimit(const size_t limit)
+	{
+		std::vector<Task> released;
+
+		{
+			std::lock_guard lock{ _lock };
+			_limit = limit;
+
+			while (!_queued.empty() && (!_limit || _running < _limit))
+			{
+				released.push_back(std::move(_queued.front()));
+				_queued.pop_front();
+				++_running;
+			}
+		}
+
+		for (auto& task : released)
+			Launch(std::move(task));
+	}
+
+	void ConcurrencyLimiter::Submit(Task&& task)
+	{
+		{
+			std::lock_guard lock{ _lock };
+
+			if (_limit && _running >= _limit)
+			{
+				_queued.push_back(std::move(task));
+				return;
+			}
+
+			++_running;
+		}
+
+		Launch(std::move(task));
+	}
+
+	void ConcurrencyLimiter::Launch(Task&& task)
+	{
+		ThreadPool::Instance().Submit([this, task = std::move(task)]()
+		{
+			task();
+			OnFinished();
+		});
+	}
+
+	void ConcurrencyLimiter::OnFinished()
+	{
+		Task next;
+
+		{
+			std::lock_guard lock{ _lock };
+
+			if (_queued.empty() || (_limit && _running > _limit))
+			{
+				--_running;
+				return;
+			}
+
+			next = std::move(_queued.front());
+			_queued.pop_front();
+		}
+
+		Launch(std::move(next));
+	}
+
+}
@@ -0,0 +1,136 @@
+#ifndef STORAGE_THREADPOOL_H
+#define STORAGE_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace jb_storage::utility
+{
+
+	using Task = std::function<void()>;
+
+	// Work-stealing pool shared by all volumes and storages: every worker serves its own deque from the back
+	// and, once it runs dry, steals from the front of the others. Tasks submitted by a worker go to its own deque.
+	class ThreadPool final
+	{
+		struct Worker
+		{
+			std::mutex			Lock;
+			std::deque<Task>	Tasks;
+		};
+
+	private:
+		std::vector<std::unique_ptr<Worker>>	_workers;
+		std::vector<std::thread>				_threads;
+		std::atomic<size_t>						_pending;
+		std::atomic<size_t>						_next;
+		std::mutex								_sleep_lock;
+		std::condition_variable					_wakeup;
+		bool									_stop;
+
+	public:
+		static ThreadPool& Instance();
+
+		explicit ThreadPool(const size_t concurrency);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator = (const ThreadPool&) = delete;
+
+		size_t GetConcurrency() const noexcept { return _workers.size(); }
+
+		void Submit(Task&& task);
+
+	private:
+		std::optional<Task> Take(const size_t self);
+		void Run(const size_t self);
+	};
+
+	// Tasks of one parallel operation: the caller does its own share of the work, submits the rest to the
+	// pool and then waits for all of them, running those of its own still queued meanwhile. Whoever submits
+	// a task must keep the group alive until the task finishes, e.g. by capturing its owner in the task.
+	class TaskGroup final
+	{
+		// Tasks are queued here and the pool is handed a runner for each, which takes whichever is next, if
+		// any: a waiter runs the group's tasks only, never those of anyone else. Runners keep the queue, as
+		// some may come up after the group is gone, with nothing left to take.
+		struct Queue
+		{
+			std::mutex			Lock;
+			std::deque<Task>	Tasks;
+
+			std::optional<Task> Take();
+		};
+
+	private:
+		const std::shared_ptr<Queue>	_queue{ std::make_shared<Queue>() };
+		std::atomic<size_t>				_pending{ 1 };	// the caller's own share counts too
+		std::atomic<bool>				_cancelled{ false };
+		std::mutex						_lock;
+		std::condition_variable			_done;
+		std::exception_ptr				_error;
+
+	public:
+		// the first exception a task throws cancels the group and is rethrown by Wait()
+		void Submit(Task&& task);
+
+		void Cancel() noexcept { _cancelled.store(true, std::memory_order_relaxed); }
+		bool IsCancelled() const noexcept { return _cancelled.load(std::memory_order_relaxed); }
+
+		size_t GetPending() const noexcept { return _pending.load(std::memory_order_relaxed); }
+
+		void Fail(std::exception_ptr&& error);
+
+		// to be called once, when the caller's own share is done
+		void Wait();
+
+	private:
+		void Finish();
+	};
+
+	// Caps the number of tasks of one owner running in the pool at once; tasks above the limit are queued
+	// here in submission order rather than occupying workers.
+	class ConcurrencyLimiter final
+	{
+	private:
+		std::mutex			_lock;
+		std::deque<Task>	_queued;
+		size_t				_running{ 0 };
+		size_t				_limit{ 0 };
+
+	public:
+		// 0 means no limit
+		void SetLimit(const size_t limit);
+
+		void Submit(Task&& task);
+
+		template < typename Function >
+		auto Async(Function&& function) -> std::future<std::invoke_result_t<std::decay_t<Function>&>>
+		{
+			using Result = std::invoke_result_t<std::decay_t<Function>&>;
+
+			const auto task{ std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function)) };
+			auto future{ task->get_future() };
+			Submit([task]() { (*task)(); });
+
+			return future;
+		}
+
+	private:
+		void Launch(Task&& task);
+		void OnFinished();
+	};
+
+}
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef STORAGE_THREADSLOTS_H
+#define STORAGE_THREADSLOTS_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace jb_storage::utility
+{
+
+	// Objects threads record into without contending, such as tables of counters, one per thread: a thread
+	// takes a slot on its first record and gives it back once it finishes, for the next thread to go on with,
+	// contents and all. So there are as many slots as threads recording at once, rather than as threads ever
+	// started; they're kept until destruction, for their contents to be read meanwhile.
+	template < typename T >
+	class ThreadSlots final
+	{
+	private:
+		mutable std::mutex				_lock;
+		std::vector<std::unique_ptr<T>>	_slots;
+		std::vector<T*>					_free;		// of finished threads
+
+	public:
+		// a free slot if there's one, otherwise one made anew, given the number of those made before it
+		template < typename Make >
+		T& Acquire(const Make& make)
+		{
+			std::lock_guard lock{ _lock };
+
+			if (!_free.empty())
+			{
+				T& slot{ *_free.back() };
+				_free.pop_back();
+				return slot;
+			}
+
+			auto slot{ make(_slots.size()) };
+			_free.reserve(_slots.size() + 1);
+			return *_slots.emplace_back(std::move(slot));
+		}
+
+		T& Acquire()
+		{ return Acquire([](size_t) { return std::make_unique<T>(); }); }
+
+		// there's room for every slot, so that nothing is allocated as a thread finishes
+		void Release(T& slot) noexcept
+		{
+			std::lock_guard lock{ _lock };
+			_free.push_back(&slot);
+		}
+
+		// every slot made so far, whether taken or not; no slot is added meanwhile
+		template < typename Function >
+		void ForEach(Function&& function) const
+		{
+			std::lock_guard lock{ _lock };
+			for (const auto& slot : _slots)
+				function(*slot);
+		}
+	};
+
+	// The slot of a thread for as long as it runs, to be kept thread_local; the slots are kept alive by it, so
+	// that they outlive every thread whatever order statics are destroyed in.
+	template < typename T >
+	class ThreadSlot final
+	{
+	private:
+		const std::shared_ptr<ThreadSlots<T>>	_slots;
+		T&										_slot;
+
+	public:
+		template < typename... Make >
+		explicit ThreadSlot(std::shared_ptr<ThreadSlots<T>> slots, const Make&... make)
+			: _slots{ std::move(slots) }, _slot{ _slots->Acquire(make...) }
+		{ }
+
+		~ThreadSlot() { _slots->Release(_slot); }
+
+		ThreadSlot(const ThreadSlot&) = delete;
+		ThreadSlot& operator = (const ThreadSlot&) = delete;
+
+		T& Get() const noexcept { return _slot; }
+	};
+
+}
+
+#endif
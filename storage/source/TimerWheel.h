@@ -0,0 +1,140 @@
+#ifndef STORAGE_TIMERWHEEL_H
+#define STORAGE_TIMERWHEEL_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace jb_storage::utility
+{
+
+	// milliseconds of the steady clock, the ticks timer wheels count
+	inline int64_t GetTick() noexcept
+	{ return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+
+	// Hierarchical timing wheel: level l has s_slots slots of s_slots^l ticks each, a timer goes to the lowest
+	// level whose span covers its deadline and is moved down a level once the wheel reaches the slot it's in,
+	// timers beyond the top level wait in an overflow list. Scheduling is O(1), and so is advancing by a tick
+	// but for the timers moved down. Not thread safe.
+	template < typename Entry >
+	class TimerWheel final
+	{
+	private:
+		static constexpr size_t s_bits{ 6 };
+		static constexpr size_t s_slots{ size_t{ 1 } << s_bits };
+		static constexpr size_t s_levels{ 5 };	// 2^30 ticks, about 12 days of milliseconds
+
+		struct Timer
+		{
+			int64_t	Deadline;
+			Entry	Item;
+		};
+
+		using Slot = std::vector<Timer>;
+
+		std::array<std::array<Slot, s_slots>, s_levels>	_levels;
+		Slot												_overflow;
+		Slot												_due;		// scheduled for the past
+		int64_t												_now;		// the last tick advanced to
+		size_t												_size{ 0 };
+
+	public:
+		explicit TimerWheel(const int64_t now) noexcept : _now{ now } { }
+
+		size_t GetSize() const noexcept	{ return _size; }
+
+		void Schedule(const int64_t deadline, Entry&& item)
+		{
+			++_size;
+			Place(Timer{ deadline, std::move(item) });
+		}
+
+		// moves the wheel on to now, adding the entries due by then
+		void Advance(const int64_t now, std::vector<Entry>& due)
+		{
+			Fire(_due, due);
+
+			// nothing to go through on the way
+			if (!_size)
+				_now = std::max(_now, now);
+
+			while (_now < now)
+			{
+				const auto tick{ ++_now };
+
+				// down from the top, so that timers moved from a level reach the lower ones in the same tick
+				if (!(tick & GetMask(s_levels)))
+					Cascade(_overflow);
+
+				for (size_t level{ s_levels }; --level > 0; )
+					if (!(tick & GetMask(level)))
+						Cascade(_levels[level][GetIndex(tick, level)]);
+
+				Fire(_levels[0][GetIndex(tick, 0)], due);
+				Fire(_due, due);
+			}
+		}
+
+		// the tick to advance to next for anything to fire or move down, nothing if there are no timers
+		std::optional<int64_t> GetNextTick() const noexcept
+		{
+			if (!_size)
+				return std::nullopt;
+
+			if (!_due.empty())
+				return _now;
+
+			// the rest of the rotation of the lowest level, after which the levels above may move timers down
+			const int64_t boundary{ (_now | static_cast<int64_t>(s_slots - 1)) + 1 };
+			for (auto tick{ _now + 1 }; tick < boundary; ++tick)
+				if (!_levels[0][GetIndex(tick, 0)].empty())
+					return tick;
+
+			return boundary;
+		}
+
+	private:
+		static constexpr int64_t GetMask(const size_t level) noexcept
+		{ return (int64_t{ 1 } << (s_bits * level)) - 1; }
+
+		static size_t GetIndex(const int64_t tick, const size_t level) noexcept
+		{ return static_cast<size_t>(tick >> (s_bits * level)) & (s_slots - 1); }
+
+		void Place(Timer&& timer)
+		{
+			if (timer.Deadline <= _now)
+				return _due.push_back(std::move(timer));
+
+			const auto delta{ timer.Deadline - _now };
+			for (size_t level{ 0 }; level < s_levels; ++level)
+				if (delta <= GetMask(level + 1))
+					return _levels[level][GetIndex(timer.Deadline, level)].push_back(std::move(timer));
+
+			_overflow.push_back(std::move(timer));
+		}
+
+		void Cascade(Slot& slot)
+		{
+			Slot timers;
+			timers.swap(slot);
+
+			for (auto& timer : timers)
+				Place(std::move(timer));
+		}
+
+		void Fire(Slot& slot, std::vector<Entry>& due)
+		{
+			for (auto& timer : slot)
+				due.push_back(std::move(timer.Item));
+
+			_size -= slot.size();
+			slot.clear();
+		}
+	};
+
+}
+
+#endif
@@ -0,0 +1,211 @@
+#include "Tracer.h"
+
+#include "Tracing.h"
+
+#ifdef STORAGE_TRACING
+#include "ThreadSlots.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+#endif
+
+namespace jb_storage
+{
+
+#ifdef STORAGE_TRACING
+	namespace utility
+	{
+
+		namespace
+		{
+
+			constexpr size_t RingCapacity{ 16384 };
+
+			// Every slot is a seqlock: its sequence is odd while the owning thread rewrites it, so a reader
+			// skips slots being rewritten or rewritten while it was reading. Fields are relaxed atomics,
+			// which cost the writer nothing extra on common hardware.
+			struct Slot
+			{
+				std::atomic<uint64_t>		Sequence{ 0 };
+				std::atomic<const char*>	Name{ nullptr };
+				std::atomic<uint64_t>		Begin{ 0 };
+				std::atomic<uint64_t>		End{ 0 };
+				std::atomic<uint64_t>		Argument{ 0 };
+			};
+
+			struct Event
+			{
+				const char*	Name;
+				uint64_t	Begin;
+				uint64_t	End;
+				uint64_t	Argument;
+			};
+
+			// single producer (the owning thread), any number of readers
+			class Ring final
+			{
+			private:
+				std::array<Slot, RingCapacity>	_slots;
+				std::atomic<uint64_t>			_written{ 0 };
+				std::atomic<uint64_t>			_discarded{ 0 };
+				const size_t					_thread_id;
+
+			public:
+				explicit Ring(const size_t thread_id) noexcept : _thread_id{ thread_id } { }
+
+				size_t GetThreadId() const noexcept { return _thread_id; }
+
+				void Push(const char* const name, const uint64_t begin, const uint64_t end, const uint64_t argument) noexcept
+				{
+					const auto index{ _written.load(std::memory_order_relaxed) };
+					Slot& slot{ _slots[index % RingCapacity] };
+
+					const auto sequence{ slot.Sequence.load(std::memory_order_relaxed) };
+					slot.Sequence.store(sequence + 1, std::memory_order_relaxed);
+					std::atomic_thread_fence(std::memory_order_release);
+
+					slot.Name.store(name, std::memory_order_relaxed);
+					slot.Begin.store(begin, std::memory_order_relaxed);
+					slot.End.store(end, std::memory_order_relaxed);
+					slot.Argument.store(argument, std::memory_order_relaxed);
+
+					slot.Sequence.store(sequence + 2, std::memory_order_release);
+					_written.store(index + 1, std::memory_order_release);
+				}
+
+				std::vector<Event> Read() const
+				{
+					const auto written{ _written.load(std::memory_order_acquire) };
+					const auto discarded{ _discarded.load(std::memory_order_relaxed) };
+					const auto first{ std::max(discarded, written > RingCapacity ? written - RingCapacity : 0) };
+
+					std::vector<Event> events;
+					events.reserve(written - first);
+
+					for (auto index{ first }; index < written; ++index)
+					{
+						const Slot& slot{ _slots[index % RingCapacity] };
+
+						const auto before{ slot.Sequence.load(std::memory_order_acquire) };
+						if (before & 1)
+							continue;
+
+						const Event event
+						{
+							slot.Name.load(std::memory_order_relaxed),
+							slot.Begin.load(std::memory_order_relaxed),
+							slot.End.load(std::memory_order_relaxed),
+							slot.Argument.load(std::memory_order_relaxed)
+						};
+
+						std::atomic_thread_fence(std::memory_order_acquire);
+						if (slot.Sequence.load(std::memory_order_relaxed) == before && event.Name)
+							events.push_back(event);
+					}
+
+					return events;
+				}
+
+				// events written so far are not reported anymore
+				void Discard() noexcept
+				{ _discarded.store(_written.load(std::memory_order_acquire), std::memory_order_relaxed); }
+			};
+
+			// Rings of threads tracing (see ThreadSlots), which outlive them for the events to be dumped. The id
+			// of a ring is a lane in the trace: a ring taken over holds events of the thread before, all of them
+			// over by then.
+			using Registry = ThreadSlots<Ring>;
+
+			const std::shared_ptr<Registry>& GetRegistry()
+			{
+				static const auto registry{ std::make_shared<Registry>() };
+				return registry;
+			}
+
+			Ring& GetThreadRing()
+			{
+				thread_local const ThreadSlot<Ring> ring{ GetRegistry(), [](const size_t made) { return std::make_unique<Ring>(made + 1); } };
+				return ring.Get();
+			}
+
+			// rings are read off the registry's lock, none is destroyed before it
+			std::vector<const Ring*> GetRings()
+			{
+				std::vector<const Ring*> rings;
+				GetRegistry()->ForEach([&rings](const Ring& ring) { rings.push_back(&ring); });
+
+				return rings;
+			}
+
+			const auto epoch{ std::chrono::steady_clock::now() };
+
+			void WriteMicroseconds(std::ostream& os, const uint64_t nanoseconds)
+			{
+				const auto fraction{ nanoseconds % 1000 };
+				os << nanoseconds / 1000 << '.' << static_cast<char>('0' + fraction / 100) << static_cast<char>('0' + fraction / 10 % 10) << static_cast<char>('0' + fraction % 10);
+			}
+
+		}
+
+		std::atomic<bool> tracer_enabled{ false };
+
+		uint64_t GetTraceTime() noexcept
+		{ return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count()); }
+
+		void RecordSpan(const char* const name, const uint64_t begin, const uint64_t end, const uint64_t argument) noexcept
+		{ GetThreadRing().Push(name, begin, end, argument); }
+
+	}
+
+	bool Tracer::IsAvailable() noexcept
+	{ return true; }
+
+	void Tracer::Enable(const bool enable) noexcept
+	{ utility::tracer_enabled.store(enable, std::memory_order_relaxed); }
+
+	void Tracer::Dump(std::ostream& os)
+	{
+		os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+		bool first{ true };
+		for (const auto ring : utility::GetRings())
+			for (const auto& event : ring->Read())
+			{
+				os << (first ? "\n" : ",\n") << "{\"name\":\"" << event.Name << "\",\"cat\":\"storage\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->GetThreadId() << ",\"ts\":";
+				utility::WriteMicroseconds(os, event.Begin);
+				os << ",\"dur\":";
+				utility::WriteMicroseconds(os, event.End - event.Begin);
+
+				if (event.Argument != utility::TraceSpan::NoArgument)
+					os << ",\"args\":{\"depth\":" << event.Argument << '}';
+
+				os << '}';
+				first = false;
+			}
+
+		os << "\n]}\n";
+	}
+
+	void Tracer::Reset()
+	{
+		utility::GetRegistry()->ForEach([](utility::Ring& ring) { ring.Discard(); });
+	}
+#else
+	bool Tracer::IsAvailable() noexcept
+	{ return false; }
+
+	void Tracer::Enable(const bool) noexcept
+	{ }
+
+	void Tracer::Dump(std::ostream& os)
+	{ os << "{\"traceEvents\":[]}\n"; }
+
+	void Tracer::Reset()
+	{ }
+#endif
+
+}
@@ -0,0 +1,60 @@
+#ifndef STORAGE_TRACING_H
+#define STORAGE_TRACING_H
+
+#ifdef STORAGE_TRACING
+#include <atomic>
+#include <cstdint>
+
+namespace jb_storage::utility
+{
+
+	extern std::atomic<bool> tracer_enabled;
+
+	uint64_t GetTraceTime() noexcept;
+
+	void RecordSpan(const char* const name, const uint64_t begin, const uint64_t end, const uint64_t argument) noexcept;
+
+	// Scope reported to Tracer as a complete event; name must be a string literal
+	class TraceSpan final
+	{
+	public:
+		static constexpr uint64_t NoArgument{ ~uint64_t{ 0 } };
+
+	private:
+		const char*	_name{ nullptr };
+		uint64_t	_begin{ 0 };
+		uint64_t	_argument{ NoArgument };
+
+	public:
+		explicit TraceSpan(const char* const name, const uint64_t argument = NoArgument) noexcept
+		{
+			if (tracer_enabled.load(std::memory_order_relaxed))
+			{
+				_name = name;
+				_argument = argument;
+				_begin = GetTraceTime();
+			}
+		}
+
+		~TraceSpan()
+		{
+			if (_name)
+				RecordSpan(_name, _begin, GetTraceTime(), _argument);
+		}
+
+		TraceSpan(const TraceSpan&) = delete;
+		TraceSpan& operator = (const TraceSpan&) = delete;
+	};
+
+}
+
+#define STORAGE_TRACE_CONCAT_IMPL(a, b) a##b
+#define STORAGE_TRACE_CONCAT(a, b) STORAGE_TRACE_CONCAT_IMPL(a, b)
+
+// STORAGE_TRACE_SPAN(name[, argument]) traces the rest of the enclosing scope, argument is a depth
+#define STORAGE_TRACE_SPAN(...) const ::jb_storage::utility::TraceSpan STORAGE_TRACE_CONCAT(trace_span_, __LINE__){ __VA_ARGS__ }
+#else
+#define STORAGE_TRACE_SPAN(...) static_cast<void>(0)
+#endif
+
+#endif
@@ -0,0 +1,28 @@
+#include "Transaction.h"
+
+#include "TransactionImpl.h"
+
+namespace jb_storage
+{
+
+	Transaction::Transaction(Transaction&&) noexcept = default;
+	Transaction& Transaction::operator = (Transaction&&) noexcept = default;
+	Transaction::~Transaction() = default;
+
+	std::optional<Value> Transaction::Get(const std::string_view path)
+	{ return _impl->Get(path); }
+
+	bool Transaction::SetOrInsert(const std::string_view path, Value value)
+	{ return _impl->SetOrInsert(path, std::move(value)); }
+
+	bool Transaction::Delete(const std::string_view path)
+	{ return _impl->Delete(path); }
+
+	bool Transaction::Commit()
+	{ return _impl->Commit(); }
+
+	Transaction::Transaction(std::unique_ptr<ITransaction>&& impl) noexcept
+		: _impl{ std::move(impl) }
+	{ }
+
+}
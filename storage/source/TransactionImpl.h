@@ -0,0 +1,499 @@
+#ifndef STORAGE_TRANSACTIONIMPL_H
+#define STORAGE_TRANSACTIONIMPL_H
+
+#include "BaseImpl.h"
+#include "Reclaimer.h"
+#include "SnapshotClock.h"
+#include "Tracing.h"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace jb_storage
+{
+
+	struct ITransaction
+	{
+		virtual ~ITransaction() = default;
+
+		virtual std::optional<Value> Get(const std::string_view path) = 0;
+		virtual bool SetOrInsert(const std::string_view path, Value&& value) = 0;
+		virtual bool Delete(const std::string_view path) = 0;
+		virtual bool Commit() = 0;
+	};
+
+	// Optimistic concurrency: every read remembers the version of the node it was served by (of the deepest
+	// existing one, if the path was missing), a node's version changes with its value or set of children.
+	// Commit locks those nodes shared and the ones writes land on exclusively, in address order, checks
+	// the versions and applies the writes. The nodes along the paths are to be neither detached nor moved
+	// since, or the paths lead elsewhere by now. Nodes of a storage are never locked, the mounted ones
+	// behind them are, so mounting and unmounting meanwhile goes unnoticed.
+	template < typename NodeType >
+	class TransactionImpl final : public ITransaction, private BaseImpl<NodeType>
+	{
+		using Base = BaseImpl<NodeType>;
+		using NodePtr = typename Base::NodePtr;
+
+		struct Read
+		{
+			NodePtr		Node;
+			uint64_t	Version;
+		};
+
+		// a node along a path, with the times it had been moved once reached (see INode::GetMoves())
+		struct Passed
+		{
+			NodePtr		Node;
+			uint32_t	Moves;
+		};
+
+		struct Write
+		{
+			std::string				Path;		// canonical, see GetCanonical()
+			std::optional<Value>	Content;	// nothing for a delete
+		};
+
+		using Sets = std::map<std::string, Value>;
+
+		// where writes land, resolved anew on every attempt to commit
+		struct Removal
+		{
+			NodePtr				Parent;
+			std::string_view	Name;
+		};
+
+		struct Insertion
+		{
+			NodePtr				Node;		// the deepest existing one along the path
+			size_t				Depth;		// of that node
+			Sets::value_type*	Set;
+		};
+
+		struct Plan
+		{
+			std::vector<Passed>		Branches;	// to stay attached and in place
+			std::vector<Removal>	Removals;
+			std::vector<Insertion>	Insertions;
+		};
+
+		// taken the way std::lock() does, waiting for one lock at a time with no other one held, so that
+		// the order others lock nodes in doesn't matter
+		class Locks final
+		{
+		private:
+			std::vector<std::pair<NodePtr, bool>>	_nodes;	// exclusively or not
+
+		public:
+			explicit Locks(std::vector<std::pair<NodePtr, bool>>&& nodes)
+				: _nodes{ std::move(nodes) }
+			{
+				std::sort(_nodes.begin(), _nodes.end(), [](const auto& left, const auto& right) { return left.first.get() < right.first.get(); });
+
+				// a node both read and written is locked once, exclusively
+				size_t size{ 0 };
+				for (size_t i{ 0 }; i < _nodes.size(); ++i)
+					if (size && _nodes[size - 1].first == _nodes[i].first)
+						_nodes[size - 1].second |= _nodes[i].second;
+					else
+						_nodes[size++] = std::move(_nodes[i]);
+
+				_nodes.resize(size);
+
+				for (size_t first{ 0 }, count{ _nodes.size() }; count; )
+				{
+					Lock(first);
+
+					size_t locked{ 1 };
+					while (locked < count && TryLock((first + locked) % count))
+						++locked;
+
+					if (locked == count)
+						break;
+
+					const size_t busy{ (first + locked) % count };
+					while (locked)
+						Unlock((first + --locked) % count);
+
+					first = busy;
+					std::this_thread::yield();
+				}
+			}
+
+			~Locks()
+			{
+				for (size_t i{ _nodes.size() }; i; --i)
+					Unlock(i - 1);
+			}
+
+			Locks(const Locks&) = delete;
+			Locks& operator = (const Locks&) = delete;
+
+		private:
+			void Lock(const size_t index)
+			{
+				auto& [node, exclusive] = _nodes[index];
+				exclusive ? node->lock() : node->lock_shared();
+			}
+
+			bool TryLock(const size_t index)
+			{
+				auto& [node, exclusive] = _nodes[index];
+				return exclusive ? node->try_lock() : node->try_lock_shared();
+			}
+
+			void Unlock(const size_t index)
+			{
+				auto& [node, exclusive] = _nodes[index];
+				exclusive ? node->unlock() : node->unlock_shared();
+			}
+		};
+
+	private:
+		std::weak_ptr<const void>	_owner;
+		std::vector<Read>			_reads;
+		std::vector<Passed>			_branches;	// the reads were served through
+		std::vector<Write>			_writes;
+
+	public:
+		TransactionImpl(const NodePtr& root, std::weak_ptr<const void>&& owner) noexcept
+			: Base{ root }, _owner{ std::move(owner) }
+		{ }
+
+		std::optional<Value> Get(const std::string_view path) override
+		{
+			const auto parsed{ utility::PathView::TryParse(path) };
+			if (!parsed)
+				return std::nullopt;
+
+			const auto canonical{ GetCanonical(*parsed) };
+
+			// the latest own write that tells decides, a path set below makes the node exist
+			bool implied{ false };
+			for (auto write{ _writes.rbegin() }, rend{ _writes.rend() }; write != rend; ++write)
+			{
+				if (write->Path == canonical)
+					return write->Content || !implied ? write->Content : Value{ };
+
+				if (!write->Content && IsUnder(write->Path, canonical))
+					return implied ? std::optional<Value>{ Value{ } } : std::nullopt;
+
+				implied = implied || (write->Content && IsUnder(canonical, write->Path));
+			}
+
+			auto value{ ReadThrough(*parsed) };
+			return value || !implied ? value : Value{ };
+		}
+
+		bool SetOrInsert(const std::string_view path, Value&& value) override
+		{
+			const auto parsed{ utility::PathView::TryParse(path) };
+			if (!parsed)
+				return false;
+
+			_writes.push_back(Write{ GetCanonical(*parsed), std::move(value) });
+			return true;
+		}
+
+		bool Delete(const std::string_view path) override
+		{
+			const auto parsed{ utility::PathView::TryParse(path) };
+			if (!parsed || parsed->IsEmpty())
+				return false;
+
+			_writes.push_back(Write{ GetCanonical(*parsed), std::nullopt });
+			return true;
+		}
+
+		bool Commit() override
+		{
+			STORAGE_TRACE_SPAN("Commit");
+
+			const auto reads{ std::exchange(_reads, { }) };
+			const auto branches{ std::exchange(_branches, { }) };
+
+			const auto owner{ _owner.lock() };
+			if (!owner)
+				return false;
+
+			std::vector<std::string> deletes;
+			Sets sets;
+			Collapse(std::exchange(_writes, { }), deletes, sets);
+
+			for (;;)
+			{
+				Plan plan;
+				if (!Resolve(deletes, sets, plan))
+					return false;
+
+				std::vector<std::pair<NodePtr, bool>> nodes;
+				for (const auto& read : reads)
+					nodes.emplace_back(read.Node, false);
+				for (const auto& removal : plan.Removals)
+					nodes.emplace_back(removal.Parent, true);
+				for (const auto& insertion : plan.Insertions)
+					nodes.emplace_back(insertion.Node, true);
+
+				std::vector<INodePtr> detached;
+				{
+					const Locks locks{ std::move(nodes) };
+
+					if (!IsInPlace(branches))
+						return false;
+
+					if (std::any_of(reads.begin(), reads.end(), [](const Read& read) { return read.Node->GetVersion() != read.Version; }))
+						return false;
+
+					// the tree changed where writes land, which no read depends on: they're resolved again
+					if (!IsStillValid(plan, deletes))
+						continue;
+
+					Apply(plan, detached);
+				}
+
+				// retired off the locks, as one may be destroyed in place
+				for (auto& node : detached)
+					utility::Reclaimer::Instance().Retire(std::move(node));
+
+				return true;
+			}
+		}
+
+	private:
+		std::optional<Value> ReadThrough(const utility::PathView& path)
+		{
+			for (;;)
+			{
+				std::vector<uint32_t> moves;
+				auto branch{ Base::GetExistingBranch(path, &moves) };
+				const NodePtr node{ branch.back() };
+				const bool found{ branch.size() == path.GetDepth() + 1 };
+
+				std::shared_lock lock{ *node };
+
+				// the version must be one the absence was seen at
+				if (!found && node->FindChild(path[branch.size() - 1]))
+					continue;
+
+				std::vector<INodePtr> mounted;
+				if (!node->CollectMountedNodes(mounted))
+					_reads.push_back(Read{ node, node->GetVersion() });
+
+				for (const auto& mounted_node : mounted)
+					_reads.push_back(Read{ std::static_pointer_cast<NodeType>(mounted_node), mounted_node->GetVersion() });
+
+				Pass(std::move(branch), moves, _branches);
+
+				return found ? node->GetValue() : std::nullopt;
+			}
+		}
+
+		bool Resolve(const std::vector<std::string>& deletes, Sets& sets, Plan& plan) const
+		{
+			for (const auto& path : deletes)
+			{
+				const auto separator{ path.rfind('/') };
+				const std::string_view name{ std::string_view{ path }.substr(separator + 1) };
+
+				std::vector<uint32_t> moves;
+				auto branch{ Base::GetExistingBranch(utility::PathView{ separator ? path.substr(0, separator) : "/" }, &moves) };
+				if (branch.size() != static_cast<size_t>(std::count(path.begin(), path.end(), '/')))
+					continue; // nothing to delete
+
+				NodePtr parent{ branch.back() };
+				{
+					std::shared_lock lock{ *parent };
+
+					std::vector<INodePtr> mounted;
+					if (parent->CollectMountedNodes(mounted))
+					{
+						const auto owner{ std::find_if(mounted.begin(), mounted.end(), [name](const INodePtr& node) { return !!node->GetChild(name); }) };
+						if (owner == mounted.end())
+						{
+							// nodes made by a storage to reach mount points aren't for transactions to delete
+							if (parent->FindChild(name))
+								return false;
+
+							continue;
+						}
+
+						parent = std::static_pointer_cast<NodeType>(*owner);
+						branch.push_back(parent);
+						moves.push_back(parent->GetMoves());
+					}
+				}
+
+				plan.Removals.push_back(Removal{ parent, name });
+				Pass(std::move(branch), moves, plan.Branches);
+			}
+
+			for (auto& set : sets)
+			{
+				const utility::PathView path{ set.first };
+				std::vector<uint32_t> moves;
+				auto branch{ Base::GetExistingBranch(path, &moves) };
+
+				// nodes deleted by the transaction itself count as missing
+				std::string prefix;
+				for (size_t depth{ 1 }; depth < branch.size(); ++depth)
+				{
+					(prefix += '/') += path[depth - 1];
+					if (std::binary_search(deletes.begin(), deletes.end(), prefix))
+					{
+						branch.resize(depth);
+						moves.resize(depth);
+						break;
+					}
+				}
+
+				const size_t depth{ branch.size() - 1 };
+				NodePtr node{ branch.back() };
+				{
+					std::shared_lock lock{ *node };
+
+					std::vector<INodePtr> mounted;
+					if (node->CollectMountedNodes(mounted))
+					{
+						// as SetOrInsert() through a storage does, the newest mount takes the write
+						if (mounted.empty())
+							return false;
+
+						node = std::static_pointer_cast<NodeType>(mounted.front());
+						branch.push_back(node);
+						moves.push_back(node->GetMoves());
+					}
+				}
+
+				plan.Insertions.push_back(Insertion{ node, depth, &set });
+				Pass(std::move(branch), moves, plan.Branches);
+			}
+
+			return true;
+		}
+
+		static bool IsStillValid(const Plan& plan, const std::vector<std::string>& deletes)
+		{
+			if (!IsInPlace(plan.Branches))
+				return false;
+
+			// a missing child that showed up is fine only if it's to be deleted first
+			for (const auto& insertion : plan.Insertions)
+			{
+				const utility::PathView path{ insertion.Set->first };
+				if (insertion.Depth == path.GetDepth() || !insertion.Node->FindChild(path[insertion.Depth]))
+					continue;
+
+				std::string prefix;
+				for (size_t depth{ 0 }; depth <= insertion.Depth; ++depth)
+					(prefix += '/') += path[depth];
+
+				if (!std::binary_search(deletes.begin(), deletes.end(), prefix))
+					return false;
+			}
+
+			return true;
+		}
+
+		static void Pass(std::vector<NodePtr>&& branch, const std::vector<uint32_t>& moves, std::vector<Passed>& passed)
+		{
+			for (size_t i{ 0 }; i < branch.size(); ++i)
+				passed.push_back(Passed{ std::move(branch[i]), moves[i] });
+		}
+
+		static bool IsInPlace(const std::vector<Passed>& passed)
+		{ return std::none_of(passed.begin(), passed.end(), [](const Passed& node) { return node.Node->IsDetached() || node.Node->GetMoves() != node.Moves; }); }
+
+		// nodes walked through below the deepest existing ones were made by the transaction itself, reachable
+		// only through nodes it keeps locked; the subtrees deleted are handed over to the caller
+		static void Apply(const Plan& plan, std::vector<INodePtr>& detached)
+		{
+			const utility::SnapshotClock::Pin pin;
+
+			for (const auto& removal : plan.Removals)
+				if (INodePtr node{ removal.Parent->DetachChild(removal.Name) })
+					detached.push_back(std::move(node));
+
+			for (const auto& insertion : plan.Insertions)
+			{
+				const utility::PathView path{ insertion.Set->first };
+
+				NodePtr node{ insertion.Node };
+				auto key{ path.begin() + insertion.Depth };
+				for (const auto end{ path.end() }; key != end; ++key)
+					if (NodePtr child{ node->FindChild(*key) })
+						node = std::move(child);
+					else
+						break;
+
+				node->GrowBranchAndSetValue(path.GetRest(key), std::move(insertion.Set->second));
+			}
+		}
+
+		// The writes reduced to deletes followed by sets, with the same outcome: a delete cancels the sets made
+		// before it at or below its path, while the other ones touch nodes the delete doesn't. Deletes below
+		// another one are dropped, deletes are sorted.
+		static void Collapse(std::vector<Write>&& writes, std::vector<std::string>& deletes, Sets& sets)
+		{
+			for (auto& write : writes)
+			{
+				if (write.Content)
+				{
+					sets.insert_or_assign(std::move(write.Path), std::move(*write.Content));
+					continue;
+				}
+
+				for (auto set{ sets.begin() }; set != sets.end(); )
+					set = set->first == write.Path || IsUnder(write.Path, set->first) ? sets.erase(set) : std::next(set);
+
+				deletes.push_back(std::move(write.Path));
+			}
+
+			std::sort(deletes.begin(), deletes.end());
+			deletes.erase(std::unique(deletes.begin(), deletes.end()), deletes.end());
+
+			const auto covered = [&deletes](const std::string& path)
+			{
+				for (auto separator{ path.rfind('/') }; separator && separator != std::string::npos; separator = path.rfind('/', separator - 1))
+					if (std::binary_search(deletes.begin(), deletes.end(), path.substr(0, separator)))
+						return true;
+
+				return false;
+			};
+
+			std::vector<std::string> kept;
+			for (auto& path : deletes)
+				if (!covered(path))
+					kept.push_back(std::move(path));
+
+			deletes = std::move(kept);
+		}
+
+		// "/a/b" for any spelling of the path, "/" for the root
+		static std::string GetCanonical(const utility::PathView& path)
+		{
+			if (path.IsEmpty())
+				return "/";
+
+			std::string canonical;
+			for (const auto& key : path)
+				(canonical += '/') += key;
+
+			return canonical;
+		}
+
+		// whether path is strictly below ancestor, both canonical
+		static bool IsUnder(const std::string_view ancestor, const std::string_view path) noexcept
+		{
+			if (ancestor == "/")
+				return path != "/";
+
+			return path.size() > ancestor.size() && path.compare(0, ancestor.size(), ancestor) == 0 && path[ancestor.size()] == '/';
+		}
+	};
+
+}
+
+#endif
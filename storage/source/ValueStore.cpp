@@ -0,0 +1,164 @@
+#include "ValueStore.h"
+
+#include "Serialization.h"
+
+#include <functional>
+#include <stdexcept>
+#include <string_view>
+
+namespace jb_storage::utility
+{
+
+	namespace
+	{
+
+		// tags that follow the indices of the alternatives of Value
+		constexpr uint8_t s_shared_tag{ 0xFE };		// the payload, first seen
+		constexpr uint8_t s_reference_tag{ 0xFF };	// the number of the payload seen before
+
+		std::string_view GetBytes(const Value& value) noexcept
+		{
+			if (const auto string{ std::get_if<std::string>(&value) })
+				return *string;
+
+			if (const auto blob{ std::get_if<Blob>(&value) })
+				return { reinterpret_cast<const char*>(blob->data()), blob->size() };
+
+			return { };
+		}
+
+	}
+
+	// the store is asked to forget the payload after its last holder is gone
+	struct ValueStore::Deleter
+	{
+		std::weak_ptr<ValueStore>	Store;
+		size_t						Hash;
+
+		void operator () (const Value* const value) const
+		{
+			if (const auto store{ Store.lock() })
+				store->Forget(Hash);
+
+			delete value;
+		}
+	};
+
+	bool ValueStore::Accepts(const Value& value) const noexcept
+	{
+		const auto threshold{ _threshold.load(std::memory_order_relaxed) };
+		return threshold && (std::holds_alternative<std::string>(value) || std::holds_alternative<Blob>(value)) && GetBytes(value).size() >= threshold;
+	}
+
+	// payloads whose last holders are gone are let go with no lock held, as dropping one calls Forget()
+	ValueStore::Payload ValueStore::Intern(Value&& value)
+	{
+		const auto hash{ Hash(value) };
+
+		std::vector<Payload> candidates;
+		std::lock_guard lock{ _lock };
+
+		const auto [begin, end] = _payloads.equal_range(hash);
+		for (auto entry{ begin }; entry != end; ++entry)
+			if (auto& candidate{ candidates.emplace_back(entry->second.lock()) }; candidate && *candidate == value)
+				return candidate;
+
+		Payload payload{ new Value{ std::move(value) }, Deleter{ weak_from_this(), hash } };
+		_payloads.emplace(hash, payload);
+
+		return payload;
+	}
+
+	size_t ValueStore::Hash(const Value& value) noexcept
+	{ return std::hash<std::string_view>{ }(GetBytes(value)) ^ value.index(); }
+
+	void ValueStore::Forget(const size_t hash)
+	{
+		std::lock_guard lock{ _lock };
+
+		const auto [begin, end] = _payloads.equal_range(hash);
+		for (auto entry{ begin }; entry != end; )
+			if (entry->second.expired())
+				entry = _payloads.erase(entry);
+			else
+				++entry;
+	}
+
+	void SharedValueWriter::Write(const Value& value, const Value* const shared, std::ostream& os)
+	{
+		if (!shared)
+			return Serialize(value, os);
+
+		if (const auto written{ _written.find(shared) }; written != _written.end())
+		{
+			Serialize(s_reference_tag, os);
+			Serialize(written->second, os);
+			return;
+		}
+
+		_written.emplace(shared, _count++);
+		Serialize(s_shared_tag, os);
+		Serialize(*shared, os);
+	}
+
+	void SharedValueWriter::Copy(std::istream& is, std::vector<uint64_t>& numbers, std::ostream& os)
+	{
+		switch (is.peek())
+		{
+		case s_shared_tag:
+			is.get();
+			numbers.push_back(_count++);
+			Serialize(s_shared_tag, os);
+			Serialize(Deserialize<Value>(is), os);
+			break;
+
+		case s_reference_tag:
+			{
+				is.get();
+
+				const auto number{ Deserialize<uint64_t>(is) };
+				if (number >= numbers.size())
+					throw std::out_of_range{ "payload " + std::to_string(number) + " out of range" };
+
+				Serialize(s_reference_tag, os);
+				Serialize(numbers[number], os);
+			}
+			break;
+
+		default:
+			Serialize(Deserialize<Value>(is), os);
+		}
+	}
+
+	void SharedValueReader::Read(std::istream& is, Value& value, ValueStore::Payload& shared)
+	{
+		switch (is.peek())
+		{
+		case s_shared_tag:
+			{
+				is.get();
+
+				auto payload{ Deserialize<Value>(is) };
+				shared = _store && _store->Accepts(payload) ? _store->Intern(std::move(payload)) : std::make_shared<const Value>(std::move(payload));
+				_read.push_back(shared);
+			}
+			break;
+
+		case s_reference_tag:
+			{
+				is.get();
+
+				const auto number{ Deserialize<uint64_t>(is) };
+				if (number >= _read.size())
+					throw std::out_of_range{ "payload " + std::to_string(number) + " out of range" };
+
+				shared = _read[number];
+			}
+			break;
+
+		default:
+			value = Deserialize<Value>(is);
+		}
+	}
+
+}
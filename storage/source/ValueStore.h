@@ -0,0 +1,81 @@
+#ifndef STORAGE_VALUESTORE_H
+#define STORAGE_VALUESTORE_H
+
+#include "Common.h"
+
+#include <atomic>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+namespace jb_storage::utility
+{
+
+	// Large string and blob values of a volume kept once per distinct content and shared by every node holding
+	// them (see Volume::SetDedupThreshold()). The store refers to payloads weakly, a payload leaves it when its
+	// last holder drops it.
+	class ValueStore final : public std::enable_shared_from_this<ValueStore>
+	{
+	public:
+		using Payload = std::shared_ptr<const Value>;
+
+	private:
+		std::atomic<size_t>												_threshold{ 0 };	// 0 for none taken
+
+		std::mutex														_lock;
+		std::unordered_multimap<size_t, std::weak_ptr<const Value>>	_payloads;			// by hash
+
+	public:
+		void SetThreshold(const size_t threshold) noexcept	{ _threshold.store(threshold, std::memory_order_relaxed); }
+
+		// whether the value is to be interned: a string or a blob of the threshold's size at least
+		bool Accepts(const Value& value) const noexcept;
+
+		// the payload equal to the value, added if there's none yet
+		Payload Intern(Value&& value);
+
+	private:
+		struct Deleter;
+
+		static size_t Hash(const Value& value) noexcept;
+
+		void Forget(const size_t hash);
+	};
+
+	// Writes values the way Serialize(const Value&) does, but a payload shared by several nodes only once:
+	// later on, it's referred to by the number of its first occurrence.
+	class SharedValueWriter final
+	{
+	private:
+		std::unordered_map<const Value*, uint64_t>	_written;
+		uint64_t									_count{ 0 };
+
+	public:
+		void Write(const Value& value, const Value* shared, std::ostream& os);
+
+		// Copies a value another writer wrote as this one would have, read from the stream one at a time:
+		// payloads shared there are shared anew, the numbers they got there mapped to those given here.
+		void Copy(std::istream& is, std::vector<uint64_t>& numbers, std::ostream& os);
+	};
+
+	// Reads what SharedValueWriter writes, payloads written once being shared again by the nodes they're read
+	// into; through the store, if given one that takes them.
+	class SharedValueReader final
+	{
+	private:
+		ValueStore* const				_store;
+		std::vector<ValueStore::Payload>	_read;
+
+	public:
+		explicit SharedValueReader(ValueStore* const store = nullptr) noexcept : _store{ store } { }
+
+		// the value is either read in place, or shared with nothing left in value
+		void Read(std::istream& is, Value& value, ValueStore::Payload& shared);
+	};
+
+}
+
+#endif
@@ -9,17 +9,84 @@ namespace jb_storage
 		: _impl{ std::make_shared<VolumeImpl>() }
 	{ }
 
+	Volume::Volume(std::shared_ptr<VolumeImpl>&& impl) noexcept
+		: _impl{ std::move(impl) }
+	{ }
+
 	std::optional<Value> Volume::Get(const std::string_view path) const
-	{ return _impl->Get(path); }
+	{ return _impl->Get(utility::PathView{ path }); }
 
 	bool Volume::SetOrInsert(const std::string_view path, const Value& value) const
-	{ return _impl->SetOrInsert(path, Value{ value }); }
+	{ return _impl->SetOrInsert(utility::PathView{ path }, Value{ value }); }
 
 	bool Volume::SetOrInsert(const std::string_view path, Value&& value) const
-	{ return _impl->SetOrInsert(path, std::move(value)); }
+	{ return _impl->SetOrInsert(utility::PathView{ path }, std::move(value)); }
 
 	bool Volume::Delete(const std::string_view path) const
-	{ return _impl->Delete(path); }
+	{ return _impl->Delete(utility::PathView{ path }); }
+
+	std::optional<Value> Volume::Get(const PathSegments path) const
+	{ return _impl->Get(utility::PathView{ path }); }
+
+	bool Volume::SetOrInsert(const PathSegments path, const Value& value) const
+	{ return utility::PathView::IsValid(path) && _impl->SetOrInsert(utility::PathView{ path }, Value{ value }); }
+
+	bool Volume::SetOrInsert(const PathSegments path, Value&& value) const
+	{ return utility::PathView::IsValid(path) && _impl->SetOrInsert(utility::PathView{ path }, std::move(value)); }
+
+	bool Volume::Delete(const PathSegments path) const
+	{ return _impl->Delete(utility::PathView{ path }); }
+
+	bool Volume::SetOrInsert(const std::string_view path, Value value, const std::chrono::milliseconds ttl) const
+	{ return _impl->SetOrInsert(utility::PathView{ path }, std::move(value), ttl); }
+
+	bool Volume::CompareAndSwap(const std::string_view path, const uint32_t expected, const uint32_t desired) const
+	{ return _impl->CompareAndSwap(utility::PathView{ path }, expected, desired); }
+
+	bool Volume::CompareAndSwap(const std::string_view path, const uint64_t expected, const uint64_t desired) const
+	{ return _impl->CompareAndSwap(utility::PathView{ path }, expected, desired); }
+
+	std::optional<uint32_t> Volume::FetchAdd(const std::string_view path, const uint32_t delta) const
+	{ return _impl->FetchAdd(utility::PathView{ path }, delta); }
+
+	std::optional<uint64_t> Volume::FetchAdd(const std::string_view path, const uint64_t delta) const
+	{ return _impl->FetchAdd(utility::PathView{ path }, delta); }
+
+	std::optional<std::vector<std::string>> Volume::List(const std::string_view path, const size_t limit, const std::string_view after) const
+	{ return _impl->List(utility::PathView{ path }, limit, after); }
+
+	std::string Volume::Scan(const std::string_view path, const ScanCallback& callback, const std::string_view resume) const
+	{ return _impl->Scan(utility::PathView{ path }, callback, resume); }
+
+	size_t Volume::Glob(const std::string_view pattern, const ScanCallback& callback) const
+	{ return _impl->Glob(utility::PathView{ pattern }, callback); }
+
+	std::optional<double> Volume::Aggregate(const std::string_view path, const Aggregation aggregation) const
+	{ return _impl->Aggregate(utility::PathView{ path }, aggregation); }
+
+	std::optional<Usage> Volume::GetUsage(const std::string_view path) const
+	{ return _impl->GetUsage(utility::PathView{ path }); }
+
+	bool Volume::Rename(const std::string_view from, const std::string_view to) const
+	{ return _impl->Rename(utility::PathView{ from }, utility::PathView{ to }); }
+
+	bool Volume::Move(const std::string_view from, const Volume& target, const std::string_view to) const
+	{ return _impl->Move(utility::PathView{ from }, *target._impl, utility::PathView{ to }); }
+
+	Handle Volume::Open(const std::string_view path) const
+	{ return Handle{ _impl->Open(path) }; }
+
+	Transaction Volume::BeginTransaction() const
+	{ return Transaction{ _impl->BeginTransaction() }; }
+
+	Snapshot Volume::Snapshot() const
+	{ return jb_storage::Snapshot{ _impl->TakeSnapshot() }; }
+
+	Volume Volume::Clone() const
+	{ return Volume{ _impl->Clone() }; }
+
+	Volume Volume::Freeze() const
+	{ return Volume{ _impl->Freeze() }; }
 
 	bool Volume::Load(std::istream& is) const
 	{ return _impl->Load(is); }
@@ -27,4 +94,37 @@ namespace jb_storage
 	bool Volume::Save(std::ostream& os) const
 	{ return _impl->Save(os); }
 
+	std::future<std::optional<Value>> Volume::GetAsync(const std::string_view path) const
+	{ return _impl->GetLimiter().Async([impl = _impl, path = std::string{ path }]() { return impl->Get(utility::PathView{ path }); }); }
+
+	std::future<bool> Volume::SetOrInsertAsync(const std::string_view path, Value value) const
+	{
+		return _impl->GetLimiter().Async([impl = _impl, path = std::string{ path }, value = std::move(value)]() mutable
+		{ return impl->SetOrInsert(utility::PathView{ path }, std::move(value)); });
+	}
+
+	std::future<bool> Volume::DeleteAsync(const std::string_view path) const
+	{ return _impl->GetLimiter().Async([impl = _impl, path = std::string{ path }]() { return impl->Delete(utility::PathView{ path }); }); }
+
+	std::future<bool> Volume::LoadAsync(std::istream& is) const
+	{ return _impl->GetLimiter().Async([impl = _impl, &is]() { return impl->Load(is); }); }
+
+	std::future<bool> Volume::SaveAsync(std::ostream& os) const
+	{ return _impl->GetLimiter().Async([impl = _impl, &os]() { return impl->Save(os); }); }
+
+	void Volume::SetAsyncConcurrency(const size_t limit) const
+	{ _impl->GetLimiter().SetLimit(limit); }
+
+	void Volume::SetDedupThreshold(const size_t min_size) const
+	{ _impl->SetDedupThreshold(min_size); }
+
+	bool Volume::SetMemoryBudget(const size_t budget, const std::string& path) const
+	{ return _impl->SetMemoryBudget(budget, path); }
+
+	void Volume::EnableStats(const bool enable) const
+	{ _impl->EnableStats(enable); }
+
+	Stats Volume::GetStats() const
+	{ return _impl->GetStats(); }
+
 }
@@ -0,0 +1,28 @@
+#include "VolumeBuilder.h"
+
+#include "VolumeImpl.h"
+
+namespace jb_storage
+{
+
+	VolumeBuilder::VolumeBuilder()
+		: _impl{ std::make_unique<VolumeBuilderImpl>() }
+	{ }
+
+	VolumeBuilder::VolumeBuilder(VolumeBuilder&&) noexcept = default;
+	VolumeBuilder& VolumeBuilder::operator = (VolumeBuilder&&) noexcept = default;
+	VolumeBuilder::~VolumeBuilder() = default;
+
+	bool VolumeBuilder::Add(const std::string_view path, const Value& value)
+	{ return _impl->Add(utility::PathView{ path }, Value{ value }); }
+
+	bool VolumeBuilder::Add(const std::string_view path, Value&& value)
+	{ return _impl->Add(utility::PathView{ path }, std::move(value)); }
+
+	bool VolumeBuilder::Attach(const std::string_view path, VolumeBuilder&& subtree)
+	{ return _impl->Attach(utility::PathView{ path }, *subtree._impl); }
+
+	Volume VolumeBuilder::Build()
+	{ return Volume{ _impl->Finish() }; }
+
+}
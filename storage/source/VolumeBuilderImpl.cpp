@@ -0,0 +1,101 @@
+#include "VolumeImpl.h"
+
+#include "VolumeNode.h"
+
+namespace jb_storage
+{
+
+	VolumeBuilderImpl::VolumeBuilderImpl()
+	{ _stack.push_back(Frame{ std::make_shared<VolumeNode>(), { } }); }
+
+	bool VolumeBuilderImpl::Add(const utility::PathView& path, Value&& value)
+	{
+		if (!Reach(path))
+			return false;
+
+		if (!path.IsEmpty())
+			Open(path[path.GetDepth() - 1], std::make_shared<VolumeNode>());
+
+		VolumeNode& node{ *_stack.back().Node };
+		node._value = std::move(value);
+		node._value_bytes.fetch_add(utility::GetValueSize(node._value), std::memory_order_relaxed);
+
+		return true;
+	}
+
+	bool VolumeBuilderImpl::Attach(const utility::PathView& path, VolumeBuilderImpl& subtree)
+	{
+		if (path.IsEmpty() || &subtree == this || !Reach(path))
+			return false;
+
+		Open(path[path.GetDepth() - 1], subtree.TakeRoot());
+		return true;
+	}
+
+	VolumeImplPtr VolumeBuilderImpl::Finish()
+	{ return VolumeImplPtr{ new VolumeImpl{ TakeRoot() } }; }
+
+	// Leaves open the nodes along the path but for the last one, closing the others and opening those missing.
+	// False, with nothing changed, if the path doesn't come after all those given so far: the root is taken
+	// before anything else only, and any other node after the last child of its parent only.
+	bool VolumeBuilderImpl::Reach(const utility::PathView& path)
+	{
+		size_t common{ 0 };
+		auto key{ path.begin() };
+		for (const auto end{ path.end() }; key != end && common + 1 < _stack.size() && *key == _stack[common + 1].Name; ++key)
+			++common;
+
+		if (key == path.end())
+		{
+			if (_started || common)
+				return false;
+		}
+		else if (const auto& children{ _stack[common].Node->_children }; !children.empty() && *key <= children.rbegin()->first)
+			return false;
+
+		while (_stack.size() > common + 1)
+			Close();
+
+		for (const auto last{ path.end() - (path.IsEmpty() ? 0 : 1) }; key < last; ++key)
+			Open(*key, std::make_shared<VolumeNode>());
+
+		_started = true;
+		return true;
+	}
+
+	// children are given in order, so the hint makes insertion O(1)
+	void VolumeBuilderImpl::Open(const std::string_view name, NodePtr&& node)
+	{
+		VolumeNode& parent{ *_stack.back().Node };
+		parent._nodes.fetch_add(1, std::memory_order_relaxed);
+		parent._key_bytes.fetch_add(name.size(), std::memory_order_relaxed);
+		node->_parent = &parent;
+
+		const auto child{ parent._children.emplace_hint(parent._children.end(), name, std::move(node)) };
+		_stack.push_back(Frame{ child->second, child->first });
+	}
+
+	// totals of a finished node are added up to its parent
+	void VolumeBuilderImpl::Close()
+	{
+		const auto usage{ _stack.back().Node->GetCounters() };
+		_stack.pop_back();
+
+		VolumeNode& parent{ *_stack.back().Node };
+		parent._nodes.fetch_add(usage.Nodes, std::memory_order_relaxed);
+		parent._key_bytes.fetch_add(usage.KeyBytes, std::memory_order_relaxed);
+		parent._value_bytes.fetch_add(usage.ValueBytes, std::memory_order_relaxed);
+	}
+
+	VolumeBuilderImpl::NodePtr VolumeBuilderImpl::TakeRoot()
+	{
+		while (_stack.size() > 1)
+			Close();
+
+		NodePtr root{ std::move(_stack.front().Node) };
+		*this = VolumeBuilderImpl{ };
+
+		return root;
+	}
+
+}
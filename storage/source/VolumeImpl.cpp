@@ -1,121 +1,406 @@
 #include "VolumeImpl.h"
 
-#include "Mutex.h"
-#include "Serialization.h"
-
+#include "SnapshotClock.h"
+#include "SpillArea.h"
+#include "SpilledNode.h"
+#include "Spiller.h"
+#include "TimerWheel.h"
+#include "Tracing.h"
+#include "VolumeNode.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <limits>
 #include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace jb_storage
 {
 
-	class VolumeImpl::Node final : public INode
+	// Background thread taking expired nodes out: timers are kept in a wheel, and those falling due together
+	// are handled in one go, grouped by parent, so that a parent is locked and stamped once for all of its
+	// children due. A timer holds on to nothing; one for a node deleted, moved or set anew meanwhile finds
+	// nothing to do, a moved one is given a timer of its own at the new place.
+	class Expirer final
 	{
+		using NodePtr = std::shared_ptr<VolumeNode>;
+
+		struct Timer
+		{
+			std::weak_ptr<VolumeNode>	Parent;
+			std::string					Name;
+			std::weak_ptr<VolumeNode>	Node;
+			int64_t						Deadline;
+		};
+
 	private:
-		Value										_value;
-		std::map<std::string, NodePtr, std::less<>>	_children;
-		MutexType									_lock;
+		std::mutex					_lock;
+		std::condition_variable		_wakeup;
+		utility::TimerWheel<Timer>	_wheel{ utility::GetTick() };
+		int64_t						_wake_at{ std::numeric_limits<int64_t>::min() };	// tick the thread sleeps until
+		bool						_stop{ false };
+		std::thread					_thread;
 
 	public:
-		std::optional<Value> GetValue() const override
-		{ return _value; }
+		static Expirer& Instance()
+		{
+			static Expirer instance;
+			return instance;
+		}
 
-		bool GrowBranchAndSetValue(const utility::PathView& path, Value&& value) override
+		// the singletons the thread uses are made first, so that they outlive it
+		Expirer()
 		{
-			if (!path.IsEmpty())
-			{
-				auto key{ path.begin() };
+			utility::SnapshotClock::Instance();
+			utility::Reclaimer::Instance();
 
-				auto new_subbranch{ std::make_shared<Node>() };
-				auto tail{ new_subbranch };
+			_thread = std::thread{ [this]() { Run(); } };
+		}
 
-				const auto new_subbranch_name{ *key++ };
+		~Expirer()
+		{
+			{
+				std::lock_guard lock{ _lock };
+				_stop = true;
+			}
 
-				for (const auto end{ path.end() }; key != end; ++key)
-					tail = tail->SetChild(*key, std::make_shared<Node>());
+			_wakeup.notify_one();
+			_thread.join();
+		}
 
-				tail->_value = std::move(value);
+		Expirer(const Expirer&) = delete;
+		Expirer& operator = (const Expirer&) = delete;
 
-				SetChild(new_subbranch_name, std::move(new_subbranch));
+		// the thread is woken up only for a timer due before it would wake up anyway
+		void Schedule(const NodePtr& parent, const std::string_view name, const NodePtr& node, const int64_t deadline)
+		{
+			{
+				std::lock_guard lock{ _lock };
+				_wheel.Schedule(deadline, Timer{ parent, std::string{ name }, node, deadline });
+
+				if (deadline >= _wake_at)
+					return;
 			}
-			else
-				_value = std::move(value);
 
-			return true;
+			_wakeup.notify_one();
 		}
 
-		INodePtr GetChild(const std::string_view name) const override
+	private:
+		void Run()
 		{
-			const auto child{ _children.find(name) };
-			return child != _children.end() ? child->second : nullptr;
+			std::vector<Timer> due;
+
+			for (std::unique_lock lock{ _lock }; !_stop; )
+			{
+				_wheel.Advance(utility::GetTick(), due);
+
+				if (!due.empty())
+				{
+					lock.unlock();
+					Expire(due);
+					due.clear();
+					lock.lock();
+					continue;
+				}
+
+				const auto next{ _wheel.GetNextTick() };
+				_wake_at = next.value_or(std::numeric_limits<int64_t>::max());
+
+				if (next)
+					_wakeup.wait_until(lock, std::chrono::steady_clock::time_point{ std::chrono::milliseconds{ *next } });
+				else
+					_wakeup.wait(lock);
+
+				_wake_at = std::numeric_limits<int64_t>::min();
+			}
 		}
 
-		bool DeleteChild(const std::string_view name) override
+		// timers are sorted by parent, whatever is taken out is destroyed off the locks
+		static void Expire(std::vector<Timer>& due)
 		{
-			// std::map::erase with equivalent key comparison appears in c++23 only
-			if (const auto child{ _children.find(name) }; child != _children.end())
+			STORAGE_TRACE_SPAN("Expire");
+
+			const auto by_parent = [](const Timer& left, const Timer& right) { return left.Parent.owner_before(right.Parent); };
+			std::sort(due.begin(), due.end(), by_parent);
+
+			const auto now{ utility::GetTick() };
+			std::vector<NodePtr> expired;
+
+			for (auto group{ due.begin() }, end{ due.end() }; group != end; )
 			{
-				_children.erase(child);
-				return true;
+				const auto group_end{ std::upper_bound(group, end, *group, by_parent) };
+
+				if (const auto parent{ group->Parent.lock() })
+				{
+					std::lock_guard lock{ *parent };
+					parent->ExpireChildren(group, group_end, now, expired);
+				}
+
+				group = group_end;
 			}
 
-			return false;
+			for (auto& node : expired)
+				utility::Reclaimer::Instance().Retire(std::move(node));
 		}
+	};
 
-		void lock() override
-		{ _lock.lock(); }
+	VolumeImpl::VolumeImpl()
+		: VolumeImpl{ std::make_shared<VolumeNode>() }
+	{ }
 
-		void unlock() override
-		{ _lock.unlock(); }
+	namespace
+	{
 
-		void lock_shared() override
-		{ _lock.lock_shared(); }
+		// cold subtrees smaller than that stay in memory, spilling them would save next to nothing
+		constexpr uint64_t MinSpillFootprint{ 4096 };
 
-		void unlock_shared() override
-		{ _lock.unlock_shared(); }
+	}
 
-		void swap(Node& other) noexcept
-		{
-			_value.swap(other._value);
-			_children.swap(other._children);
-		}
+	std::optional<Value> VolumeImpl::Get(const utility::PathView& path) const
+	{
+		auto value{ _metrics.Measure(utility::Operation::Get, [&]() { return _frozen ? _frozen->Get(path) : BaseImpl::Get(path); }) };
+		KeepInBudget();
+
+		return value;
+	}
+
+	bool VolumeImpl::Delete(const utility::PathView& path) const
+	{ return _metrics.Measure(utility::Operation::Delete, [&]() { return !_frozen && BaseImpl::Delete(path); }); }
+
+	bool VolumeImpl::SetOrInsert(const utility::PathView& path, Value&& value) const
+	{
+		const bool done{ _metrics.Measure(utility::Operation::SetOrInsert, [&]() { return Set(path, std::move(value), 0); }) };
+		KeepInBudget();
 
-		void Serialize(std::ostream& os) const
+		return done;
+	}
+
+	// the timer is set once the value is, for the node found at the path with the deadline then, which may
+	// well be past already; one set anew meanwhile has a timer of its own, if any
+	bool VolumeImpl::SetOrInsert(const utility::PathView& path, Value&& value, const std::chrono::milliseconds ttl) const
+	{
+		const bool done{ _metrics.Measure(utility::Operation::SetOrInsert, [&]()
 		{
-			utility::Serialize(_value, os);
-			utility::Serialize(static_cast<uint64_t>(_children.size()), os);
+			if (path.IsEmpty())
+				return false;
 
-			for (const auto& child : _children)
+			// a deadline of 0 stands for none
+			const auto deadline{ std::max<int64_t>(utility::GetTick() + ttl.count(), 1) };
+			if (!Set(path, std::move(value), deadline))
+				return false;
+
+			const auto name{ path[path.GetDepth() - 1] };
+			if (const auto parent{ BaseImpl::GetNode(path.GetParent()) })
 			{
-				utility::Serialize(child.first, os);
-				child.second->Serialize(os);
+				NodePtr node;
+				{
+					std::shared_lock lock{ *parent };
+					node = parent->FindChild(name, deadline);
+				}
+
+				if (node)
+					Expirer::Instance().Schedule(parent, name, node, deadline);
 			}
+
+			return true;
+		}) };
+		KeepInBudget();
+
+		return done;
+	}
+
+	bool VolumeImpl::CompareAndSwap(const utility::PathView& path, const uint32_t expected, const uint32_t desired) const
+	{ return !_frozen && BaseImpl::CompareAndSwap(path, expected, desired); }
+
+	bool VolumeImpl::CompareAndSwap(const utility::PathView& path, const uint64_t expected, const uint64_t desired) const
+	{ return !_frozen && BaseImpl::CompareAndSwap(path, expected, desired); }
+
+	std::optional<uint32_t> VolumeImpl::FetchAdd(const utility::PathView& path, const uint32_t delta) const
+	{ return _frozen ? std::nullopt : BaseImpl::FetchAdd(path, delta); }
+
+	std::optional<uint64_t> VolumeImpl::FetchAdd(const utility::PathView& path, const uint64_t delta) const
+	{ return _frozen ? std::nullopt : BaseImpl::FetchAdd(path, delta); }
+
+	std::optional<std::vector<std::string>> VolumeImpl::List(const utility::PathView& path, const size_t limit, const std::string_view after) const
+	{
+		auto names{ _frozen ? _frozen->List(path, limit, after) : BaseImpl::List(path, limit, after) };
+		KeepInBudget();
+
+		return names;
+	}
+
+	std::string VolumeImpl::Scan(const utility::PathView& path, const ScanCallback& callback, const std::string_view resume) const
+	{
+		auto token{ _frozen ? _frozen->Scan(path, callback, resume) : BaseImpl::Scan(path, callback, resume) };
+		KeepInBudget();
+
+		return token;
+	}
+
+	size_t VolumeImpl::Glob(const utility::PathView& pattern, const ScanCallback& callback) const
+	{ return _frozen ? _frozen->Glob(pattern, callback) : BaseImpl::Glob(pattern, callback); }
+
+	std::optional<double> VolumeImpl::Aggregate(const utility::PathView& path, const Aggregation aggregation) const
+	{ return _frozen ? _frozen->Aggregate(path, aggregation) : BaseImpl::Aggregate(path, aggregation); }
+
+	std::optional<Usage> VolumeImpl::GetUsage(const utility::PathView& path) const
+	{ return _frozen ? _frozen->GetUsage(path) : BaseImpl::GetUsage(path); }
+
+	INodePtr VolumeImpl::GetNode(const std::string_view path) const
+	{
+		if (_frozen)
+			return _frozen->GetNode(utility::PathView{ path });
+
+		return BaseImpl::GetNode(utility::PathView{ path });
+	}
+
+	bool VolumeImpl::Rename(const utility::PathView& from, const utility::PathView& to) const
+	{ return Move(from, *this, to); }
+
+	// Renames within a volume are serialized, as they're the only changes that make a node an ancestor of
+	// another: branches resolved meanwhile stay such, but for deletes, which detach them. Transactions tell
+	// paths they resolved through the node moved by the move it counts. Nodes of a clone
+	// lead to their origins, possibly in the target volume, so only a plain volume hands its nodes over.
+	bool VolumeImpl::Move(const utility::PathView& from, const VolumeImpl& target, const utility::PathView& to) const
+	{
+		STORAGE_TRACE_SPAN("Rename");
+
+		if (_frozen || target._frozen || from.IsEmpty() || to.IsEmpty() || (&target != this && _root->IsClone()))
+			return false;
+
+		std::unique_lock source_rename_lock{ _rename_lock, std::defer_lock };
+		std::unique_lock target_rename_lock{ target._rename_lock, std::defer_lock };
+		if (&target != this)
+			std::lock(source_rename_lock, target_rename_lock);
+		else
+			source_rename_lock.lock();
+
+		const auto source_branch{ GetBranch(from.GetParent()) };
+		const auto target_branch{ target.GetBranch(to.GetParent()) };
+		if (source_branch.empty() || target_branch.empty())
+			return false;
+
+		const NodePtr& source{ source_branch.back() };
+		const NodePtr& destination{ target_branch.back() };
+		const auto name{ from[from.GetDepth() - 1] };
+		const auto target_name{ to[to.GetDepth() - 1] };
+
+		// both parents are filled before they're locked together, filling one of a clone locks its origin;
+		// a node doesn't go into its own subtree
+		NodePtr moved;
+		{
+			std::shared_lock lock{ *source };
+			source->Materialize();
+			moved = source->FindChild(name);
 		}
+		{
+			std::shared_lock lock{ *destination };
+			destination->Materialize();
+			if (destination->FindChild(target_name))
+				return false;
+		}
+
+		if (!moved || std::find(target_branch.begin(), target_branch.end(), moved) != target_branch.end())
+			return false;
+
+		// in address order, yet backing off rather than waiting with one held, the way std::lock() does
+		const auto [first, second] = std::minmax({ source.get(), destination.get() });
+		std::unique_lock first_lock{ *first, std::defer_lock };
+		std::unique_lock second_lock{ *second, std::defer_lock };
+		if (first != second)
+			std::lock(first_lock, second_lock);
+		else
+			first_lock.lock();
+
+		const auto detached = [](const NodePtr& node) { return node->IsDetached(); };
+		if (std::any_of(source_branch.begin(), source_branch.end(), detached) || std::any_of(target_branch.begin(), target_branch.end(), detached))
+			return false;
 
-		void Deserialize(std::istream& is)
+		// clones of this volume still read the nodes handed over as they were
+		if (&target != this)
+			utility::SnapshotClock::Instance().Share(*_clones, target._clones);
+
+		NodePtr done;
 		{
-			Node node;
-			node._value = utility::Deserialize<Value>(is);
+			const utility::SnapshotClock::Pin pin;
+			done = source->MoveChild(name, *destination, target_name);
+		}
 
-			const auto count{ utility::Deserialize<uint64_t>(is) };
-			for (uint64_t i{ 0 }; i < count; ++i)
-			{
-				const auto name{ utility::Deserialize<std::string>(is) };
-				auto child{ std::make_shared<Node>() };
-				child->Deserialize(is);
-				node.SetChild(name, std::move(child));
-			}
+		if (done && done->GetDeadline())
+			Expirer::Instance().Schedule(destination, target_name, done, done->GetDeadline());
+
+		return !!done;
+	}
+
+	IHandlePtr VolumeImpl::Open(const std::string_view path) const
+	{
+		if (_frozen)
+		{
+			if (auto branch{ _frozen->GetBranch(utility::PathView{ path }) }; !branch.empty())
+				return std::make_shared<HandleImpl<INode>>(std::move(branch), weak_from_this());
 
-			swap(node);
+			return nullptr;
 		}
 
-	private:
-		NodePtr SetChild(const std::string_view name, NodePtr&& child)
-		{ return _children.insert_or_assign(std::string{ name }, std::move(child)).first->second; }
-	};
+		if (auto branch{ GetBranch(utility::PathView{ path }) }; !branch.empty())
+			return std::make_shared<HandleImpl<VolumeNode>>(std::move(branch), weak_from_this());
 
-	VolumeImpl::VolumeImpl()
-		: VolumeImpl{ std::make_shared<Node>() }
-	{ }
+		return nullptr;
+	}
+
+	// a transaction of a frozen volume has no owner to commit to
+	std::unique_ptr<ITransaction> VolumeImpl::BeginTransaction() const
+	{
+		if (_frozen)
+			return std::make_unique<TransactionImpl<INode>>(_frozen->GetNode(utility::PathView{ "/" }), std::weak_ptr<const void>{ });
+
+		return std::make_unique<TransactionImpl<VolumeNode>>(_root, weak_from_this());
+	}
+
+	std::unique_ptr<const ISnapshot> VolumeImpl::TakeSnapshot() const
+	{
+		if (_frozen)
+			return std::make_unique<SnapshotImpl<INode>>(_frozen->GetNode(utility::PathView{ "/" }));
+
+		return std::make_unique<SnapshotImpl<VolumeNode>>(_root);
+	}
+
+	// frozen volumes are immutable, so one is its own clone
+	VolumeImplPtr VolumeImpl::Clone() const
+	{
+		STORAGE_TRACE_SPAN("Clone");
+
+		if (_frozen)
+			return VolumeImplPtr{ new VolumeImpl{ std::shared_ptr<const FrozenImpl>{ _frozen } } };
+
+		// the clone's root is made once the snapshot is live, so that changes after it are stamped later; only
+		// the nodes of this volume keep states for it
+		auto lease{ std::make_shared<const utility::SnapshotClock::Lease>(_clones) };
+		auto root{ std::make_shared<VolumeNode>(_root, std::move(lease), utility::SnapshotClock::Instance().GetTime()) };
+
+		return VolumeImplPtr{ new VolumeImpl{ std::move(root) } };
+	}
+
+	// nodes are read as of a snapshot, which lists them in the order the builder takes them in
+	VolumeImplPtr VolumeImpl::Freeze() const
+	{
+		STORAGE_TRACE_SPAN("Freeze");
+
+		if (_frozen)
+			return VolumeImplPtr{ new VolumeImpl{ std::shared_ptr<const FrozenImpl>{ _frozen } } };
+
+		const SnapshotImpl<VolumeNode> snapshot{ _root };
+		const utility::PathView root{ "/" };
+
+		FrozenImpl::Builder builder;
+		builder.Add(root, snapshot.Get(root).value_or(Value{ }));
+		snapshot.Scan(root, [&builder](const std::string_view path, const Value& value) { return builder.Add(utility::PathView{ path }, Value{ value }); }, { });
+
+		return VolumeImplPtr{ new VolumeImpl{ builder.Finish() } };
+	}
 
 	void VolumeImpl::AddRef() noexcept
 	{ _refcounter.fetch_add(1, std::memory_order_acquire); }
@@ -125,7 +410,9 @@ namespace jb_storage
 
 	bool VolumeImpl::Load(std::istream& is) const
 	{
-		if (IsUsed())
+		STORAGE_TRACE_SPAN("Load");
+
+		if (_frozen || IsUsed())
 			return false;
 
 		std::unique_lock lock{ *_root };
@@ -139,9 +426,14 @@ namespace jb_storage
 		bool status{ true };
 		try
 		{
-			const auto creature{ std::make_shared<Node>() };
-			creature->Deserialize(is);
+			auto creature{ std::make_shared<VolumeNode>() };
+			creature->Deserialize(is, _values.get());
 			_root->swap(*creature);
+			creature->DetachChildren();
+			lock.unlock();
+
+			// the former tree may be destroyed in place, off the lock
+			utility::Reclaimer::Instance().Retire(std::move(creature));
 		}
 		catch (const std::exception&)
 		{ status = false; }
@@ -153,12 +445,17 @@ namespace jb_storage
 
 	bool VolumeImpl::Save(std::ostream& os) const
 	{
-		if (IsUsed())
+		STORAGE_TRACE_SPAN("Save");
+
+		// a frozen volume is saved even while mounted, as nothing changes it meanwhile
+		if (!_frozen && IsUsed())
 			return false;
 
+		// no subtree is spilled meanwhile, which would take its nodes out from under the walk
+		std::unique_lock pass_lock{ _spill->GetPassLock() };
 		std::unique_lock lock{ *_root };
 
-		if (IsUsed())
+		if (!_frozen && IsUsed())
 			return false;
 
 		const auto saved_state{ os.exceptions() };
@@ -166,7 +463,12 @@ namespace jb_storage
 
 		bool status{ true };
 		try
-		{ _root->Serialize(os); }
+		{
+			if (_frozen)
+				_frozen->Save(os);
+			else
+				_root->Serialize(os);
+		}
 		catch (const std::exception&)
 		{ status = false; }
 
@@ -175,9 +477,136 @@ namespace jb_storage
 		return status;
 	}
 
+	Stats VolumeImpl::GetStats() const
+	{
+		Stats stats{ _metrics.GetStats() };
+
+		const auto usage{ _frozen ? *_frozen->GetUsage(utility::PathView{ "/" }) : _root->GetUsage() };
+		stats.Nodes = usage.Nodes;
+		stats.KeyBytes = usage.KeyBytes;
+		stats.ValueBytes = usage.ValueBytes;
+
+		if (!_frozen)
+		{
+			_spill->GetStats(stats.Spill);
+			stats.Spill.ResidentBytes = GetResidentSize();
+		}
+
+		return stats;
+	}
+
 	VolumeImpl::VolumeImpl(NodePtr&& root) noexcept
-		: BaseImpl{ root }, _root{ std::move(root) }, _refcounter{ 0 }
-	{ }
+		: BaseImpl{ root }, _root{ std::move(root) }, _refcounter{ 0 }, _values{ std::make_shared<utility::ValueStore>() }, _spill{ std::make_shared<SpillArea>(_values) }
+		, _clones{ std::make_shared<utility::SnapshotClock::Scope>() }
+	{ _root->SetClones(_clones); }
+
+	// the root is left empty, for the base to have one
+	VolumeImpl::VolumeImpl(std::shared_ptr<const FrozenImpl>&& frozen)
+		: VolumeImpl{ std::make_shared<VolumeNode>() }
+	{ _frozen = std::move(frozen); }
+
+	uint64_t VolumeImpl::GetResidentSize() const noexcept
+	{
+		// a stub deleted leaves the totals before its subtree is forgotten
+		const auto total{ VolumeNode::GetFootprint(_root->GetUsage()) };
+		const auto spilled{ _spill->GetBytes() };
+
+		return total > spilled ? total - spilled : 0;
+	}
+
+	// the pass is left to the Spiller, the volume gone by then is spared it
+	void VolumeImpl::KeepInBudget() const
+	{
+		const auto budget{ _spill->GetBudget() };
+		if (!budget || GetResidentSize() <= budget || !_spill->MarkDue())
+			return;
+
+		utility::Spiller::Instance().Schedule([volume{ weak_from_this() }]()
+		{
+			if (const auto locked{ volume.lock() })
+				locked->SpillCold();
+		});
+	}
+
+	// A pass spills the cold subtrees it comes across, top down, until the volume fits in the budget again:
+	// cold ones too small to bother with are left alone, hot ones and those that can't be spilled for now are
+	// looked into for cold subtrees below them. A save under way keeps the pass off, the next operation over
+	// budget schedules another one.
+	void VolumeImpl::SpillCold() const
+	{
+		_spill->ClearDue();
+
+		const auto budget{ _spill->GetBudget() };
+		if (!budget || GetResidentSize() <= budget)
+			return;
+
+		std::unique_lock pass_lock{ _spill->GetPassLock(), std::try_to_lock };
+		if (!pass_lock)
+			return;
+
+		STORAGE_TRACE_SPAN("Spill");
+
+		const auto epoch{ SpillArea::NextEpoch() };
+		std::vector<NodePtr> stack{ _root }, hot;
+		std::vector<std::pair<std::string, NodePtr>> cold;
+
+		while (!stack.empty())
+		{
+			const NodePtr node{ std::move(stack.back()) };
+			stack.pop_back();
+
+			cold.clear();
+			hot.clear();
+			{
+				std::shared_lock lock{ *node };
+				node->SortChildren(epoch, cold, hot);
+			}
+
+			for (auto& [name, child] : cold)
+			{
+				if (VolumeNode::GetFootprint(child->GetUsage()) < MinSpillFootprint)
+					continue;
+
+				if (!SpilledNode::Spill(*node, name, child, _spill))
+					hot.push_back(std::move(child));
+				else if (GetResidentSize() <= budget)
+					return;
+			}
+
+			std::move(hot.begin(), hot.end(), std::back_inserter(stack));
+		}
+	}
+
+	// the file is opened once, later calls change the budget only
+	bool VolumeImpl::SetMemoryBudget(const size_t budget, const std::string& path) const
+	{
+		if (_frozen || _root->IsClone() || !_spill->Open(path))
+			return false;
+
+		_spill->SetBudget(budget);
+		KeepInBudget();
+
+		return true;
+	}
+
+	// a value the store takes is interned before the path is walked, so that no node is locked meanwhile
+	bool VolumeImpl::Set(const utility::PathView& path, Value&& value, const int64_t deadline) const
+	{
+		if (_frozen)
+			return false;
+
+		if (!deadline && !_values->Accepts(value))
+			return BaseImpl::SetOrInsert(path, std::move(value));
+
+		STORAGE_TRACE_SPAN("SetOrInsert");
+
+		auto payload{ _values->Accepts(value) ? _values->Intern(std::move(value)) : nullptr };
+		return GrowBranchAndSetValue(
+				_root,
+				path,
+				[](const NodePtr& node, const std::string_view name) { return node->FindChild(name); },
+				[&value, &payload, deadline](const NodePtr& node, const utility::PathView& path) { return node->GrowBranchAndSetValue(path, std::move(value), std::move(payload), deadline); });
+	}
 
 	bool VolumeImpl::IsUsed() const noexcept
 	{ return _refcounter.load(std::memory_order_relaxed) != 0; }
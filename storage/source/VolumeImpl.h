@@ -2,27 +2,72 @@
 #define STORAGE_VOLUMEIMPL_H
 
 #include "BaseImpl.h"
+#include "FrozenImpl.h"
+#include "HandleImpl.h"
+#include "Metrics.h"
+#include "SnapshotClock.h"
+#include "SnapshotImpl.h"
+#include "ThreadPool.h"
+#include "TransactionImpl.h"
+#include "ValueStore.h"
 
 #include <atomic>
+#include <chrono>
 #include <istream>
+#include <mutex>
 #include <ostream>
 
 namespace jb_storage
 {
 
-	class VolumeImpl final : public BaseImpl
+	class SpillArea;
+	class VolumeNode;
+
+	class VolumeImpl final : public BaseImpl<VolumeNode>, public std::enable_shared_from_this<VolumeImpl>
 	{
-		class Node;
-		using NodePtr = std::shared_ptr<Node>;
+		friend class VolumeBuilderImpl;
 
 	private:
-		NodePtr					_root;
-		std::atomic<unsigned>	_refcounter;
+		NodePtr								_root;
+		std::shared_ptr<const FrozenImpl>	_frozen;	// serves everything instead of the root, if set
+		std::atomic<unsigned>				_refcounter;
+		mutable std::mutex					_rename_lock;
+
+		mutable utility::ConcurrencyLimiter						_limiter;
+		mutable utility::Metrics								_metrics;
+		const std::shared_ptr<utility::ValueStore>				_values;	// of shared payloads, see SetDedupThreshold()
+		const std::shared_ptr<SpillArea>						_spill;		// of cold subtrees, see SetMemoryBudget()
+		const std::shared_ptr<utility::SnapshotClock::Scope>	_clones;	// snapshots of clones, seen by this volume only
 
 	public:
 		VolumeImpl();
 
-		using BaseImpl::GetNode;
+		std::optional<Value> Get(const utility::PathView& path) const;
+		bool Delete(const utility::PathView& path) const;
+		bool SetOrInsert(const utility::PathView& path, Value&& value) const;
+		bool SetOrInsert(const utility::PathView& path, Value&& value, const std::chrono::milliseconds ttl) const;
+
+		bool CompareAndSwap(const utility::PathView& path, const uint32_t expected, const uint32_t desired) const;
+		bool CompareAndSwap(const utility::PathView& path, const uint64_t expected, const uint64_t desired) const;
+		std::optional<uint32_t> FetchAdd(const utility::PathView& path, const uint32_t delta) const;
+		std::optional<uint64_t> FetchAdd(const utility::PathView& path, const uint64_t delta) const;
+
+		std::optional<std::vector<std::string>> List(const utility::PathView& path, const size_t limit, const std::string_view after) const;
+		std::string Scan(const utility::PathView& path, const ScanCallback& callback, const std::string_view resume) const;
+		size_t Glob(const utility::PathView& pattern, const ScanCallback& callback) const;
+		std::optional<double> Aggregate(const utility::PathView& path, const Aggregation aggregation) const;
+		std::optional<Usage> GetUsage(const utility::PathView& path) const;
+
+		INodePtr GetNode(const std::string_view path) const;
+
+		bool Rename(const utility::PathView& from, const utility::PathView& to) const;
+		bool Move(const utility::PathView& from, const VolumeImpl& target, const utility::PathView& to) const;
+
+		IHandlePtr Open(const std::string_view path) const;
+		std::unique_ptr<ITransaction> BeginTransaction() const;
+		std::unique_ptr<const ISnapshot> TakeSnapshot() const;
+		std::shared_ptr<VolumeImpl> Clone() const;
+		std::shared_ptr<VolumeImpl> Freeze() const;
 
 		void AddRef() noexcept;
 		void Release() noexcept;
@@ -30,14 +75,70 @@ namespace jb_storage
 		bool Load(std::istream& is) const;
 		bool Save(std::ostream& os) const;
 
+		utility::ConcurrencyLimiter& GetLimiter() const noexcept { return _limiter; }
+
+		void SetDedupThreshold(const size_t threshold) const { _values->SetThreshold(threshold); }
+		bool SetMemoryBudget(const size_t budget, const std::string& path) const;
+
+		void EnableStats(const bool enable) const { _metrics.Enable(enable); }
+		Stats GetStats() const;
+
 	private:
 		explicit VolumeImpl(NodePtr&& root) noexcept;
+		explicit VolumeImpl(std::shared_ptr<const FrozenImpl>&& frozen);
 
+		// the value with the deadline of the node, 0 for none (see utility::GetTick())
+		bool Set(const utility::PathView& path, Value&& value, const int64_t deadline) const;
 		bool IsUsed() const noexcept;
+
+		// estimate of the memory the nodes in it take, those of spilled subtrees aside
+		uint64_t GetResidentSize() const noexcept;
+		// schedules a pass spilling cold subtrees, if the volume is over budget (see utility::Spiller)
+		void KeepInBudget() const;
+		// the pass, run off the operations that find the volume over budget
+		void SpillCold() const;
 	};
 
 	using VolumeImplPtr = std::shared_ptr<VolumeImpl>;
 
+	// Makes a tree out of nodes given in depth first order, children in key order after their parent. Nothing
+	// else sees the nodes until it's done, so they're linked with no locking, each child appended at the end
+	// of its parent's map, and totals are added up as nodes are finished, the way VolumeNode::Deserialize()
+	// does it.
+	class VolumeBuilderImpl final
+	{
+	private:
+		using NodePtr = std::shared_ptr<VolumeNode>;
+
+		struct Frame
+		{
+			NodePtr				Node;
+			std::string_view	Name;	// the key in the parent's map
+		};
+
+		std::vector<Frame>	_stack;		// nodes still open, from the root down
+		bool				_started{ false };
+
+	public:
+		VolumeBuilderImpl();
+
+		// Sets the value of the node at path, making the nodes on the way that aren't there yet. False if the
+		// path doesn't come after all those given so far.
+		bool Add(const utility::PathView& path, Value&& value);
+
+		// the tree of the other builder, which is left empty, becomes the subtree at path, as if it was added
+		bool Attach(const utility::PathView& path, VolumeBuilderImpl& subtree);
+
+		// the builder is left empty
+		VolumeImplPtr Finish();
+
+	private:
+		bool Reach(const utility::PathView& path);
+		void Open(const std::string_view name, NodePtr&& node);
+		void Close();
+		NodePtr TakeRoot();
+	};
+
 }
 
 #endif
@@ -0,0 +1,1405 @@
+#ifndef STORAGE_VOLUMENODE_H
+#define STORAGE_VOLUMENODE_H
+
+#include "Atomic.h"
+#include "INode.h"
+#include "Metrics.h"
+#include "Mutex.h"
+#include "Reclaimer.h"
+#include "Serialization.h"
+#include "SnapshotClock.h"
+#include "SpillArea.h"
+#include "TimerWheel.h"
+#include "ValueStore.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <istream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+namespace jb_storage
+{
+
+	// Besides its own value every node keeps the totals of its subtree (see Usage). A change is carried up
+	// by Propagate() along raw links to parents, each guarded by the child's edge lock: a node is unlinked
+	// from its parent, when detached or destroyed, under that lock only, which makes the link safe to follow
+	// while held and lets a detach account for exactly the changes that made it past the node.
+	// For snapshots a node keeps its past states that live ones may see, as frozen copies sharing children
+	// with it (see Stamp()); those are dropped as the node changes further, or once the snapshots that see
+	// them are released. Totals are kept for them as well, since clones need those of their origins (see
+	// Materialize()); snapshots of clones are seen by the tree cloned only (see FindClones()). A node of a
+	// clone copies the value of its origin on first read, and lists children through it till it's first changed.
+	// A node set with a deadline reads as missing once it's past, its parent skipping it on every lookup, until
+	// the Expirer takes it out; it counts in the totals till then.
+	// A stub is a node whose children are spilled to disk (see SpilledNode), to be read back on first touch.
+	// The overrides of INode are final, for calls through BaseImpl<VolumeNode> to bind statically.
+	class VolumeNode : public INode
+	{
+		friend class VolumeBuilderImpl;
+		friend class SpilledNode;
+
+		using NodePtr = std::shared_ptr<VolumeNode>;
+
+		// placeholders reached through a node of a clone are swept once there are that many of them, and from
+		// then on once they've doubled
+		static constexpr size_t MinSweepSize{ 16 };
+
+		struct Past
+		{
+			uint64_t	Since;
+			uint64_t	Until;
+			NodePtr		Node;
+		};
+
+		struct PastUsage
+		{
+			uint64_t	Since;
+			uint64_t	Until;
+			Usage		Totals;
+		};
+
+		// What a node of a clone stands for: the origin as of the time of the lease. Until the node is
+		// materialized, its children looked up by name are kept as reached, for those who hold them to go on
+		// seeing the same nodes; the lock guards those, taken with the node locked, shared will do.
+		struct Origin
+		{
+			NodePtr													Node;
+			std::shared_ptr<const utility::SnapshotClock::Lease>	Lease;
+			std::once_flag											Materialized;
+			std::atomic<bool>										Filled{ false };
+			std::once_flag											ValueCopied;
+			std::mutex												Lock;
+			std::map<std::string, NodePtr, std::less<>>				Reached;
+			size_t													SweepAt{ MinSweepSize };
+
+			Origin(NodePtr node, std::shared_ptr<const utility::SnapshotClock::Lease> lease)
+				: Node{ std::move(node) }, Lease{ std::move(lease) }
+			{ }
+		};
+
+		// Lists the node with the clock while it keeps states or totals for snapshots, so that they're dropped
+		// once those are released rather than on its next change (see Prune()). The lock keeps the node from
+		// being destroyed meanwhile, it's forgotten then. It's unlisted before it's pruned, so that whatever
+		// is kept meanwhile lists it anew.
+		struct Keeper final : utility::SnapshotClock::IKeeper
+		{
+			std::mutex			Lock;
+			VolumeNode*			Node;
+			std::atomic<bool>	Listed{ false };
+
+			explicit Keeper(VolumeNode* const node) noexcept : Node{ node } { }
+
+			bool Prune() override
+			{
+				std::lock_guard lock{ Lock };
+				if (!Node)
+					return false;
+
+				Listed.store(false);
+				if (!Node->Prune())
+					return false;
+
+				Listed.store(true);
+				return true;
+			}
+
+			void Forget()
+			{
+				std::lock_guard lock{ Lock };
+				Node = nullptr;
+			}
+		};
+
+		// State a node takes on only once it's asked for, kept aside so that plain nodes go without it: made
+		// on first need (see GetExtra()) and kept till the node is gone. The deadline is set under the node's
+		// lock, past totals under the edge lock, the scope of
+		// clones before the root is shared; the keeper is made once.
+		struct Extra
+		{
+			const std::unique_ptr<Origin>					Source;
+			std::atomic<int64_t>							Deadline{ 0 };	// tick it expires at (see utility::GetTick()), 0 for never
+			std::vector<PastUsage>							PastTotals;
+			std::shared_ptr<utility::SnapshotClock::Scope>	Clones;			// of the volume, on its root
+			std::once_flag									KeptOnce;
+			std::shared_ptr<Keeper>							Kept;			// made once something is first kept
+
+			explicit Extra(std::unique_ptr<Origin> source = nullptr) noexcept
+				: Source{ std::move(source) }
+			{ }
+		};
+
+	private:
+		Value										_value;
+		utility::ValueStore::Payload				_payload;		// instead of the value, if it's shared
+		std::map<std::string, NodePtr, std::less<>>	_children;
+		MutexType									_lock;
+		std::atomic<uint64_t>						_version{ 0 };	// bumped under a shared lock by UpdateValue()
+		uint64_t									_stamp{ 0 };	// time the current state was made at
+		std::vector<Past>							_past;
+		std::atomic<Extra*>							_extra{ nullptr };
+
+		// of a node of a clone, the totals count what its subtree differs by from the origin's
+		VolumeNode*									_parent{ nullptr };
+		std::atomic<uint64_t>						_nodes{ 0 };
+		std::atomic<uint64_t>						_key_bytes{ 0 };
+		std::atomic<uint64_t>						_value_bytes{ 0 };
+		uint64_t									_usage_stamp{ 0 };	// time of the latest change in the totals
+		mutable SpinLock							_edge_lock;
+
+		// packed along with the edge lock
+		mutable std::atomic<uint32_t>				_access{ SpillArea::GetEpoch() };	// epoch of the latest touch
+		std::atomic<bool>							_stub{ false };	// set on a SpilledNode while its children are out
+
+	public:
+		VolumeNode() = default;
+
+		// node of a clone, empty until it's materialized; stamp is the time the clone was made at
+		VolumeNode(NodePtr origin, std::shared_ptr<const utility::SnapshotClock::Lease> lease, const uint64_t stamp)
+			: _stamp{ stamp }, _extra{ new Extra{ std::make_unique<Origin>(std::move(origin), std::move(lease)) } }, _usage_stamp{ stamp }
+		{ }
+
+		// subtree is torn down level by level rather than through nested destructors, so that its depth
+		// is not limited by the stack; nodes pinned by someone else are left to their owners
+		~VolumeNode() override
+		{
+			const std::unique_ptr<Extra> extra{ _extra.load(std::memory_order_relaxed) };
+			if (extra && extra->Kept)
+				extra->Kept->Forget();
+
+			std::vector<NodePtr> orphans;
+			StealChildren(orphans);
+
+			while (!orphans.empty())
+			{
+				NodePtr node{ std::move(orphans.back()) };
+				orphans.pop_back();
+
+				// the lock orders this after whatever the last ones who pinned the node did with it
+				if (node.use_count() == 1)
+				{
+					std::lock_guard lock{ node->_lock };
+					node->StealChildren(orphans);
+				}
+			}
+
+			// a change on its way up may still be passing through
+			std::lock_guard lock{ _edge_lock };
+		}
+
+		std::optional<Value> GetValue() const final
+		{
+			Access();
+			CopyValue();
+
+			return _payload ? Value{ *_payload } : utility::LoadValue(_value);
+		}
+
+		// a node of a clone copies the value of its origin for good, the pointer being kept
+		const Value* PeekValue() const final
+		{
+			Access();
+			CopyValue();
+
+			return &GetOwnValue();
+		}
+
+		bool GrowBranchAndSetValue(const utility::PathView& path, Value&& value) final
+		{ return GrowBranchAndSetValue(path, std::move(value), nullptr, 0); }
+
+		// The same with a payload shared with other nodes instead of the value, if given one (see utility::ValueStore),
+		// and the deadline of the node the value is set to, 0 for none; setting a value clears the one it had.
+		// An expired child in the way is replaced, the way a missing one is made.
+		bool GrowBranchAndSetValue(const utility::PathView& path, Value&& value, utility::ValueStore::Payload&& payload, const int64_t deadline)
+		{
+			const uint64_t value_size{ utility::GetValueSize(payload ? *payload : value) };
+
+			Materialize();
+			Stamp();
+
+			if (!path.IsEmpty())
+			{
+				// every node of the new branch is given the totals of the part below it
+				uint64_t nodes{ 0 }, key_bytes{ 0 };
+				for (const auto& key : path)
+				{
+					++nodes;
+					key_bytes += key.size();
+				}
+
+				auto key{ path.begin() };
+
+				auto new_subbranch{ std::make_shared<VolumeNode>() };
+				auto tail{ new_subbranch };
+
+				const auto new_subbranch_name{ *key++ };
+				uint64_t below{ nodes - 1 }, below_key_bytes{ key_bytes - new_subbranch_name.size() };
+				new_subbranch->SetTotals(below, below_key_bytes, value_size);
+				new_subbranch->_stamp = new_subbranch->_usage_stamp = _stamp;
+
+				for (const auto end{ path.end() }; key != end; ++key)
+				{
+					tail = tail->SetChild(*key, std::make_shared<VolumeNode>());
+					tail->SetTotals(--below, below_key_bytes -= (*key).size(), value_size);
+					tail->_stamp = tail->_usage_stamp = _stamp;
+				}
+
+				tail->Assign(std::move(value), std::move(payload));
+				tail->SetDeadline(deadline);
+
+				if (const auto expired{ _children.find(new_subbranch_name) }; expired != _children.end())
+					utility::Reclaimer::Instance().RetireLocked(Remove(expired));
+
+				SetChild(new_subbranch_name, std::move(new_subbranch));
+				Propagate(Usage{ nodes, key_bytes, value_size });
+				Touch();
+			}
+			else
+			{
+				const uint64_t old_size{ utility::GetValueSize(GetOwnValue()) };
+				Assign(std::move(value), std::move(payload));
+				SetDeadline(deadline);
+				Touch();
+
+				if (value_size != old_size)
+					Propagate(Usage{ 0, 0, value_size - old_size });
+			}
+
+			return true;
+		}
+
+		// integer values are of fixed size, so the totals stay; the node is left with its stamp when updated
+		// under a shared lock, which is fine as long as no live snapshot sees the state (see SnapshotImpl for
+		// one taken meanwhile)
+		std::optional<bool> UpdateValue(const std::function<bool(Value&)>& update, const bool exclusive) final
+		{
+			Materialize();
+
+			// shared payloads are strings and blobs, none of which is updated in place
+			if (_payload)
+				return false;
+
+			if (!exclusive && utility::SnapshotClock::Instance().IsSeen(_stamp, FindClones().get()))
+				return std::nullopt;
+
+			if (exclusive)
+				Stamp();
+
+			if (!update(_value))
+				return false;
+
+			Touch();
+			return true;
+		}
+
+		INodePtr GetChild(const std::string_view name) const final
+		{ return FindChild(name); }
+
+		NodePtr FindChild(const std::string_view name) const
+		{
+			const auto child{ FindStanding(name) };
+			return child && !child->IsExpired() ? child : nullptr;
+		}
+
+		INodePtr GetChildAsOf(const std::string_view name, const int64_t tick) const final
+		{ return FindChildAsOf(name, tick); }
+
+		NodePtr FindChildAsOf(const std::string_view name, const int64_t tick) const
+		{
+			const auto child{ FindStanding(name) };
+			return child && !child->IsExpired(tick) ? child : nullptr;
+		}
+
+		// the child set with the deadline, expired or not
+		NodePtr FindChild(const std::string_view name, const int64_t deadline) const
+		{
+			const auto child{ FindStanding(name) };
+			return child && child->GetDeadline() == deadline ? child : nullptr;
+		}
+
+		// Hands the child over to the target under a new name, subtree and all; both nodes are expected to
+		// be locked exclusively. Returns the child, nothing if there's no such child or the name is taken by
+		// another one that hasn't expired. The child is unlinked first, so that the totals on the way up from
+		// it stop at it until it's linked again; its deadline goes along, and the move is counted on it.
+		NodePtr MoveChild(const std::string_view name, VolumeNode& target, const std::string_view target_name)
+		{
+			Materialize();
+			target.Materialize();
+
+			const auto child{ _children.find(name) };
+			if (child == _children.end() || child->second->IsExpired())
+				return nullptr;
+
+			const auto taken{ target._children.find(target_name) };
+			if (taken != target._children.end() && !taken->second->IsExpired())
+				return nullptr;
+
+			Stamp();
+			if (&target != this)
+				target.Stamp();
+
+			if (taken != target._children.end())
+				utility::Reclaimer::Instance().RetireLocked(target.Remove(taken));
+
+			NodePtr moved{ std::move(child->second) };
+			_children.erase(child);
+			moved->AddMove();
+			Touch();
+
+			const auto usage{ moved->Unlink() };
+			Propagate(Usage{ 0 - usage.Nodes - 1, 0 - usage.KeyBytes - name.size(), 0 - usage.ValueBytes });
+
+			const auto linked{ moved->Link(&target) };
+			target._children.emplace(std::string{ target_name }, moved);
+			target.Touch();
+			target.Propagate(Usage{ linked.Nodes + 1, linked.KeyBytes + target_name.size(), linked.ValueBytes });
+
+			return moved;
+		}
+
+		INodePtr DetachChild(const std::string_view name) final
+		{
+			Materialize();
+
+			// std::map::erase with equivalent key comparison appears in c++23 only
+			if (const auto child{ _children.find(name) }; child != _children.end())
+			{
+				Stamp();
+				return Remove(child);
+			}
+
+			return nullptr;
+		}
+
+		// Takes out the children the timers are for, those that are still there and past the deadlines the
+		// timers were set for, under a single stamp; the node is expected to be locked exclusively
+		template < typename Iterator >
+		void ExpireChildren(Iterator timer, const Iterator end, const int64_t now, std::vector<NodePtr>& expired)
+		{
+			Materialize();
+
+			bool stamped{ false };
+			for (; timer != end; ++timer)
+			{
+				const auto node{ timer->Node.lock() };
+				if (!node || node->GetDeadline() != timer->Deadline || !node->IsExpired(now))
+					continue;
+
+				const auto child{ _children.find(timer->Name) };
+				if (child == _children.end() || child->second != node)
+					continue;
+
+				if (!std::exchange(stamped, true))
+					Stamp();
+
+				expired.push_back(Remove(child));
+			}
+		}
+
+		int64_t GetDeadline() const noexcept
+		{
+			const auto extra{ FindExtra() };
+			return extra ? extra->Deadline.load(std::memory_order_relaxed) : 0;
+		}
+
+		bool IsExpired() const noexcept
+		{
+			const auto deadline{ GetDeadline() };
+			return deadline && deadline <= utility::GetTick();
+		}
+
+		bool IsExpired(const int64_t now) const noexcept
+		{
+			const auto deadline{ GetDeadline() };
+			return deadline && deadline <= now;
+		}
+
+		void ListChildren(const std::string_view after, const size_t limit, INodeChildren& children) const final
+		{ ListChildrenImpl(after, limit, children, utility::GetTick()); }
+
+		void ListChildren(const std::string_view after, const size_t limit, std::vector<std::pair<std::string, NodePtr>>& children) const
+		{ ListChildrenImpl(after, limit, children, utility::GetTick()); }
+
+		void ListChildrenAsOf(const std::string_view after, const size_t limit, INodeChildren& children, const int64_t tick) const final
+		{ ListChildrenImpl(after, limit, children, tick); }
+
+		void ListChildrenAsOf(const std::string_view after, const size_t limit, std::vector<std::pair<std::string, NodePtr>>& children, const int64_t tick) const
+		{ ListChildrenImpl(after, limit, children, tick); }
+
+		void CollectChildren(std::vector<INodePtr>& children) const final
+		{ CollectChildrenImpl(children); }
+
+		void CollectChildren(std::vector<NodePtr>& children) const
+		{ CollectChildrenImpl(children); }
+
+		void lock() final
+		{ _lock.lock(); }
+
+		bool try_lock() final
+		{ return _lock.try_lock(); }
+
+		void unlock() final
+		{ _lock.unlock(); }
+
+		void lock_shared() final
+		{ _lock.lock_shared(); }
+
+		bool try_lock_shared() final
+		{ return _lock.try_lock_shared(); }
+
+		void unlock_shared() final
+		{ _lock.unlock_shared(); }
+
+		Usage GetUsage() const final
+		{
+			auto usage{ GetCounters() };
+			AddOriginUsage(usage);
+
+			return usage;
+		}
+
+		// totals as of the time of a live snapshot
+		Usage GetUsageAt(const uint64_t time) const
+		{
+			Usage usage;
+			{
+				std::lock_guard lock{ _edge_lock };
+				usage = GetCounters();
+
+				if (const auto extra{ FindExtra() }; extra && time < _usage_stamp)
+					for (const auto& past : extra->PastTotals)
+						if (past.Since <= time && time < past.Until)
+						{
+							usage = past.Totals;
+							break;
+						}
+			}
+
+			AddOriginUsage(usage);
+			return usage;
+		}
+
+		uint64_t GetVersion() const final
+		{ return _version.load(std::memory_order_relaxed); }
+
+		INodePtr GetPast(const uint64_t time) const final
+		{ return FindPast(time); }
+
+		NodePtr FindPast(const uint64_t time) const
+		{
+			if (_stamp <= time)
+				return nullptr;
+
+			for (auto past{ _past.rbegin() }, rend{ _past.rend() }; past != rend; ++past)
+				if (past->Since <= time && time < past->Until)
+					return past->Node;
+
+			// made after the snapshot was taken, which may reach it through a later mount only
+			return std::make_shared<VolumeNode>();
+		}
+
+		bool CollectMountedNodes(std::vector<INodePtr>&) const final
+		{ return false; }
+
+		bool IsClone() const noexcept
+		{ return GetOrigin() != nullptr; }
+
+		// to be called on the root of a volume before anyone else reaches it
+		void SetClones(std::shared_ptr<utility::SnapshotClock::Scope> clones)
+		{ GetExtra().Clones = std::move(clones); }
+
+		// A node of a clone is filled from its origin before it's first changed: the value is copied and every
+		// child is given a node standing for the origin's one, the one reached already if any, so that nodes
+		// are copied level by level down the paths changed only. Lists go through to the origin till then.
+		// To be called with the node locked, shared will do.
+		void Materialize() const
+		{
+			Access();
+
+			if (const auto origin{ GetOrigin() })
+				std::call_once(origin->Materialized, [this]() { const_cast<VolumeNode*>(this)->Fill(); });
+		}
+
+		// memory a node takes besides its key and value, itself and its entry in the parent's map, roughly
+		static constexpr uint64_t GetNodeFootprint() noexcept
+		{ return sizeof(VolumeNode) + 64; }
+
+		static uint64_t GetFootprint(const Usage& usage) noexcept
+		{ return usage.KeyBytes + usage.ValueBytes + usage.Nodes * GetNodeFootprint(); }
+
+		// Children touched last before the epoch before the given one, by no operation since the pass before
+		// the last began, go to cold, the rest to hot; to be called with the node locked, shared will do.
+		// Neither a stub nor a node of a clone has any to sort.
+		void SortChildren(const uint32_t epoch, std::vector<std::pair<std::string, NodePtr>>& cold, std::vector<NodePtr>& hot) const
+		{
+			// a stub filled back in meanwhile under a shared lock as well has its children in sight
+			if (GetOrigin() || _stub.load(std::memory_order_acquire))
+				return;
+
+			for (const auto& child : _children)
+				if (child.second->_access.load(std::memory_order_relaxed) + 1 < epoch)
+					cold.push_back(child);
+				else
+					hot.push_back(child.second);
+		}
+
+		void DetachChildren() noexcept
+		{
+			for (const auto& child : _children)
+				child.second->Detach();
+		}
+
+		// this node is expected to be locked and other one to be out of anyone else's reach, so that the only
+		// concurrent changes are those on their way up from the former children of this node
+		void swap(VolumeNode& other)
+		{
+			Materialize();
+			Stamp();
+
+			const auto other_usage{ other.GetUsage() };
+
+			_value.swap(other._value);
+			_payload.swap(other._payload);
+			_children.swap(other._children);
+			Touch();
+
+			for (const auto& child : _children)
+				child.second->SetParent(this);
+			for (const auto& child : other._children)
+				child.second->SetParent(&other);
+
+			// changes that got past the former children before they were handed over are in by now
+			const auto clones{ FindClones() };
+			Usage usage;
+			{
+				std::lock_guard lock{ _edge_lock };
+				usage = GetUsage();
+				AddUsage(Usage{ other_usage.Nodes - usage.Nodes, other_usage.KeyBytes - usage.KeyBytes, other_usage.ValueBytes - usage.ValueBytes }, _stamp, clones.get());
+			}
+
+			other.Propagate(Usage{ usage.Nodes - other_usage.Nodes, usage.KeyBytes - other_usage.KeyBytes, usage.ValueBytes - other_usage.ValueBytes });
+		}
+
+		// both directions walk the tree with an explicit stack rather than recursion, so that a deep tree
+		// doesn't overflow the call stack; a clone is saved as read through, nothing materialized, and a stub
+		// as copied from the file, nothing read back. Nodes expired as of the start are left out, deadlines of
+		// the rest aren't saved. To be called with the node locked: those below are locked shared for as long
+		// as their children are being saved, since handles and the Expirer change them without going through
+		// this one.
+		void Serialize(std::ostream& os) const
+		{
+			std::vector<SerializedChildren> stack(1);
+			utility::SharedValueWriter writer;
+			const auto now{ utility::GetTick() };
+
+			SerializeOwn(os, writer, now, stack.back());
+
+			while (!stack.empty())
+			{
+				auto& children{ stack.back() };
+
+				while (children.Next != children.End && children.Next->second->IsExpired(now))
+					++children.Next;
+
+				VolumeNode* child;
+				if (children.Next != children.End)
+				{
+					utility::Serialize(children.Next->first, os);
+					child = children.Next++->second.get();
+				}
+				else if (children.Index != children.Listed.size())
+				{
+					utility::Serialize(children.Listed[children.Index].first, os);
+					child = children.Listed[children.Index++].second.get();
+				}
+				else
+				{
+					stack.pop_back();
+					continue;
+				}
+
+				SerializedChildren grandchildren;
+				grandchildren.Lock = std::shared_lock{ *child };
+				child->SerializeOwn(os, writer, now, grandchildren);
+				stack.push_back(std::move(grandchildren));
+			}
+		}
+
+		// fills the node, which is expected to be brand new; payloads saved once are shared through the store,
+		// if given one
+		void Deserialize(std::istream& is, utility::ValueStore* const store)
+		{
+			std::vector<std::pair<VolumeNode*, uint64_t>> stack;
+			utility::SharedValueReader reader{ store };
+			stack.emplace_back(this, DeserializeOwn(is, reader));
+
+			while (!stack.empty())
+			{
+				auto& [node, left] = stack.back();
+				if (!left)
+				{
+					const VolumeNode* const finished{ node };
+					stack.pop_back();
+
+					if (!stack.empty())
+					{
+						const auto usage{ finished->GetUsage() };
+						VolumeNode* const parent{ stack.back().first };
+						parent->_nodes.fetch_add(usage.Nodes, std::memory_order_relaxed);
+						parent->_key_bytes.fetch_add(usage.KeyBytes, std::memory_order_relaxed);
+						parent->_value_bytes.fetch_add(usage.ValueBytes, std::memory_order_relaxed);
+					}
+
+					continue;
+				}
+
+				--left;
+
+				auto name{ utility::Deserialize<std::string>(is) };
+				auto child{ std::make_shared<VolumeNode>() };
+				const auto count{ child->DeserializeOwn(is, reader) };
+
+				// totals of a finished child are added up to its parent once the child is popped
+				VolumeNode* const parent{ node };
+				parent->_nodes.fetch_add(1, std::memory_order_relaxed);
+				parent->_key_bytes.fetch_add(name.size(), std::memory_order_relaxed);
+				child->_parent = parent;
+
+				// children are saved in order, so the hint makes insertion O(1); the parent is taken before
+				// emplace_back invalidates the reference to the top of the stack
+				stack.emplace_back(child.get(), count);
+				parent->_children.insert_or_assign(parent->_children.end(), std::move(name), std::move(child));
+			}
+		}
+
+	private:
+		// children of a node being saved that are yet to be, with the node locked till they're done: those of
+		// a node of a clone not materialized are listed up front
+		struct SerializedChildren
+		{
+			std::shared_lock<VolumeNode>								Lock;
+			std::map<std::string, NodePtr, std::less<>>::const_iterator	Next;
+			std::map<std::string, NodePtr, std::less<>>::const_iterator	End;
+			std::vector<std::pair<std::string, NodePtr>>				Listed;
+			size_t														Index{ 0 };
+		};
+
+		// those expired are left out of the children, the rest counted; a stub saves its own way
+		virtual void SerializeOwn(std::ostream& os, utility::SharedValueWriter& writer, const int64_t now, SerializedChildren& children) const
+		{
+			const auto unexpired = [now](const auto& child) { return !child.second->IsExpired(now); };
+
+			Access();
+			CopyValue();
+
+			// integers may be updated in place meanwhile, the node being locked shared only
+			if (std::holds_alternative<uint64_t>(_value) || std::holds_alternative<uint32_t>(_value))
+				writer.Write(utility::LoadValue(_value), nullptr, os);
+			else
+				writer.Write(_value, _payload.get(), os);
+
+			if (!IsMaterialized())
+			{
+				ListStanding({ }, std::numeric_limits<size_t>::max(), children.Listed);
+				children.Listed.erase(std::remove_if(children.Listed.begin(), children.Listed.end(), std::not_fn(unexpired)), children.Listed.end());
+
+				utility::Serialize(static_cast<uint64_t>(children.Listed.size()), os);
+				return;
+			}
+
+			children.Next = _children.begin();
+			children.End = _children.end();
+
+			utility::Serialize(static_cast<uint64_t>(std::count_if(_children.begin(), _children.end(), unexpired)), os);
+		}
+
+		// a subtree Serialize() wrote with a writer of its own goes on with this one, node by node: a spilled
+		// one is never set to expire, so it's copied as it is bar the numbers of shared payloads
+		static void CopySerialized(std::istream& is, utility::SharedValueWriter& writer, std::ostream& os)
+		{
+			std::vector<uint64_t> numbers;
+			std::vector<uint64_t> stack;
+
+			writer.Copy(is, numbers, os);
+			stack.push_back(utility::Deserialize<uint64_t>(is));
+			utility::Serialize(stack.back(), os);
+
+			while (!stack.empty())
+			{
+				if (!stack.back())
+				{
+					stack.pop_back();
+					continue;
+				}
+
+				--stack.back();
+
+				utility::Serialize(utility::Deserialize<std::string>(is), os);
+				writer.Copy(is, numbers, os);
+				stack.push_back(utility::Deserialize<uint64_t>(is));
+				utility::Serialize(stack.back(), os);
+			}
+		}
+
+		uint64_t DeserializeOwn(std::istream& is, utility::SharedValueReader& reader)
+		{
+			reader.Read(is, _value, _payload);
+			_value_bytes.store(utility::GetValueSize(GetOwnValue()), std::memory_order_relaxed);
+
+			return utility::Deserialize<uint64_t>(is);
+		}
+
+		const Value& GetOwnValue() const noexcept
+		{ return _payload ? *_payload : _value; }
+
+		Extra* FindExtra() const noexcept
+		{ return _extra.load(std::memory_order_acquire); }
+
+		// those racing to make it first agree on the one that got in
+		Extra& GetExtra()
+		{
+			auto extra{ _extra.load(std::memory_order_acquire) };
+			if (extra)
+				return *extra;
+
+			auto made{ std::make_unique<Extra>() };
+			if (_extra.compare_exchange_strong(extra, made.get(), std::memory_order_acq_rel, std::memory_order_acquire))
+				extra = made.release();
+
+			return *extra;
+		}
+
+		Origin* GetOrigin() const noexcept
+		{
+			const auto extra{ FindExtra() };
+			return extra ? extra->Source.get() : nullptr;
+		}
+
+		// a node set to expire never takes no extra for it
+		void SetDeadline(const int64_t deadline)
+		{
+			if (const auto extra{ deadline ? &GetExtra() : FindExtra() })
+				extra->Deadline.store(deadline, std::memory_order_relaxed);
+		}
+
+		// the payload, if any, stands for the value; the one dropped may leave its store
+		void Assign(Value&& value, utility::ValueStore::Payload&& payload) noexcept
+		{
+			_value = std::move(value);
+			_payload = std::move(payload);
+		}
+
+		void Touch() noexcept
+		{ _version.fetch_add(1, std::memory_order_relaxed); }
+
+		// To be called with the node locked exclusively before its state changes: the state is kept for live
+		// snapshots that may see it, and the node is stamped with the current time. The children map is
+		// copied, once per snapshot at most, while frozen copies share the children themselves.
+		void Stamp()
+		{
+			auto& clock{ utility::SnapshotClock::Instance() };
+			const auto time{ clock.GetTime() };
+			const auto clones{ FindClones() };
+
+			DropUnseen(clock, clones.get());
+
+			if (time != _stamp && clock.IsSeen(_stamp, clones.get()))
+			{
+				auto frozen{ std::make_shared<VolumeNode>() };
+				frozen->_value = _value;
+				frozen->_payload = _payload;
+				frozen->_children = _children;
+				frozen->_stamp = _stamp;
+				frozen->SetDeadline(GetDeadline());
+
+				_past.push_back(Past{ _stamp, time, std::move(frozen) });
+				List(GetExtra());
+			}
+
+			_stamp = time;
+		}
+
+		void List(Extra& extra)
+		{
+			std::call_once(extra.KeptOnce, [this, &extra]() { extra.Kept = std::make_shared<Keeper>(this); });
+			if (!extra.Kept->Listed.exchange(true))
+				utility::SnapshotClock::Instance().Keep(extra.Kept);
+		}
+
+		// Drops the states and the totals no live snapshot sees anymore, once one is released, and tells
+		// whether any are left; the states of a node busy changing are left to the change.
+		bool Prune()
+		{
+			auto& clock{ utility::SnapshotClock::Instance() };
+			const auto clones{ FindClones() };
+
+			bool left{ true };
+			if (std::unique_lock lock{ *this, std::try_to_lock }; lock)
+			{
+				DropUnseen(clock, clones.get());
+				left = !_past.empty();
+			}
+
+			std::lock_guard lock{ _edge_lock };
+			const auto extra{ FindExtra() };
+			DropUnseenTotals(*extra, clock, clones.get());
+
+			return left || !extra->PastTotals.empty();
+		}
+
+		// states no live snapshot sees anymore go; to be called with the node locked exclusively
+		void DropUnseen(const utility::SnapshotClock& clock, const utility::SnapshotClock::Scope* const clones)
+		{
+			if (_past.empty())
+				return;
+
+			const auto unseen{ std::remove_if(_past.begin(), _past.end(), [&clock, clones](const Past& past) { return !clock.IsSeen(past.Since, past.Until, clones); }) };
+			for (auto past{ unseen }; past != _past.end(); ++past)
+				utility::Reclaimer::Instance().RetireLocked(std::move(past->Node));
+
+			_past.erase(unseen, _past.end());
+		}
+
+		// Every touch is marked with the epoch, for eviction passes to tell cold subtrees by; a stub reads its
+		// children back then. To be called with the node locked, shared will do.
+		void Access() const
+		{
+			if (_stub.load(std::memory_order_acquire))
+				const_cast<VolumeNode*>(this)->FaultIn();
+
+			if (const auto epoch{ SpillArea::GetEpoch() }; _access.load(std::memory_order_relaxed) != epoch)
+				_access.store(epoch, std::memory_order_relaxed);
+		}
+
+		bool IsMaterialized() const noexcept
+		{
+			const auto origin{ GetOrigin() };
+			return !origin || origin->Filled.load(std::memory_order_acquire);
+		}
+
+		// reads the children of a stub back (see SpilledNode), called while they're out
+		virtual void FaultIn()
+		{ }
+
+		// the origin as of the time of the lease, under its lock
+		template < typename Reader >
+		auto ReadOrigin(const Reader& reader) const
+		{
+			const auto& origin{ *GetOrigin() };
+			std::shared_lock lock{ *origin.Node };
+			const auto past{ origin.Node->FindPast(origin.Lease->GetTime()) };
+
+			return reader(past ? *past : *origin.Node);
+		}
+
+		// may be called under a shared lock, which readers hold as well: the children are in sight of them once
+		// the node is marked filled
+		void Fill()
+		{
+			auto& origin{ *GetOrigin() };
+
+			CopyValue();
+
+			std::vector<std::pair<std::string, NodePtr>> listed;
+			std::vector<int64_t> deadlines;
+			ReadOrigin([&](const VolumeNode& source)
+			{
+				source.ListStanding({ }, std::numeric_limits<size_t>::max(), listed);
+				for (const auto& child : listed)
+					deadlines.push_back(GetOriginDeadline(*child.second));
+			});
+
+			std::lock_guard lock{ origin.Lock };
+			for (size_t i{ 0 }; i < listed.size(); ++i)
+			{
+				auto& [name, child] = listed[i];
+				const auto reached{ origin.Reached.find(name) };
+				auto node{ reached != origin.Reached.end() ? std::move(reached->second) : StandIn(child, deadlines[i], this) };
+				_children.emplace_hint(_children.end(), std::move(name), std::move(node));
+			}
+
+			origin.Reached.clear();
+			origin.Filled.store(true, std::memory_order_release);
+		}
+
+		// A node of a clone reads the value of its origin once, on the first read of its own, and keeps it: the
+		// origin is locked shared only, so an integer there may be updated in place as it's read, by an update
+		// under way as the clone was made (see UpdateValue()). Either value will do, the copy keeps the one read.
+		void CopyValue() const
+		{
+			if (const auto origin{ GetOrigin() })
+				std::call_once(origin->ValueCopied, [this]()
+				{
+					auto& self{ const_cast<VolumeNode&>(*this) };
+					ReadOrigin([&self](const VolumeNode& source) { source.ReadValue(self._value, self._payload); });
+				});
+		}
+
+		void ReadValue(Value& value, utility::ValueStore::Payload& payload) const
+		{
+			CopyValue();
+
+			payload = _payload;
+			value = payload ? Value{ } : utility::LoadValue(_value);
+		}
+
+		// the child of the name, expired or not; one of a node of a clone not materialized stands for the
+		// origin's one and is reached for good
+		NodePtr FindStanding(const std::string_view name) const
+		{
+			Access();
+
+			if (!IsMaterialized())
+				return Reach(name);
+
+			const auto child{ _children.find(name) };
+			return child != _children.end() ? child->second : nullptr;
+		}
+
+		// Up to the limit of children after the name, expired ones included; of a node of a clone not
+		// materialized, the ones reached, or stand-ins made for the occasion that are linked to nothing
+		void ListStanding(const std::string_view after, const size_t limit, std::vector<std::pair<std::string, NodePtr>>& children) const
+		{
+			Access();
+
+			if (!IsMaterialized())
+			{
+				const auto first{ children.size() };
+				std::vector<int64_t> deadlines;
+				ReadOrigin([&](const VolumeNode& source)
+				{
+					source.ListStanding(after, limit, children);
+					for (auto child{ children.begin() + first }; child != children.end(); ++child)
+						deadlines.push_back(GetOriginDeadline(*child->second));
+				});
+
+				auto& origin{ *GetOrigin() };
+				std::lock_guard lock{ origin.Lock };
+
+				// filled meanwhile, its children are in sight
+				if (!origin.Filled.load(std::memory_order_relaxed))
+				{
+					for (size_t i{ first }; i < children.size(); ++i)
+						if (const auto reached{ origin.Reached.find(children[i].first) }; reached != origin.Reached.end())
+							children[i].second = reached->second;
+						else
+							children[i].second = StandIn(children[i].second, deadlines[i - first], nullptr);
+
+					return;
+				}
+
+				children.erase(children.begin() + first, children.end());
+			}
+
+			auto child{ _children.upper_bound(after) };
+			for (size_t added{ 0 }; child != _children.end() && added < limit; ++child, ++added)
+				children.emplace_back(child->first, child->second);
+		}
+
+		// the stand-in kept for the origin's child of the name, made once it's reached first
+		NodePtr Reach(const std::string_view name) const
+		{
+			auto& origin{ *GetOrigin() };
+			std::vector<NodePtr> swept;
+
+			{
+				std::lock_guard lock{ origin.Lock };
+				if (origin.Filled.load(std::memory_order_relaxed))
+				{
+					const auto child{ _children.find(name) };
+					return child != _children.end() ? child->second : nullptr;
+				}
+
+				if (const auto reached{ origin.Reached.find(name) }; reached != origin.Reached.end())
+					return reached->second;
+			}
+
+			NodePtr child;
+			int64_t deadline{ 0 };
+			ReadOrigin([&](const VolumeNode& source)
+			{
+				if ((child = source.FindStanding(name)))
+					deadline = GetOriginDeadline(*child);
+			});
+
+			if (!child)
+				return nullptr;
+
+			child = StandIn(child, deadline, const_cast<VolumeNode*>(this));
+
+			std::lock_guard lock{ origin.Lock };
+			if (origin.Filled.load(std::memory_order_relaxed))
+			{
+				const auto filled{ _children.find(name) };
+				return filled != _children.end() ? filled->second : nullptr;
+			}
+
+			const auto [reached, added] = origin.Reached.try_emplace(std::string{ name }, std::move(child));
+			child = reached->second;
+
+			if (added && origin.Reached.size() >= origin.SweepAt)
+			{
+				Sweep(swept);
+				origin.SweepAt = std::max(MinSweepSize, origin.Reached.size() * 2);
+			}
+
+			return child;
+		}
+
+		// a node of this clone standing for the child of the origin, linked to the parent if given one
+		NodePtr StandIn(const NodePtr& child, const int64_t deadline, VolumeNode* const parent) const
+		{
+			auto stand_in{ std::make_shared<VolumeNode>(child, GetOrigin()->Lease, _stamp) };
+			stand_in->_parent = parent;
+			stand_in->SetDeadline(deadline);
+
+			return stand_in;
+		}
+
+		// the deadline a node of the origin had as of the time of the lease, since it's set anew in place;
+		// to be called with its parent locked
+		int64_t GetOriginDeadline(VolumeNode& node) const
+		{
+			std::shared_lock lock{ node };
+			const auto past{ node.FindPast(GetOrigin()->Lease->GetTime()) };
+
+			return (past ? *past : node).GetDeadline();
+		}
+
+		// Drops the stand-ins reached below that no one holds and that lead to no changes, which are read
+		// through the same way once reached again; to be called with the origin lock held. Those below are
+		// locked exclusively on the way down, if they can be right away, so that none of them is reached
+		// meanwhile. The ones dropped are destroyed by the caller, off the locks.
+		void Sweep(std::vector<NodePtr>& swept) const
+		{
+			struct Frame
+			{
+				Origin*																Of;
+				std::unique_lock<VolumeNode>										Lock;
+				std::map<std::string, NodePtr, std::less<>>::iterator				Next;
+			};
+
+			std::vector<Frame> stack;
+			stack.push_back(Frame{ GetOrigin(), { }, GetOrigin()->Reached.begin() });
+
+			while (true)
+			{
+				auto& frame{ stack.back() };
+				if (frame.Next == frame.Of->Reached.end())
+				{
+					if (stack.size() == 1)
+						return;
+
+					const bool unchanged{ frame.Of->Reached.empty() };
+					stack.pop_back();
+
+					auto& parent{ stack.back() };
+					if (unchanged)
+					{
+						swept.push_back(std::move(parent.Next->second));
+						parent.Next = parent.Of->Reached.erase(parent.Next);
+					}
+					else
+						++parent.Next;
+
+					continue;
+				}
+
+				const NodePtr& child{ frame.Next->second };
+				if (child.use_count() == 1 && !child->IsMaterialized())
+					if (std::unique_lock lock{ *child, std::try_to_lock }; lock && !child->IsMaterialized())
+					{
+						stack.push_back(Frame{ child->GetOrigin(), std::move(lock), child->GetOrigin()->Reached.begin() });
+						continue;
+					}
+
+				++frame.Next;
+			}
+		}
+
+		Usage GetCounters() const noexcept
+		{
+			return Usage{
+					_nodes.load(std::memory_order_relaxed),
+					_key_bytes.load(std::memory_order_relaxed),
+					_value_bytes.load(std::memory_order_relaxed) };
+		}
+
+		void AddOriginUsage(Usage& usage) const
+		{
+			if (const auto origin{ GetOrigin() })
+				Add(usage, origin->Node->GetUsageAt(origin->Lease->GetTime()));
+		}
+
+		static void Add(Usage& usage, const Usage& delta) noexcept
+		{
+			usage.Nodes += delta.Nodes;
+			usage.KeyBytes += delta.KeyBytes;
+			usage.ValueBytes += delta.ValueBytes;
+		}
+
+		void SetTotals(const uint64_t nodes, const uint64_t key_bytes, const uint64_t value_bytes) noexcept
+		{
+			_nodes.store(nodes, std::memory_order_relaxed);
+			_key_bytes.store(key_bytes, std::memory_order_relaxed);
+			_value_bytes.store(value_bytes, std::memory_order_relaxed);
+		}
+
+		// To be called with the edge lock held. Totals a live snapshot may ask for are kept as of the changes
+		// it sees, those stamped with its time or before, even if they come up after later ones did; clones
+		// are those of the tree the node is in (see FindClones()).
+		void AddUsage(const Usage& delta, const uint64_t time, const utility::SnapshotClock::Scope* const clones) noexcept
+		{
+			auto& clock{ utility::SnapshotClock::Instance() };
+
+			const auto extra{ FindExtra() };
+			if (extra)
+				DropUnseenTotals(*extra, clock, clones);
+
+			if (time > _usage_stamp)
+			{
+				if (clock.IsSeen(_usage_stamp, clones))
+				{
+					GetExtra().PastTotals.push_back(PastUsage{ _usage_stamp, time, GetCounters() });
+					List(GetExtra());
+				}
+
+				_usage_stamp = time;
+			}
+			else if (extra)
+				for (size_t i{ 0 }; i < extra->PastTotals.size(); ++i)
+				{
+					auto& past{ extra->PastTotals[i] };
+					if (past.Until <= time)
+						continue;
+
+					// the part of the range that sees the change is split off, to be added to next
+					if (past.Since < time)
+					{
+						auto split{ past };
+						split.Since = past.Until = time;
+						extra->PastTotals.insert(extra->PastTotals.begin() + i + 1, split);
+						continue;
+					}
+
+					Add(past.Totals, delta);
+				}
+
+			_nodes.fetch_add(delta.Nodes, std::memory_order_relaxed);
+			_key_bytes.fetch_add(delta.KeyBytes, std::memory_order_relaxed);
+			_value_bytes.fetch_add(delta.ValueBytes, std::memory_order_relaxed);
+		}
+
+		// to be called with the edge lock held
+		static void DropUnseenTotals(Extra& extra, const utility::SnapshotClock& clock, const utility::SnapshotClock::Scope* const clones) noexcept
+		{
+			auto& totals{ extra.PastTotals };
+			totals.erase(std::remove_if(totals.begin(), totals.end(), [&clock, clones](const PastUsage& past) { return !clock.IsSeen(past.Since, past.Until, clones); }), totals.end());
+		}
+
+		// adds the deltas, wrapping around for negative ones, to this node and all of its ancestors as made
+		// at the time of its stamp; links are followed hand over hand, so a parent can't be unlinked, nor
+		// destroyed, while it's being reached
+		void Propagate(const Usage& delta) noexcept
+		{
+			const auto clones{ FindClones() };
+
+			VolumeNode* node{ this };
+			node->_edge_lock.lock();
+
+			while (node)
+			{
+				node->AddUsage(delta, _stamp, clones.get());
+
+				VolumeNode* const parent{ node->_parent };
+				if (parent)
+					parent->_edge_lock.lock();
+
+				node->_edge_lock.unlock();
+				node = parent;
+			}
+		}
+
+		void SetParent(VolumeNode* const parent) noexcept
+		{
+			std::lock_guard lock{ _edge_lock };
+			_parent = parent;
+		}
+
+		// The scope of clones of the tree the node is in, kept on its top node; looked up only while some
+		// clone is live, following links hand over hand the way Propagate() does. Nothing for a node no
+		// longer in a volume.
+		std::shared_ptr<const utility::SnapshotClock::Scope> FindClones() const noexcept
+		{
+			if (!utility::SnapshotClock::Instance().IsScoped())
+				return nullptr;
+
+			const VolumeNode* node{ this };
+			node->_edge_lock.lock();
+
+			while (const VolumeNode* const parent{ node->_parent })
+			{
+				parent->_edge_lock.lock();
+				node->_edge_lock.unlock();
+				node = parent;
+			}
+
+			const auto extra{ node->FindExtra() };
+			std::shared_ptr<const utility::SnapshotClock::Scope> clones{ extra ? extra->Clones : nullptr };
+			node->_edge_lock.unlock();
+
+			return clones;
+		}
+
+		// children of a frozen copy are linked to the node it was copied from, if to any
+		void ClearParent(const VolumeNode* const parent) noexcept
+		{
+			std::lock_guard lock{ _edge_lock };
+			if (_parent == parent)
+				_parent = nullptr;
+		}
+
+		// totals that made it up to the parent, which is forgotten
+		Usage Unlink() noexcept
+		{
+			std::lock_guard lock{ _edge_lock };
+			_parent = nullptr;
+
+			return GetUsage();
+		}
+
+		// totals to be added up to the new parent, those of changes that come up later make it there themselves
+		Usage Link(VolumeNode* const parent) noexcept
+		{
+			std::lock_guard lock{ _edge_lock };
+			_parent = parent;
+
+			return GetUsage();
+		}
+
+		// those of a node of a clone not materialized are listed from the origin page by page, till enough of
+		// them turn out not to have expired
+		template < typename Children >
+		void ListChildrenImpl(const std::string_view after, const size_t limit, Children& children, const int64_t tick) const
+		{
+			Access();
+
+			if (!IsMaterialized())
+			{
+				std::vector<std::pair<std::string, NodePtr>> page;
+				std::string last{ after };
+
+				for (size_t added{ 0 }; added < limit; )
+				{
+					const auto wanted{ limit - added };
+
+					page.clear();
+					ListStanding(last, wanted, page);
+
+					for (auto& [name, child] : page)
+						if (!child->IsExpired(tick))
+						{
+							children.emplace_back(name, std::move(child));
+							++added;
+						}
+
+					if (page.size() < wanted)
+						return;
+
+					last = page.back().first;
+				}
+
+				return;
+			}
+
+			auto child{ _children.upper_bound(after) };
+			for (size_t added{ 0 }; child != _children.end() && added < limit; ++child)
+				if (!child->second->IsExpired(tick))
+				{
+					children.emplace_back(child->first, child->second);
+					++added;
+				}
+		}
+
+		template < typename Children >
+		void CollectChildrenImpl(Children& children) const
+		{
+			Access();
+
+			if (!IsMaterialized())
+			{
+				std::vector<std::pair<std::string, NodePtr>> listed;
+				ListStanding({ }, std::numeric_limits<size_t>::max(), listed);
+
+				for (auto& child : listed)
+					if (!child.second->IsExpired())
+						children.push_back(std::move(child.second));
+
+				return;
+			}
+
+			for (const auto& child : _children)
+				if (!child.second->IsExpired())
+					children.push_back(child.second);
+		}
+
+		void StealChildren(std::vector<NodePtr>& orphans)
+		{
+			for (auto& child : _children)
+			{
+				child.second->ClearParent(this);
+				orphans.push_back(std::move(child.second));
+			}
+
+			_children.clear();
+
+			if (const auto origin{ GetOrigin() })
+			{
+				for (auto& child : origin->Reached)
+				{
+					child.second->ClearParent(this);
+					orphans.push_back(std::move(child.second));
+				}
+
+				origin->Reached.clear();
+			}
+
+			for (auto& past : _past)
+				orphans.push_back(std::move(past.Node));
+
+			_past.clear();
+		}
+
+		NodePtr SetChild(const std::string_view name, NodePtr&& child)
+		{
+			child->SetParent(this);
+			return _children.insert_or_assign(std::string{ name }, std::move(child)).first->second;
+		}
+
+		// to be called with the node stamped; the totals the child made it up here with are taken back
+		NodePtr Remove(const decltype(_children)::iterator child)
+		{
+			NodePtr removed{ std::move(child->second) };
+			const auto name_size{ child->first.size() };
+			_children.erase(child);
+			Touch();
+
+			const auto usage{ removed->Unlink() };
+			Propagate(Usage{ 0 - usage.Nodes - 1, 0 - usage.KeyBytes - name_size, 0 - usage.ValueBytes });
+
+			removed->Detach();
+			return removed;
+		}
+	};
+
+}
+
+#endif
@@ -0,0 +1,149 @@
+#include "Aggregation.h"
+#include "Storage.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <thread>
+
+using namespace jb_storage;
+
+TEST(AggregateTest, Accumulator)
+{
+	// sizes around the lanes and the batch, so that every tail of the kernel is taken
+	for (const size_t count : { 0, 1, 7, 8, 9, 511, 512, 513, 1500 })
+	{
+		utility::NumericAccumulator accumulator, other;
+
+		for (size_t i{ 0 }; i < count; ++i)
+			(i % 3 ? accumulator : other).Add(static_cast<double>(i) - 100);
+
+		accumulator.Merge(other);
+
+		ASSERT_EQ(accumulator.GetResult(Aggregation::Count), static_cast<double>(count));
+		ASSERT_EQ(accumulator.GetResult(Aggregation::Sum), count * (count - 1.) / 2 - 100. * count);
+
+		if (count)
+		{
+			ASSERT_EQ(accumulator.GetResult(Aggregation::Min), -100);
+			ASSERT_EQ(accumulator.GetResult(Aggregation::Max), count - 101.);
+		}
+		else
+		{
+			ASSERT_FALSE(accumulator.GetResult(Aggregation::Min));
+			ASSERT_FALSE(accumulator.GetResult(Aggregation::Max));
+		}
+	}
+}
+
+TEST(AggregateTest, Integers)
+{
+	constexpr uint64_t odd{ (uint64_t{ 1 } << 53) + 1 };
+
+	// every value rounds down to 2^53 as a double, their sum doesn't
+	utility::NumericAccumulator accumulator;
+	for (size_t i{ 0 }; i < 3; ++i)
+		accumulator.Add(Value{ odd });
+
+	ASSERT_EQ(accumulator.GetResult(Aggregation::Sum), static_cast<double>(3 * odd));
+	ASSERT_EQ(accumulator.GetResult(Aggregation::Min), static_cast<double>(odd));
+
+	// sums past 64 bits carry, in a batch and across merges
+	utility::NumericAccumulator wide, other;
+	for (size_t i{ 0 }; i < 1000; ++i)
+		(i % 2 ? wide : other).Add(Value{ std::numeric_limits<uint64_t>::max() });
+	wide.Add(Value{ 0.5 });
+
+	wide.Merge(other);
+
+	ASSERT_EQ(wide.GetResult(Aggregation::Count), 1001);
+	ASSERT_EQ(wide.GetResult(Aggregation::Sum), 1000 * 18446744073709551616. - 1000 + .5);
+	ASSERT_EQ(wide.GetResult(Aggregation::Min), .5);
+	ASSERT_EQ(wide.GetResult(Aggregation::Max), static_cast<double>(std::numeric_limits<uint64_t>::max()));
+}
+
+TEST(AggregateTest, Volume)
+{
+	const Volume volume;
+
+	ASSERT_TRUE(volume.SetOrInsert("/stats", uint32_t{ 1 }));
+	ASSERT_TRUE(volume.SetOrInsert("/stats/qps", uint64_t{ 10 }));
+	ASSERT_TRUE(volume.SetOrInsert("/stats/load", 0.5f));
+	ASSERT_TRUE(volume.SetOrInsert("/stats/latency/p99", -2.5));
+	ASSERT_TRUE(volume.SetOrInsert("/stats/name", std::string{ "shard" }));
+	ASSERT_TRUE(volume.SetOrInsert("/stats/raw", Blob{ 1, 2, 3 }));
+	ASSERT_TRUE(volume.SetOrInsert("/other", uint32_t{ 100 }));
+
+	ASSERT_EQ(volume.Aggregate("/stats", Aggregation::Count), 4);
+	ASSERT_EQ(volume.Aggregate("/stats", Aggregation::Sum), 9);
+	ASSERT_EQ(volume.Aggregate("/stats", Aggregation::Min), -2.5);
+	ASSERT_EQ(volume.Aggregate("/stats", Aggregation::Max), 10);
+
+	ASSERT_EQ(volume.Aggregate("/", Aggregation::Sum), 109);
+	ASSERT_EQ(volume.Aggregate("/stats/qps", Aggregation::Max), 10);
+
+	ASSERT_FALSE(volume.Aggregate("/none", Aggregation::Count));
+	ASSERT_EQ(volume.Aggregate("/stats/name", Aggregation::Count), 0);
+	ASSERT_EQ(volume.Aggregate("/stats/name", Aggregation::Sum), 0);
+	ASSERT_FALSE(volume.Aggregate("/stats/name", Aggregation::Min));
+	ASSERT_EQ(volume.Aggregate("/stats/latency", Aggregation::Max), -2.5);
+}
+
+TEST(AggregateTest, Large)
+{
+	const Volume volume;
+
+	// wide and deep parts, so that the reduction is split across tasks
+	uint64_t expected{ 0 };
+	for (uint64_t shard{ 0 }; shard < 64; ++shard)
+		for (uint64_t key{ 0 }; key < 200; ++key)
+		{
+			const auto value{ shard * 1000 + key };
+			ASSERT_TRUE(volume.SetOrInsert("/shards/" + std::to_string(shard) + "/a/b/" + std::to_string(key), value));
+			expected += value;
+		}
+
+	for (size_t attempt{ 0 }; attempt < 3; ++attempt)
+	{
+		ASSERT_EQ(volume.Aggregate("/shards", Aggregation::Count), 64 * 200);
+		ASSERT_EQ(volume.Aggregate("/shards", Aggregation::Sum), static_cast<double>(expected));
+		ASSERT_EQ(volume.Aggregate("/shards", Aggregation::Min), 0);
+		ASSERT_EQ(volume.Aggregate("/shards", Aggregation::Max), 63199);
+	}
+
+	// writers don't get in the way, values seen are either old or new ones
+	std::thread writer{ [&volume]()
+	{
+		for (uint64_t key{ 0 }; key < 200; ++key)
+			volume.SetOrInsert("/shards/0/a/b/" + std::to_string(key), uint64_t{ 1 });
+	} };
+
+	const auto count{ volume.Aggregate("/shards", Aggregation::Count) };
+	writer.join();
+
+	ASSERT_EQ(count, 64 * 200);
+}
+
+TEST(AggregateTest, Storage)
+{
+	const Volume older, newer;
+
+	ASSERT_TRUE(older.SetOrInsert("/a", uint32_t{ 1 }));
+	ASSERT_TRUE(older.SetOrInsert("/b", uint32_t{ 2 }));
+	ASSERT_TRUE(newer.SetOrInsert("/b", uint32_t{ 20 }));
+	ASSERT_TRUE(newer.SetOrInsert("/c/d", 0.25));
+
+	const Storage storage;
+
+	const auto older_token{ storage.Mount("/", older, "/") };
+	const auto newer_token{ storage.Mount("/", newer, "/") };
+	const auto nested_token{ storage.Mount("/z", older, "/") };
+	ASSERT_TRUE(older_token && newer_token && nested_token);
+
+	// /b of the older volume is shadowed by the newer one
+	ASSERT_EQ(storage.Aggregate("/", Aggregation::Count), 5);
+	ASSERT_EQ(storage.Aggregate("/", Aggregation::Sum), 1 + 20 + 0.25 + 1 + 2);
+	ASSERT_EQ(storage.Aggregate("/z", Aggregation::Max), 2);
+	ASSERT_FALSE(storage.Aggregate("/none", Aggregation::Sum));
+}
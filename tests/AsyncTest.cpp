@@ -0,0 +1,159 @@
+#include "Storage.h"
+#include "TestSet.h"
+#include "ThreadPool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+
+using namespace jb_storage;
+
+TEST(AsyncTest, SetGetDelete)
+{
+	const Volume volume;
+	const auto test_set{ GenerateTestSet("", 4, 4) };
+
+	std::vector<std::future<bool>> set_results;
+	for (const auto& entity : test_set)
+		set_results.push_back(volume.SetOrInsertAsync(entity.Path, entity.Value_));
+
+	for (auto& result : set_results)
+		ASSERT_TRUE(result.get());
+
+	std::vector<std::future<std::optional<Value>>> get_results;
+	for (const auto& entity : test_set)
+		get_results.push_back(volume.GetAsync(entity.Path));
+
+	for (size_t i{ 0 }, size{ test_set.size() }; i < size; ++i)
+	{
+		const auto val{ get_results[i].get() };
+		ASSERT_TRUE(val && *val == test_set[i].Value_);
+	}
+
+	std::vector<std::future<bool>> delete_results;
+	for (const auto& entity : test_set)
+		delete_results.push_back(volume.DeleteAsync(entity.Path));
+
+	for (auto& result : delete_results)
+		result.get();
+
+	for (const auto& entity : test_set)
+		ASSERT_FALSE(volume.Get(entity.Path));
+}
+
+TEST(AsyncTest, InvalidPath)
+{
+	const Volume volume;
+	auto result{ volume.GetAsync("foo") };
+	ASSERT_THROW(result.get(), std::invalid_argument);
+}
+
+TEST(AsyncTest, ConcurrencyLimit)
+{
+	const Volume volume;
+	volume.SetAsyncConcurrency(1);
+
+	// with a single operation in flight they run in submission order
+	for (uint32_t i{ 0 }; i < 100; ++i)
+	{
+		auto set{ volume.SetOrInsertAsync("/foo", i) };
+		auto del{ volume.DeleteAsync("/foo") };
+		auto get{ volume.GetAsync("/foo") };
+
+		ASSERT_TRUE(set.get() && del.get());
+		ASSERT_FALSE(get.get());
+	}
+
+	volume.SetAsyncConcurrency(0);
+}
+
+TEST(AsyncTest, SaveLoad)
+{
+	const Volume src;
+	const auto test_set{ GenerateTestSet("", 5, 3) };
+
+	for (const auto& entity : test_set)
+		ASSERT_TRUE(src.SetOrInsert(entity.Path, entity.Value_));
+
+	std::stringstream stream{ std::ios_base::in | std::ios_base::out | std::ios_base::binary };
+
+	auto saved{ src.SaveAsync(stream) };
+	auto other{ src.GetAsync(test_set.front().Path) };
+
+	ASSERT_TRUE(saved.get());
+	ASSERT_TRUE(other.get());
+
+	const Volume dst;
+	stream.seekg(0, std::ios::beg);
+	ASSERT_TRUE(dst.LoadAsync(stream).get());
+
+	for (const auto& entity : test_set)
+	{
+		const auto val{ dst.Get(entity.Path) };
+		ASSERT_TRUE(val && *val == entity.Value_);
+	}
+}
+
+TEST(AsyncTest, Mounted)
+{
+	const Volume volume;
+	const Storage storage;
+
+	const auto token{ storage.Mount("/vol", volume, "/") };
+	ASSERT_TRUE(token);
+
+	ASSERT_TRUE(storage.SetOrInsertAsync("/vol/foo/bar", uint32_t{ 42 }).get());
+
+	const auto bar{ storage.GetAsync("/vol/foo/bar").get() };
+	ASSERT_NO_THROW(ASSERT_TRUE(bar && std::get<uint32_t>(*bar) == 42));
+
+	ASSERT_TRUE(storage.DeleteAsync("/vol/foo").get());
+	ASSERT_FALSE(volume.Get("/foo/bar"));
+}
+
+// a waiter helps with the tasks of its group only, those of others queued in the pool are left to the workers
+TEST(AsyncTest, GroupRunsOwnTasksOnly)
+{
+	auto& pool{ utility::ThreadPool::Instance() };
+
+	std::mutex lock;
+	std::set<std::thread::id> foreign_threads;
+	std::atomic<size_t> foreign_left{ pool.GetConcurrency() * 4 };
+
+	for (size_t i{ 0 }, count{ foreign_left.load() }; i < count; ++i)
+		pool.Submit([&]()
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds{ 2 });
+			{
+				std::lock_guard guard{ lock };
+				foreign_threads.insert(std::this_thread::get_id());
+			}
+			--foreign_left;
+		});
+
+	std::atomic<size_t> done{ 0 };
+	{
+		utility::TaskGroup group;
+		for (size_t i{ 0 }; i < pool.GetConcurrency() * 2; ++i)
+			group.Submit([&done]()
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+				++done;
+			});
+
+		group.Wait();
+	}
+
+	ASSERT_EQ(done.load(), pool.GetConcurrency() * 2);
+
+	while (foreign_left.load())
+		std::this_thread::yield();
+
+	std::lock_guard guard{ lock };
+	ASSERT_EQ(foreign_threads.count(std::this_thread::get_id()), 0u);
+}
@@ -0,0 +1,147 @@
+#include "Storage.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace jb_storage;
+
+TEST(AtomicUpdateTest, Volume)
+{
+	const Volume volume;
+	ASSERT_TRUE(volume.SetOrInsert("/counters/u64", uint64_t{ 10 }));
+	ASSERT_TRUE(volume.SetOrInsert("/counters/u32", uint32_t{ 10 }));
+	ASSERT_TRUE(volume.SetOrInsert("/counters/text", std::string{ "10" }));
+
+	ASSERT_EQ(volume.FetchAdd("/counters/u64", uint64_t{ 5 }), uint64_t{ 10 });
+	ASSERT_EQ(volume.Get("/counters/u64"), Value{ uint64_t{ 15 } });
+	ASSERT_EQ(volume.FetchAdd("/counters/u32", uint32_t{ 0xffffffff }), uint32_t{ 10 });
+	ASSERT_EQ(volume.Get("/counters/u32"), Value{ uint32_t{ 9 } });
+
+	ASSERT_TRUE(volume.CompareAndSwap("/counters/u64", uint64_t{ 15 }, uint64_t{ 20 }));
+	ASSERT_FALSE(volume.CompareAndSwap("/counters/u64", uint64_t{ 15 }, uint64_t{ 30 }));
+	ASSERT_EQ(volume.Get("/counters/u64"), Value{ uint64_t{ 20 } });
+
+	// values of another type, or missing, are left alone
+	ASSERT_FALSE(volume.FetchAdd("/counters/u32", uint64_t{ 1 }));
+	ASSERT_FALSE(volume.CompareAndSwap("/counters/u32", uint64_t{ 9 }, uint64_t{ 1 }));
+	ASSERT_FALSE(volume.FetchAdd("/counters/text", uint64_t{ 1 }));
+	ASSERT_FALSE(volume.FetchAdd("/counters", uint64_t{ 1 }));
+	ASSERT_FALSE(volume.FetchAdd("/none", uint64_t{ 1 }));
+	ASSERT_EQ(volume.Get("/counters/u32"), Value{ uint32_t{ 9 } });
+
+	ASSERT_EQ(volume.Aggregate("/counters", Aggregation::Sum), 29.);
+}
+
+TEST(AtomicUpdateTest, Concurrent)
+{
+	const Volume volume;
+	ASSERT_TRUE(volume.SetOrInsert("/added", uint64_t{ 0 }));
+	ASSERT_TRUE(volume.SetOrInsert("/swapped", uint64_t{ 0 }));
+
+	constexpr size_t threads_count{ 4 }, increments{ 10000 };
+	std::vector<std::thread> threads;
+
+	for (size_t thread{ 0 }; thread < threads_count; ++thread)
+		threads.emplace_back([&volume]()
+		{
+			for (size_t i{ 0 }; i < increments; ++i)
+			{
+				ASSERT_TRUE(volume.FetchAdd("/added", uint64_t{ 1 }));
+
+				for (;;)
+				{
+					const auto current{ std::get<uint64_t>(*volume.Get("/swapped")) };
+					if (volume.CompareAndSwap("/swapped", current, current + 1))
+						break;
+				}
+			}
+		});
+
+	for (auto& thread : threads)
+		thread.join();
+
+	ASSERT_EQ(volume.Get("/added"), Value{ uint64_t{ threads_count * increments } });
+	ASSERT_EQ(volume.Get("/swapped"), Value{ uint64_t{ threads_count * increments } });
+}
+
+// a save reads the counter as it's being added to, the nodes below the root locked shared only
+TEST(AtomicUpdateTest, DuringSave)
+{
+	const Volume src;
+	ASSERT_TRUE(src.SetOrInsert("/a/b/c/d/counter", uint64_t{ 0 }));
+	ASSERT_TRUE(src.SetOrInsert("/a/b/c/d/small", uint32_t{ 0 }));
+
+	std::atomic<bool> stop{ false };
+	uint64_t added{ 0 };
+	std::thread adder{ [&]()
+	{
+		for (; !stop.load(); ++added)
+		{
+			ASSERT_TRUE(src.FetchAdd("/a/b/c/d/counter", uint64_t{ 1 }));
+			ASSERT_TRUE(src.FetchAdd("/a/b/c/d/small", uint32_t{ 1 }));
+		}
+	} };
+
+	for (size_t i{ 0 }; i < 100; ++i)
+	{
+		std::stringstream stream{ std::ios_base::in | std::ios_base::out | std::ios_base::binary };
+		ASSERT_TRUE(src.SaveAsync(stream).get());
+
+		const Volume dst;
+		ASSERT_TRUE(dst.Load(stream));
+
+		const auto counter{ dst.Get("/a/b/c/d/counter") };
+		ASSERT_TRUE(counter && std::holds_alternative<uint64_t>(*counter));
+	}
+
+	stop.store(true);
+	adder.join();
+
+	ASSERT_EQ(src.Get("/a/b/c/d/counter"), Value{ uint64_t{ added } });
+}
+
+TEST(AtomicUpdateTest, Storage)
+{
+	const Volume older, newer;
+	ASSERT_TRUE(older.SetOrInsert("/hits", uint64_t{ 1 }));
+	ASSERT_TRUE(newer.SetOrInsert("/hits", uint64_t{ 2 }));
+	ASSERT_TRUE(older.SetOrInsert("/misses", uint32_t{ 3 }));
+
+	const Storage storage;
+	const auto older_token{ storage.Mount("/stats", older, "/") };
+	const auto newer_token{ storage.Mount("/stats", newer, "/") };
+	const auto counter_token{ storage.Mount("/counter", older, "/misses") };
+	ASSERT_TRUE(older_token && newer_token && counter_token);
+
+	ASSERT_EQ(storage.FetchAdd("/stats/hits", uint64_t{ 1 }), uint64_t{ 2 });
+	ASSERT_EQ(newer.Get("/hits"), Value{ uint64_t{ 3 } });
+	ASSERT_EQ(older.Get("/hits"), Value{ uint64_t{ 1 } });
+
+	ASSERT_TRUE(storage.CompareAndSwap("/counter", uint32_t{ 3 }, uint32_t{ 4 }));
+	ASSERT_EQ(older.Get("/misses"), Value{ uint32_t{ 4 } });
+	ASSERT_FALSE(storage.FetchAdd("/none", uint32_t{ 1 }));
+}
+
+TEST(AtomicUpdateTest, Transaction)
+{
+	const Volume volume;
+	ASSERT_TRUE(volume.SetOrInsert("/counter", uint64_t{ 0 }));
+
+	// an update in place is a change to whoever read the value
+	auto transaction{ volume.BeginTransaction() };
+	ASSERT_EQ(transaction.Get("/counter"), Value{ uint64_t{ 0 } });
+	ASSERT_TRUE(transaction.SetOrInsert("/copy", uint64_t{ 0 }));
+	ASSERT_TRUE(volume.FetchAdd("/counter", uint64_t{ 1 }));
+	ASSERT_FALSE(transaction.Commit());
+
+	// a failed swap is not
+	ASSERT_EQ(transaction.Get("/counter"), Value{ uint64_t{ 1 } });
+	ASSERT_TRUE(transaction.SetOrInsert("/copy", uint64_t{ 1 }));
+	ASSERT_FALSE(volume.CompareAndSwap("/counter", uint64_t{ 0 }, uint64_t{ 5 }));
+	ASSERT_TRUE(transaction.Commit());
+	ASSERT_EQ(volume.Get("/copy"), Value{ uint64_t{ 1 } });
+}
@@ -0,0 +1,270 @@
+#include "SnapshotClock.h"
+#include "Storage.h"
+#include "TestHelpers.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <sstream>
+#include <thread>
+
+using namespace jb_storage;
+
+TEST(CloneTest, Volume)
+{
+	const Volume volume;
+	ASSERT_TRUE(volume.SetOrInsert("/a/b", uint32_t{ 1 }));
+	ASSERT_TRUE(volume.SetOrInsert("/a/c", std::string{ "c" }));
+	ASSERT_TRUE(volume.SetOrInsert("/d", uint64_t{ 2 }));
+
+	const auto clone{ volume.Clone() };
+
+	ASSERT_TRUE(volume.SetOrInsert("/a/b", uint32_t{ 10 }));
+	ASSERT_TRUE(volume.Delete("/a/c"));
+	ASSERT_TRUE(volume.FetchAdd("/d", uint64_t{ 5 }));
+
+	ASSERT_TRUE(clone.SetOrInsert("/a/e/f", uint32_t{ 11 }));
+	ASSERT_TRUE(clone.Delete("/d"));
+
+	ASSERT_EQ(clone.Get("/a/b"), Value{ uint32_t{ 1 } });
+	ASSERT_EQ(clone.Get("/a/c"), Value{ std::string{ "c" } });
+	ASSERT_FALSE(clone.Get("/d"));
+	ASSERT_EQ(clone.List("/a"), (Names{ "b", "c", "e" }));
+	ASSERT_EQ(clone.GetUsage("/a")->Nodes, 4);
+
+	ASSERT_EQ(volume.Get("/a/b"), Value{ uint32_t{ 10 } });
+	ASSERT_FALSE(volume.Get("/a/c"));
+	ASSERT_FALSE(volume.Get("/a/e"));
+	ASSERT_EQ(volume.Get("/d"), Value{ uint64_t{ 7 } });
+	ASSERT_EQ(volume.GetStats().Nodes, 3);
+
+	ExpectExactUsage(clone);
+	ExpectExactUsage(volume);
+
+	// a clone of a clone, and the volume loaded anew under it
+	const auto nested{ clone.Clone() };
+	ASSERT_TRUE(clone.Delete("/a"));
+
+	std::stringstream stream;
+	ASSERT_TRUE(Volume{ }.Save(stream));
+	ASSERT_TRUE(volume.Load(stream));
+
+	ASSERT_EQ(nested.Get("/a/e/f"), Value{ uint32_t{ 11 } });
+	ASSERT_EQ(nested.List("/"), Names{ "a" });
+	ASSERT_EQ(nested.GetStats().Nodes, 5);
+	ASSERT_TRUE(nested.Delete("/a/b"));
+
+	ASSERT_EQ(clone.List("/"), Names{ });
+	ASSERT_EQ(volume.List("/"), Names{ });
+
+	ExpectExactUsage(nested);
+	ExpectExactUsage(clone);
+}
+
+// reads go through to the origin as of the clone, whatever it turns into; nodes reached stay the same ones
+// for those who hold them, however many others are reached and dropped meanwhile
+TEST(CloneTest, ReadThrough)
+{
+	const Volume volume;
+	ASSERT_TRUE(volume.SetOrInsert("/a/b", uint32_t{ 1 }));
+	ASSERT_TRUE(volume.SetOrInsert("/a/c", std::string{ "c" }));
+
+	constexpr uint64_t wide{ 100 };
+	for (uint64_t i{ 0 }; i < wide; ++i)
+		ASSERT_TRUE(volume.SetOrInsert("/wide/" + std::to_string(i) + "/value", i));
+
+	const auto clone{ volume.Clone() };
+
+	ASSERT_TRUE(volume.SetOrInsert("/a/b", uint32_t{ 10 }));
+	ASSERT_TRUE(volume.Delete("/a/c"));
+	ASSERT_TRUE(volume.FetchAdd("/wide/0/value", uint64_t{ 1000 }));
+	ASSERT_TRUE(volume.SetOrInsert("/wide/new/value", uint64_t{ 1000 }));
+
+	ASSERT_EQ(clone.Get("/a/b"), Value{ uint32_t{ 1 } });
+	ASSERT_EQ(clone.Get("/a/c"), Value{ std::string{ "c" } });
+	ASSERT_EQ(clone.List("/a"), (Names{ "b", "c" }));
+	ASSERT_EQ(clone.List("/wide", 2, "98"), (Names{ "99" }));
+
+	uint64_t scanned{ 0 };
+	clone.Scan("/wide", [&scanned](const std::string_view, const Value& value) { if (const auto number{ std::get_if<uint64_t>(&value) }) scanned += *number; return true; });
+	ASSERT_EQ(scanned, wide * (wide - 1) / 2);
+	ASSERT_EQ(clone.Glob("/wide/*/value", [](const std::string_view, const Value&) { return true; }), wide);
+	ASSERT_EQ(*clone.Aggregate("/wide", Aggregation::Sum), wide * (wide - 1) / 2);
+
+	const auto held{ clone.Open("/wide/3") };
+	ASSERT_TRUE(held);
+
+	auto transaction{ clone.BeginTransaction() };
+	ASSERT_EQ(transaction.Get("/a/b"), Value{ uint32_t{ 1 } });
+	ASSERT_TRUE(transaction.SetOrInsert("/a/d", uint32_t{ 4 }));
+
+	for (size_t round{ 0 }; round < 4; ++round)
+		for (uint64_t i{ 0 }; i < wide; ++i)
+			ASSERT_EQ(clone.Get("/wide/" + std::to_string(i) + "/value"), Value{ i });
+
+	ASSERT_TRUE(transaction.Commit());
+	ASSERT_TRUE(held.SetOrInsert("/value", uint64_t{ 33 }));
+	ASSERT_TRUE(clone.FetchAdd("/wide/5/value", uint64_t{ 50 }));
+
+	ASSERT_EQ(clone.Get("/wide/3/value"), Value{ uint64_t{ 33 } });
+	ASSERT_EQ(clone.Get("/wide/5/value"), Value{ uint64_t{ 55 } });
+	ASSERT_EQ(clone.Get("/wide/0/value"), Value{ uint64_t{ 0 } });
+	ASSERT_FALSE(clone.Get("/wide/new"));
+	ASSERT_EQ(clone.List("/a"), (Names{ "b", "c", "d" }));
+	ASSERT_EQ(*clone.Aggregate("/wide", Aggregation::Sum), wide * (wide - 1) / 2 + 30 + 50);
+
+	ASSERT_EQ(volume.Get("/wide/3/value"), Value{ uint64_t{ 3 } });
+	ASSERT_EQ(volume.Get("/a/d"), std::nullopt);
+
+	// a clone of the clone reads through both
+	const auto nested{ clone.Clone() };
+	ASSERT_TRUE(clone.Delete("/wide"));
+	ASSERT_EQ(nested.Get("/wide/3/value"), Value{ uint64_t{ 33 } });
+	ASSERT_EQ(nested.Get("/wide/7/value"), Value{ uint64_t{ 7 } });
+	ASSERT_EQ(nested.List("/wide").value_or(Names{ }).size(), wide);
+
+	ExpectExactUsage(clone);
+	ExpectExactUsage(nested);
+}
+
+TEST(CloneTest, Consistent)
+{
+	const Volume volume;
+
+	constexpr uint64_t accounts{ 16 }, initial{ 100 };
+	for (uint64_t account{ 0 }; account < accounts; ++account)
+		ASSERT_TRUE(volume.SetOrInsert("/accounts/" + std::to_string(account), initial));
+
+	std::atomic<bool> stop{ false };
+	std::atomic<uint64_t> committed{ 0 };
+	std::thread writer{ [&]()
+	{
+		auto transaction{ volume.BeginTransaction() };
+		for (uint64_t i{ 0 }; !stop.load(); ++i)
+		{
+			const auto from{ "/accounts/" + std::to_string(i % accounts) };
+			const auto to{ "/accounts/" + std::to_string(i * 7 % accounts) };
+			if (from == to)
+				continue;
+
+			// an account moved to a longer name now and then keeps the totals on the move
+			const auto source{ std::get<uint64_t>(*transaction.Get(from)) };
+			const auto target{ std::get<uint64_t>(*transaction.Get(to)) };
+			transaction.SetOrInsert(from, source - 1);
+			transaction.SetOrInsert(to, target + 1);
+			if (i % 5 == 0)
+				transaction.SetOrInsert("/scratch/" + std::to_string(i % 3), Blob(i % 7));
+			else if (i % 5 == 1)
+				transaction.Delete("/scratch");
+
+			committed += transaction.Commit();
+		}
+	} };
+
+	while (committed.load() < 100)
+		std::this_thread::yield();
+
+	for (size_t round{ 0 }; round < 100; ++round)
+	{
+		const auto clone{ volume.Clone() };
+
+		uint64_t scanned{ 0 };
+		clone.Scan("/accounts", [&scanned](const std::string_view, const Value& value) { scanned += std::get<uint64_t>(value); return true; });
+		EXPECT_EQ(scanned, accounts * initial);
+
+		// the clone moves on on its own while the volume does
+		ASSERT_TRUE(clone.FetchAdd("/accounts/0", uint64_t{ 1 }));
+		ASSERT_TRUE(clone.SetOrInsert("/scratch/clone", uint32_t{ 1 }));
+		EXPECT_EQ(*clone.Aggregate("/accounts", Aggregation::Sum), accounts * initial + 1);
+
+		ExpectExactUsage(clone);
+	}
+
+	stop = true;
+	writer.join();
+}
+
+// counters added to in place on the volume read the same on a clone all along, once read there
+TEST(CloneTest, CountersInPlace)
+{
+	const Volume volume;
+	ASSERT_TRUE(volume.SetOrInsert("/a/b/counter", uint64_t{ 0 }));
+	ASSERT_TRUE(volume.SetOrInsert("/a/b/small", uint32_t{ 0 }));
+
+	std::atomic<bool> stop{ false };
+	std::thread adder{ [&]()
+	{
+		while (!stop.load())
+		{
+			ASSERT_TRUE(volume.FetchAdd("/a/b/counter", uint64_t{ 1 }));
+			ASSERT_TRUE(volume.FetchAdd("/a/b/small", uint32_t{ 1 }));
+		}
+	} };
+
+	for (size_t round{ 0 }; round < 100; ++round)
+	{
+		const auto clone{ volume.Clone() };
+		const auto counter{ clone.Get("/a/b/counter") };
+		const auto small{ clone.Get("/a/b/small") };
+		ASSERT_TRUE(counter && small);
+
+		for (size_t i{ 0 }; i < 10; ++i)
+		{
+			ASSERT_EQ(clone.Get("/a/b/counter"), counter);
+			ASSERT_EQ(clone.Get("/a/b/small"), small);
+		}
+
+		uint64_t summed{ 0 };
+		clone.Scan("/a/b", [&summed](const std::string_view, const Value& value) { summed += std::holds_alternative<uint64_t>(value) ? std::get<uint64_t>(value) : std::get<uint32_t>(value); return true; });
+		ASSERT_EQ(summed, std::get<uint64_t>(*counter) + std::get<uint32_t>(*small));
+	}
+
+	stop.store(true);
+	adder.join();
+}
+
+// snapshots of clones are seen by the nodes of their origin only, and those handed over to another volume
+TEST(CloneTest, Scope)
+{
+	auto& clock{ utility::SnapshotClock::Instance() };
+	const auto origin{ std::make_shared<utility::SnapshotClock::Scope>() };
+	const auto other{ std::make_shared<utility::SnapshotClock::Scope>() };
+
+	{
+		const uint64_t stamp{ clock.GetTime() };
+		const utility::SnapshotClock::Lease lease{ origin };
+		ASSERT_TRUE(clock.IsScoped());
+		ASSERT_TRUE(clock.IsSeen(stamp, origin.get()));
+		ASSERT_FALSE(clock.IsSeen(stamp));
+		ASSERT_FALSE(clock.IsSeen(stamp, other.get()));
+
+		clock.Share(*origin, other);
+		ASSERT_TRUE(clock.IsSeen(stamp, other.get()));
+	}
+
+	ASSERT_FALSE(clock.IsScoped());
+	ASSERT_FALSE(origin->IsSeen(0));
+	ASSERT_FALSE(other->IsSeen(0));
+
+	const Volume volume, target;
+	ASSERT_TRUE(volume.SetOrInsert("/batch/a", uint32_t{ 1 }));
+	ASSERT_TRUE(volume.SetOrInsert("/batch/b", uint32_t{ 2 }));
+	ASSERT_TRUE(target.SetOrInsert("/c", uint32_t{ 3 }));
+
+	{
+		const auto clone{ volume.Clone() };
+		ASSERT_TRUE(volume.Move("/batch", target, "/batch"));
+		ASSERT_TRUE(target.SetOrInsert("/batch/a", uint32_t{ 10 }));
+		ASSERT_TRUE(target.Delete("/batch/b"));
+		ASSERT_TRUE(target.SetOrInsert("/c", uint32_t{ 30 }));
+
+		ASSERT_EQ(clone.Get("/batch/a"), Value{ uint32_t{ 1 } });
+		ASSERT_EQ(clone.List("/batch"), (Names{ "a", "b" }));
+		ASSERT_EQ(clone.GetUsage("/batch")->Nodes, 2);
+		ExpectExactUsage(clone);
+	}
+
+	ASSERT_FALSE(clock.IsScoped());
+	ASSERT_EQ(target.Get("/batch/a"), Value{ uint32_t{ 10 } });
+	ExpectExactUsage(target);
+}
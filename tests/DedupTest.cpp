@@ -0,0 +1,114 @@
+#include "Storage.h"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <thread>
+
+using namespace jb_storage;
+
+namespace
+{
+
+	size_t GetSavedSize(const Volume& volume)
+	{
+		std::stringstream stream;
+		EXPECT_TRUE(volume.Save(stream));
+
+		return stream.str().size();
+	}
+
+}
+
+TEST(DedupTest, Volume)
+{
+	const Blob payload(4096, 7);
+	const std::string config(1024, 'c');
+
+	const Volume volume;
+	volume.SetDedupThreshold(256);
+
+	for (size_t i{ 0 }; i < 100; ++i)
+	{
+		const auto path{ "/items/" + std::to_string(i) };
+		ASSERT_TRUE(volume.SetOrInsert(path + "/payload", payload));
+		ASSERT_TRUE(volume.SetOrInsert(path + "/config", config));
+		ASSERT_TRUE(volume.SetOrInsert(path + "/name", std::string(300, 'a' + i % 26)));
+		ASSERT_TRUE(volume.SetOrInsert(path + "/small", std::string{ "small" }));
+	}
+
+	ASSERT_EQ(volume.Get("/items/42/payload"), Value{ payload });
+	ASSERT_EQ(volume.Get("/items/42/config"), Value{ config });
+	ASSERT_EQ(volume.Get("/items/42/name"), Value{ std::string(300, 'a' + 42 % 26) });
+	ASSERT_EQ(volume.GetUsage("/items")->ValueBytes, 100 * (4096 + 1024 + 300 + 5));
+	ASSERT_EQ(*volume.Aggregate("/items", Aggregation::Count), 0);
+
+	// a string and a blob of the same bytes are different values
+	ASSERT_TRUE(volume.SetOrInsert("/string", std::string(4096, 7)));
+	ASSERT_EQ(volume.Get("/string"), Value{ std::string(4096, 7) });
+
+	// changing one holder leaves the others as they are
+	const auto snapshot{ volume.Snapshot() };
+	ASSERT_TRUE(volume.SetOrInsert("/items/0/payload", uint32_t{ 1 }));
+	ASSERT_TRUE(volume.Delete("/items/1"));
+	ASSERT_FALSE(volume.FetchAdd("/items/2/payload", uint32_t{ 1 }));
+	ASSERT_EQ(volume.Get("/items/2/payload"), Value{ payload });
+	ASSERT_EQ(snapshot.Get("/items/0/payload"), Value{ payload });
+	ASSERT_EQ(volume.Clone().Get("/items/3/config"), Value{ config });
+
+	// every distinct payload saved once: 26 names, the payload and the config, the string; the rest is
+	// names, small values and references
+	const auto saved{ GetSavedSize(volume) };
+	ASSERT_LT(saved, 26 * 300 + 4096 + 1024 + 4096 + 100 * 160);
+
+	std::stringstream stream;
+	ASSERT_TRUE(volume.Save(stream));
+
+	const Volume loaded;
+	ASSERT_TRUE(loaded.Load(stream));
+	ASSERT_EQ(loaded.Get("/items/98/payload"), Value{ payload });
+	ASSERT_EQ(loaded.Get("/items/0/payload"), Value{ uint32_t{ 1 } });
+	ASSERT_EQ(loaded.GetUsage("/")->ValueBytes, volume.GetUsage("/")->ValueBytes);
+	ASSERT_EQ(GetSavedSize(loaded), saved);
+
+	// once the threshold is off, values are kept apart again
+	volume.SetDedupThreshold(0);
+	ASSERT_TRUE(volume.SetOrInsert("/items/2/payload", payload));
+	ASSERT_TRUE(volume.SetOrInsert("/items/3/payload", payload));
+	ASSERT_EQ(GetSavedSize(volume), saved + 2 * 4096);
+}
+
+TEST(DedupTest, Concurrent)
+{
+	const Volume volume;
+	volume.SetDedupThreshold(64);
+
+	std::vector<std::thread> threads;
+	for (size_t thread{ 0 }; thread < 4; ++thread)
+		threads.emplace_back([&volume, thread]()
+		{
+			// payloads come and go as their holders are overwritten by each other
+			for (size_t i{ 0 }; i < 2000; ++i)
+			{
+				const auto path{ "/" + std::to_string(i % 16) };
+				volume.SetOrInsert(path, Blob(128, static_cast<uint8_t>((i + thread) % 5)));
+				if (i % 7 == 0)
+					volume.Delete(path);
+			}
+		});
+
+	for (auto& thread : threads)
+		thread.join();
+
+	volume.Scan("/", [](const std::string_view, const Value& value)
+	{
+		const auto& blob{ std::get<Blob>(value) };
+		EXPECT_EQ(blob.size(), 128);
+		EXPECT_LT(blob.front(), 5);
+		return true;
+	});
+
+	std::stringstream stream;
+	ASSERT_TRUE(volume.Save(stream));
+	ASSERT_LT(stream.str().size(), 5 * 128 + 16 * 32);
+}
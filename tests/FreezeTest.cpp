@@ -0,0 +1,161 @@
+#include "Storage.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <sstream>
+
+using namespace jb_storage;
+
+namespace
+{
+
+	using Names = std::vector<std::string>;
+
+	std::map<std::string, Value> ScanAll(const Volume& volume, const std::string_view path)
+	{
+		std::map<std::string, Value> visited;
+		volume.Scan(path, [&visited](const std::string_view path, const Value& value) { return visited.emplace(path, value).second; });
+
+		return visited;
+	}
+
+}
+
+TEST(FreezeTest, Volume)
+{
+	const Volume volume;
+	ASSERT_TRUE(volume.SetOrInsert("/", uint32_t{ 7 }));
+	for (uint32_t shard{ 0 }; shard < 50; ++shard)
+	{
+		const auto prefix{ "/shards/" + std::to_string(shard) };
+		ASSERT_TRUE(volume.SetOrInsert(prefix + "/qps", shard));
+		ASSERT_TRUE(volume.SetOrInsert(prefix + "/name", "shard " + std::to_string(shard)));
+		ASSERT_TRUE(volume.SetOrInsert(prefix + "/config/weight", double{ shard / 2. }));
+	}
+
+	const auto frozen{ volume.Freeze() };
+	ASSERT_TRUE(volume.Delete("/shards/0"));
+	ASSERT_TRUE(volume.SetOrInsert("/shards/1/qps", uint32_t{ 100 }));
+
+	ASSERT_EQ(frozen.Get("/"), Value{ uint32_t{ 7 } });
+	ASSERT_EQ(frozen.Get("/shards/1/qps"), Value{ uint32_t{ 1 } });
+	ASSERT_EQ(frozen.Get("/shards/2/name"), Value{ std::string{ "shard 2" } });
+	ASSERT_EQ(frozen.Get("/shards/3"), Value{ });
+	ASSERT_FALSE(frozen.Get("/shards/50"));
+	ASSERT_FALSE(frozen.Get("/shards/1/qps/none"));
+
+	ASSERT_EQ(frozen.List("/shards/0"), (Names{ "config", "name", "qps" }));
+	ASSERT_EQ(frozen.List("/shards", 3, "1"), (Names{ "10", "11", "12" }));
+	ASSERT_EQ(frozen.List("/shards", 0, "8")->size(), 1);
+	ASSERT_FALSE(frozen.List("/none"));
+
+	// the same as the volume gives once the changes made since are undone
+	ASSERT_TRUE(volume.SetOrInsert("/shards/0/qps", uint32_t{ 0 }));
+	ASSERT_TRUE(volume.SetOrInsert("/shards/0/name", std::string{ "shard 0" }));
+	ASSERT_TRUE(volume.SetOrInsert("/shards/0/config/weight", double{ 0 }));
+	ASSERT_TRUE(volume.SetOrInsert("/shards/1/qps", uint32_t{ 1 }));
+
+	ASSERT_EQ(ScanAll(frozen, "/"), ScanAll(volume, "/"));
+	ASSERT_EQ(ScanAll(frozen, "/shards/4"), ScanAll(volume, "/shards/4"));
+
+	std::string resume;
+	size_t visited{ 0 };
+	do
+	{
+		size_t left{ 7 };
+		resume = frozen.Scan("/shards", [&](const std::string_view, const Value&) { ++visited; return --left != 0; }, resume);
+	}
+	while (!resume.empty());
+	ASSERT_EQ(visited, 50 * 5);
+
+	ASSERT_EQ(frozen.Glob("/shards/*/qps", [](const std::string_view, const Value&) { return true; }), 50);
+	ASSERT_EQ(frozen.Glob("/**/weight", [](const std::string_view, const Value&) { return true; }), 50);
+	ASSERT_EQ(frozen.Glob("/**", [](const std::string_view, const Value&) { return false; }), 1);
+
+	ASSERT_EQ(frozen.Aggregate("/", Aggregation::Count), volume.Aggregate("/", Aggregation::Count));
+	ASSERT_EQ(frozen.Aggregate("/shards", Aggregation::Sum), 49 * 50 / 2 * 1.5);
+	ASSERT_EQ(frozen.Aggregate("/shards/9", Aggregation::Max), 9);
+
+	const auto usage{ frozen.GetUsage("/shards/2") };
+	const auto expected{ volume.GetUsage("/shards/2") };
+	ASSERT_TRUE(usage && expected);
+	ASSERT_EQ(usage->Nodes, expected->Nodes);
+	ASSERT_EQ(usage->KeyBytes, expected->KeyBytes);
+	ASSERT_EQ(usage->ValueBytes, expected->ValueBytes);
+	ASSERT_EQ(frozen.GetStats().Nodes, volume.GetStats().Nodes);
+
+	ASSERT_FALSE(frozen.SetOrInsert("/shards/1/qps", uint32_t{ 2 }));
+	ASSERT_FALSE(frozen.SetOrInsert("/new", uint32_t{ 2 }));
+	ASSERT_FALSE(frozen.Delete("/shards/1"));
+	ASSERT_FALSE(frozen.FetchAdd("/shards/1/qps", uint32_t{ 1 }));
+	ASSERT_FALSE(frozen.CompareAndSwap("/shards/1/qps", uint32_t{ 1 }, uint32_t{ 2 }));
+	ASSERT_EQ(frozen.Get("/shards/1/qps"), Value{ uint32_t{ 1 } });
+
+	const auto handle{ frozen.Open("/shards/5") };
+	ASSERT_TRUE(handle);
+	ASSERT_EQ(handle.Get("/qps"), Value{ uint32_t{ 5 } });
+	ASSERT_FALSE(handle.SetOrInsert("/qps", uint32_t{ 6 }));
+
+	auto transaction{ frozen.BeginTransaction() };
+	ASSERT_EQ(transaction.Get("/shards/5/qps"), Value{ uint32_t{ 5 } });
+	ASSERT_FALSE(transaction.Commit());
+
+	ASSERT_EQ(frozen.Snapshot().Get("/shards/5/qps"), Value{ uint32_t{ 5 } });
+	ASSERT_EQ(frozen.Clone().Get("/shards/5/qps"), Value{ uint32_t{ 5 } });
+	ASSERT_EQ(frozen.Freeze().List("/shards/5"), (Names{ "config", "name", "qps" }));
+}
+
+TEST(FreezeTest, SaveLoad)
+{
+	const Volume volume;
+	ASSERT_TRUE(volume.SetOrInsert("/a/b/c", uint64_t{ 1 }));
+	ASSERT_TRUE(volume.SetOrInsert("/a/d", Blob{ 1, 2, 3 }));
+	ASSERT_TRUE(volume.SetOrInsert("/e", float{ 0.5 }));
+
+	const auto frozen{ volume.Freeze() };
+
+	std::stringstream stream;
+	ASSERT_TRUE(frozen.Save(stream));
+	ASSERT_FALSE(frozen.Load(stream));
+
+	const Volume loaded;
+	ASSERT_TRUE(loaded.Load(stream));
+	ASSERT_EQ(ScanAll(loaded, "/"), ScanAll(volume, "/"));
+
+	// an empty volume, and one that's frozen again once loaded
+	ASSERT_EQ(ScanAll(Volume{ }.Freeze(), "/"), (std::map<std::string, Value>{ }));
+	ASSERT_EQ(ScanAll(loaded.Freeze(), "/a"), ScanAll(volume, "/a"));
+}
+
+TEST(FreezeTest, Storage)
+{
+	const Volume volume;
+	ASSERT_TRUE(volume.SetOrInsert("/config/a", uint32_t{ 1 }));
+	ASSERT_TRUE(volume.SetOrInsert("/config/b", uint32_t{ 2 }));
+
+	const Volume overlay;
+	ASSERT_TRUE(overlay.SetOrInsert("/b", uint32_t{ 20 }));
+
+	const auto frozen{ volume.Freeze() };
+
+	const Storage storage;
+	const auto frozen_token{ storage.Mount("/live", frozen, "/config") };
+	const auto overlay_token{ storage.Mount("/live", overlay, "/") };
+	ASSERT_TRUE(frozen_token && overlay_token);
+
+	ASSERT_EQ(storage.Get("/live/a"), Value{ uint32_t{ 1 } });
+	ASSERT_EQ(storage.Get("/live/b"), Value{ uint32_t{ 20 } });
+	ASSERT_EQ(storage.List("/live"), (Names{ "a", "b" }));
+	ASSERT_EQ(storage.Aggregate("/live", Aggregation::Sum), 21);
+
+	ASSERT_FALSE(storage.Delete("/live/a"));
+	ASSERT_TRUE(storage.SetOrInsert("/live/c", uint32_t{ 3 }));
+	ASSERT_EQ(overlay.Get("/c"), Value{ uint32_t{ 3 } });
+
+	ASSERT_EQ(storage.Snapshot().Get("/live/a"), Value{ uint32_t{ 1 } });
+
+	// saved while mounted, since nothing may change it
+	std::stringstream stream;
+	ASSERT_TRUE(frozen.Save(stream));
+}
@@ -0,0 +1,104 @@
+#include "GlobPattern.h"
+#include "Storage.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <set>
+
+using namespace jb_storage;
+
+namespace
+{
+
+	using Paths = std::set<std::string>;
+
+	template < typename Storage >
+	Paths Glob(const Storage& storage, const std::string_view pattern)
+	{
+		Paths matches;
+		const auto count{ storage.Glob(pattern, [&matches](const std::string_view path, const Value&)
+		{
+			matches.emplace(path);
+			return true;
+		}) };
+
+		EXPECT_EQ(count, matches.size());
+
+		return matches;
+	}
+
+}
+
+TEST(GlobTest, MatchSegment)
+{
+	using utility::GlobPattern;
+
+	ASSERT_TRUE(GlobPattern::MatchSegment("*", "anything"));
+	ASSERT_TRUE(GlobPattern::MatchSegment("foo", "foo"));
+	ASSERT_FALSE(GlobPattern::MatchSegment("foo", "food"));
+	ASSERT_TRUE(GlobPattern::MatchSegment("foo*", "food"));
+	ASSERT_TRUE(GlobPattern::MatchSegment("*od", "food"));
+	ASSERT_TRUE(GlobPattern::MatchSegment("f*o*d", "food"));
+	ASSERT_FALSE(GlobPattern::MatchSegment("f*x*d", "food"));
+	ASSERT_TRUE(GlobPattern::MatchSegment("a*a*a", "aaaaa"));
+	ASSERT_FALSE(GlobPattern::MatchSegment("a*a*a", "aa"));
+}
+
+TEST(GlobTest, Volume)
+{
+	const Volume volume;
+
+	for (size_t shard{ 0 }; shard < 100; ++shard)
+	{
+		const auto prefix{ "/shards/" + std::to_string(shard) };
+		ASSERT_TRUE(volume.SetOrInsert(prefix + "/stats/qps", uint64_t{ shard }));
+		ASSERT_TRUE(volume.SetOrInsert(prefix + "/stats/latency", uint64_t{ shard }));
+		ASSERT_TRUE(volume.SetOrInsert(prefix + "/config/qps", uint64_t{ shard }));
+	}
+
+	const auto qps{ Glob(volume, "/shards/*/stats/qps") };
+	ASSERT_EQ(qps.size(), 100);
+	ASSERT_EQ(qps.count("/shards/42/stats/qps"), 1);
+
+	ASSERT_EQ(Glob(volume, "/**/qps").size(), 200);
+	ASSERT_EQ(Glob(volume, "/shards/**/stats/*").size(), 200);
+	ASSERT_EQ(Glob(volume, "/shards/4*/stats/qps").size(), 11);
+	ASSERT_EQ(Glob(volume, "/shards/42/**"), (Paths{ "/shards/42", "/shards/42/stats", "/shards/42/stats/qps", "/shards/42/stats/latency", "/shards/42/config", "/shards/42/config/qps" }));
+	ASSERT_EQ(Glob(volume, "/*"), Paths{ "/shards" });
+	ASSERT_TRUE(Glob(volume, "/none/**").empty());
+	ASSERT_TRUE(Glob(volume, "/shards/*/none").empty());
+
+	uint64_t sum{ 0 };
+	volume.Glob("/shards/*/stats/qps", [&sum](const std::string_view, const Value& value)
+	{
+		sum += std::get<uint64_t>(value);
+		return true;
+	});
+	ASSERT_EQ(sum, 99 * 100 / 2);
+
+	size_t reported{ 0 };
+	ASSERT_EQ(volume.Glob("/**", [&reported](const std::string_view, const Value&) { return ++reported < 10; }), 10);
+	ASSERT_EQ(reported, 10);
+
+	ASSERT_THROW(volume.Glob("/**", [](const std::string_view, const Value&) -> bool { throw std::runtime_error{ "stop" }; }), std::runtime_error);
+}
+
+TEST(GlobTest, Storage)
+{
+	const Volume first, second;
+
+	ASSERT_TRUE(first.SetOrInsert("/stats/qps", uint32_t{ 1 }));
+	ASSERT_TRUE(second.SetOrInsert("/stats/qps", uint32_t{ 2 }));
+	ASSERT_TRUE(second.SetOrInsert("/stats/rps", uint32_t{ 2 }));
+
+	const Storage storage;
+	const auto first_token{ storage.Mount("/shards/a", first, "/") };
+	const auto second_token{ storage.Mount("/shards/b", second, "/") };
+	const auto shadow_token{ storage.Mount("/shards/a", second, "/stats") };
+	ASSERT_TRUE(first_token && second_token && shadow_token);
+
+	ASSERT_EQ(Glob(storage, "/shards/*/stats/qps"), (Paths{ "/shards/a/stats/qps", "/shards/b/stats/qps" }));
+	ASSERT_EQ(Glob(storage, "/shards/a/*"), (Paths{ "/shards/a/qps", "/shards/a/rps", "/shards/a/stats" }));
+	ASSERT_EQ(Glob(storage, "/**/rps"), (Paths{ "/shards/a/rps", "/shards/b/stats/rps" }));
+}
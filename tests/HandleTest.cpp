@@ -0,0 +1,146 @@
+#include "Storage.h"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <thread>
+
+using namespace jb_storage;
+
+TEST(HandleTest, RelativeAccess)
+{
+	const Volume volume;
+
+	ASSERT_TRUE(volume.SetOrInsert("/tenants/42/config/foo", uint32_t{ 42 }));
+
+	const auto config{ volume.Open("/tenants/42/config") };
+	ASSERT_TRUE(config);
+
+	const auto foo{ config.Get("/foo") };
+	ASSERT_NO_THROW(ASSERT_TRUE(foo && std::get<uint32_t>(*foo) == 42));
+
+	ASSERT_TRUE(config.SetOrInsert("/bar/baz", "42"));
+	const auto baz{ volume.Get("/tenants/42/config/bar/baz") };
+	ASSERT_NO_THROW(ASSERT_TRUE(baz && std::get<std::string>(*baz) == "42"));
+
+	ASSERT_TRUE(config.Delete("/foo"));
+	ASSERT_FALSE(volume.Get("/tenants/42/config/foo"));
+
+	ASSERT_FALSE(config.Delete("/"));
+}
+
+TEST(HandleTest, OpenAbsentPath)
+{
+	const Volume volume;
+	const Storage storage;
+
+	ASSERT_FALSE(volume.Open("/foo"));
+	ASSERT_FALSE(storage.Open("/foo"));
+	ASSERT_FALSE(volume.Open("/foo").Get("/"));
+}
+
+TEST(HandleTest, DeletedAnchor)
+{
+	const Volume volume;
+
+	ASSERT_TRUE(volume.SetOrInsert("/foo/bar/baz", uint32_t{ 42 }));
+
+	const auto bar{ volume.Open("/foo/bar") };
+	const auto baz{ volume.Open("/foo/bar/baz") };
+	ASSERT_TRUE(bar && baz);
+
+	ASSERT_TRUE(volume.Delete("/foo"));
+
+	ASSERT_FALSE(bar || baz);
+	ASSERT_FALSE(baz.Get("/"));
+	ASSERT_FALSE(bar.SetOrInsert("/qux", uint32_t{ 42 }));
+
+	ASSERT_TRUE(volume.SetOrInsert("/foo/bar/baz", uint32_t{ 42 }));
+	ASSERT_FALSE(baz.Get("/"));
+}
+
+TEST(HandleTest, LoadedVolume)
+{
+	const Volume volume;
+
+	ASSERT_TRUE(volume.SetOrInsert("/foo/bar", uint32_t{ 42 }));
+
+	std::stringstream stream{ std::ios_base::in | std::ios_base::out | std::ios_base::binary };
+	ASSERT_TRUE(volume.Save(stream));
+
+	const auto root{ volume.Open("/") };
+	const auto foo{ volume.Open("/foo") };
+
+	stream.seekg(0, std::ios::beg);
+	ASSERT_TRUE(volume.Load(stream));
+
+	ASSERT_TRUE(root && root.Get("/foo/bar"));
+	ASSERT_FALSE(foo);
+}
+
+TEST(HandleTest, Mounted)
+{
+	const Volume volume;
+	const Storage storage;
+
+	ASSERT_TRUE(volume.SetOrInsert("/foo/bar", uint32_t{ 42 }));
+
+	Handle vol{ storage.Open("/") };
+	Handle bar{ storage.Open("/") };
+
+	{
+		const auto token{ storage.Mount("/vol", volume, "/") };
+		ASSERT_TRUE(token);
+
+		vol = storage.Open("/vol");
+		bar = storage.Open("/vol/foo/bar");
+		ASSERT_TRUE(vol && bar);
+
+		const auto value{ vol.Get("/foo/bar") };
+		ASSERT_NO_THROW(ASSERT_TRUE(value && std::get<uint32_t>(*value) == 42));
+
+		ASSERT_TRUE(bar.SetOrInsert("/", "42"));
+	}
+
+	const auto value{ volume.Get("/foo/bar") };
+	ASSERT_NO_THROW(ASSERT_TRUE(value && std::get<std::string>(*value) == "42"));
+
+	ASSERT_FALSE(bar);
+	ASSERT_FALSE(bar.Get("/"));
+
+	// virtual node stays in place, though there's nothing mounted to it anymore
+	ASSERT_TRUE(vol);
+	ASSERT_FALSE(vol.Get("/foo/bar"));
+}
+
+TEST(HandleTest, SaveWhileWriting)
+{
+	const Volume volume;
+
+	ASSERT_TRUE(volume.SetOrInsert("/foo/bar/0", uint64_t{ 0 }));
+
+	const auto bar{ volume.Open("/foo/bar") };
+	ASSERT_TRUE(bar);
+
+	// writes through a handle don't pass the root, a save running meanwhile sees each node either way
+	std::thread writer{ [&bar]()
+	{
+		for (uint64_t i{ 1 }; i < 2000; ++i)
+		{
+			bar.SetOrInsert("/" + std::to_string(i % 50) + "/baz", uint64_t{ i });
+			bar.Delete("/" + std::to_string((i + 25) % 50));
+		}
+	} };
+
+	for (size_t i{ 0 }; i < 50; ++i)
+	{
+		std::stringstream stream{ std::ios_base::in | std::ios_base::out | std::ios_base::binary };
+		ASSERT_TRUE(volume.Save(stream));
+
+		const Volume loaded;
+		stream.seekg(0, std::ios::beg);
+		ASSERT_TRUE(loaded.Load(stream));
+	}
+
+	writer.join();
+}
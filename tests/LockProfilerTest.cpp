@@ -0,0 +1,105 @@
+#include "LockProfiler.h"
+#include "Storage.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <thread>
+
+using namespace jb_storage;
+
+TEST(LockProfilerTest, Profile)
+{
+	if (!LockProfiler::IsAvailable())
+	{
+		const auto profile{ LockProfiler::GetProfile() };
+		ASSERT_FALSE(profile.Available);
+		ASSERT_TRUE(profile.ByDepth.empty() && profile.HottestPaths.empty());
+		return;
+	}
+
+	const Volume volume;
+	ASSERT_TRUE(volume.SetOrInsert("/foo/bar", uint32_t{ 1 }));
+
+	LockProfiler::Reset();
+	LockProfiler::Enable();
+
+	for (size_t i{ 0 }; i < 100; ++i)
+		ASSERT_TRUE(volume.Get("/foo/bar"));
+
+	LockProfiler::Enable(false);
+
+	ASSERT_TRUE(volume.Get("/foo/bar"));
+
+	const auto profile{ LockProfiler::GetProfile(2) };
+	ASSERT_TRUE(profile.Available);
+	ASSERT_FALSE(profile.Enabled);
+
+	// root and /foo are locked to walk the path, /foo/bar to read the value
+	ASSERT_EQ(profile.ByDepth.size(), 3);
+	for (const auto& depth : profile.ByDepth)
+		ASSERT_EQ(depth.Acquisitions, 100);
+
+	ASSERT_EQ(profile.HottestPaths.size(), 2);
+	for (const auto& [path, stats] : profile.HottestPaths)
+	{
+		ASSERT_TRUE(path == "/" || path == "/foo" || path == "/foo/bar");
+		ASSERT_EQ(stats.Acquisitions, 100);
+		ASSERT_GE(stats.WaitNanoseconds, stats.MaxWaitNanoseconds);
+	}
+
+	LockProfiler::Reset();
+	ASSERT_TRUE(LockProfiler::GetProfile().ByDepth.empty());
+}
+
+TEST(LockProfilerTest, Deep)
+{
+	if (!LockProfiler::IsAvailable())
+		return;
+
+	std::string path;
+	for (size_t i{ 0 }; i < 100; ++i)
+		path += "/a";
+
+	const Volume volume;
+	ASSERT_TRUE(volume.SetOrInsert(path, uint32_t{ 1 }));
+
+	LockProfiler::Reset();
+	LockProfiler::Enable();
+	ASSERT_TRUE(volume.Get(path));
+	LockProfiler::Enable(false);
+
+	const auto profile{ LockProfiler::GetProfile(1000) };
+	ASSERT_EQ(profile.ByDepth.size(), 64);
+	ASSERT_EQ(profile.ByDepth.back().Acquisitions, 101 - 63);
+	ASSERT_EQ(profile.HottestPaths.size(), 101);
+	ASSERT_TRUE(std::any_of(profile.HottestPaths.begin(), profile.HottestPaths.end(), [](const auto& entry) { return entry.first.find("(depth 100)") != std::string::npos; }));
+
+	LockProfiler::Reset();
+}
+
+TEST(LockProfilerTest, Threads)
+{
+	if (!LockProfiler::IsAvailable())
+		return;
+
+	const Volume volume;
+	ASSERT_TRUE(volume.SetOrInsert("/foo", uint32_t{ 1 }));
+
+	LockProfiler::Reset();
+	LockProfiler::Enable();
+
+	// threads one after another add up in the same table, the figures of those finished are kept
+	for (size_t round{ 0 }; round < 3; ++round)
+		std::thread{ [&volume]() { ASSERT_TRUE(volume.Get("/foo")); } }.join();
+
+	LockProfiler::Enable(false);
+
+	const auto profile{ LockProfiler::GetProfile() };
+	ASSERT_EQ(profile.ByDepth.size(), 2);
+	ASSERT_EQ(profile.ByDepth[0].Acquisitions, 3);
+	ASSERT_EQ(profile.ByDepth[1].Acquisitions, 3);
+
+	LockProfiler::Reset();
+	ASSERT_TRUE(LockProfiler::GetProfile().ByDepth.empty());
+}
@@ -81,3 +81,46 @@ TEST(PathViewTest, International)
 	std::transform(path.begin(), path.end(), std::back_inserter(result), view2str);
 	ASSERT_EQ(expected, result);
 }
+
+TEST(PathViewTest, Malformed)
+{
+	ASSERT_THROW(utility::PathView{ "" }, std::invalid_argument);
+
+	ASSERT_FALSE(utility::PathView::TryParse(""));
+	ASSERT_FALSE(utility::PathView::TryParse("foo/bar"));
+	ASSERT_NO_THROW(ASSERT_TRUE(utility::PathView::TryParse(source)));
+}
+
+TEST(PathViewTest, RandomAccess)
+{
+	const utility::PathView path{ source };
+
+	ASSERT_EQ(path[0], "foo");
+	ASSERT_EQ(path[3], "etc");
+	ASSERT_EQ(path.GetRest(std::next(path.begin(), 1))[1], "baz");
+	ASSERT_EQ(path.end() - path.begin(), 4);
+}
+
+TEST(PathViewTest, Deep)
+{
+	std::string source;
+	std::vector<std::string> expected;
+	for (size_t i{ 0 }; i < 100; ++i)
+	{
+		expected.push_back(std::to_string(i));
+		source += "//" + expected.back();
+	}
+
+	const auto path{ utility::PathView::TryParse(source) };
+	ASSERT_TRUE(path && path->GetDepth() == expected.size());
+
+	const utility::PathView copy{ *path };
+
+	std::vector<std::string> result;
+	std::transform(copy.begin(), copy.end(), std::back_inserter(result), view2str);
+	ASSERT_EQ(expected, result);
+
+	const auto tail{ copy.GetRest(std::next(copy.begin(), 90)) };
+	ASSERT_EQ(tail.GetDepth(), 10);
+	ASSERT_EQ(tail[0], "90");
+}
@@ -0,0 +1,153 @@
+#include "Storage.h"
+#include "TestHelpers.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+using namespace jb_storage;
+
+TEST(RenameTest, Volume)
+{
+	const Volume volume;
+	ASSERT_TRUE(volume.SetOrInsert("/staging/batch42/a", uint32_t{ 1 }));
+	ASSERT_TRUE(volume.SetOrInsert("/staging/batch42/b/c", std::string{ "c" }));
+	ASSERT_TRUE(volume.SetOrInsert("/staging/batch43", uint32_t{ 2 }));
+	ASSERT_TRUE(volume.SetOrInsert("/live/batch41", uint32_t{ 3 }));
+
+	const auto handle{ volume.Open("/staging/batch42/b") };
+	const auto before{ volume.Snapshot() };
+
+	ASSERT_TRUE(volume.Rename("/staging/batch42", "/live/batch42"));
+
+	ASSERT_FALSE(volume.Get("/staging/batch42"));
+	ASSERT_EQ(volume.Get("/live/batch42/a"), Value{ uint32_t{ 1 } });
+	ASSERT_EQ(volume.Get("/live/batch42/b/c"), Value{ std::string{ "c" } });
+	ASSERT_EQ(volume.List("/staging"), Names{ "batch43" });
+	ASSERT_EQ(volume.List("/live"), (Names{ "batch41", "batch42" }));
+	ASSERT_EQ(volume.GetUsage("/staging")->Nodes, 1);
+	ASSERT_EQ(volume.GetUsage("/live")->Nodes, 5);
+
+	// the subtree is moved as is, so the handle follows it
+	ASSERT_TRUE(handle.SetOrInsert("/d", uint32_t{ 4 }));
+	ASSERT_EQ(volume.Get("/live/batch42/b/d"), Value{ uint32_t{ 4 } });
+
+	ASSERT_EQ(before.Get("/staging/batch42/a"), Value{ uint32_t{ 1 } });
+	ASSERT_FALSE(before.Get("/live/batch42"));
+	ASSERT_EQ(before.List("/live"), Names{ "batch41" });
+
+	// within the same parent, and up the tree
+	ASSERT_TRUE(volume.Rename("/live/batch41", "/live/batch40"));
+	ASSERT_TRUE(volume.Rename("/live/batch42/b", "/b"));
+	ASSERT_EQ(volume.List("/live"), (Names{ "batch40", "batch42" }));
+	ASSERT_EQ(volume.List("/"), (Names{ "b", "live", "staging" }));
+	ASSERT_EQ(volume.Get("/b/c"), Value{ std::string{ "c" } });
+
+	ASSERT_FALSE(volume.Rename("/", "/root"));
+	ASSERT_FALSE(volume.Rename("/live", "/"));
+	ASSERT_FALSE(volume.Rename("/none", "/live/none"));
+	ASSERT_FALSE(volume.Rename("/live/batch40", "/none/batch40"));
+	ASSERT_FALSE(volume.Rename("/live/batch40", "/staging/batch43"));
+	ASSERT_FALSE(volume.Rename("/live", "/live/batch42/live"));
+	ASSERT_FALSE(volume.Rename("/live", "/live"));
+	ASSERT_EQ(volume.Get("/live/batch40"), Value{ uint32_t{ 3 } });
+
+	ExpectExactUsage(volume);
+}
+
+TEST(RenameTest, Move)
+{
+	const Volume staging, live;
+	ASSERT_TRUE(staging.SetOrInsert("/batch42/a", uint32_t{ 1 }));
+	ASSERT_TRUE(staging.SetOrInsert("/batch42/b", Blob{ 1, 2, 3 }));
+	ASSERT_TRUE(live.SetOrInsert("/batches/batch41", uint32_t{ 2 }));
+
+	{
+		const Storage storage;
+		const auto token{ storage.Mount("/live", live, "/batches") };
+		ASSERT_TRUE(token);
+
+		ASSERT_TRUE(staging.Move("/batch42", live, "/batches/batch42"));
+
+		ASSERT_EQ(storage.List("/live"), (Names{ "batch41", "batch42" }));
+		ASSERT_EQ(storage.Get("/live/batch42/b"), Value{ (Blob{ 1, 2, 3 }) });
+	}
+
+	ASSERT_EQ(staging.List("/"), Names{ });
+	ASSERT_EQ(staging.GetStats().Nodes, 0);
+	ASSERT_EQ(live.GetStats().Nodes, 5);
+
+	ASSERT_FALSE(staging.Move("/batch42", live, "/batch42"));
+	ASSERT_FALSE(live.Move("/batches/batch42", staging, "/none/batch42"));
+
+	// clones and frozen volumes don't hand their nodes over, though a clone takes others'
+	const auto clone{ live.Clone() };
+	ASSERT_FALSE(clone.Move("/batches/batch42", staging, "/batch42"));
+	ASSERT_FALSE(live.Move("/batches/batch42", live.Freeze(), "/batch42"));
+	ASSERT_FALSE(live.Freeze().Move("/batches/batch42", staging, "/batch42"));
+	ASSERT_TRUE(clone.Rename("/batches/batch42", "/batch42"));
+	ASSERT_FALSE(staging.Move("/", clone, "/staging"));
+
+	ASSERT_TRUE(staging.SetOrInsert("/batch43/a", uint32_t{ 5 }));
+	ASSERT_TRUE(staging.Move("/batch43", clone, "/batches/batch43"));
+	ASSERT_EQ(clone.List("/batches"), (Names{ "batch41", "batch43" }));
+	ASSERT_EQ(live.List("/batches"), (Names{ "batch41", "batch42" }));
+
+	ExpectExactUsage(clone);
+	ExpectExactUsage(staging);
+	ExpectExactUsage(live);
+}
+
+TEST(RenameTest, Concurrent)
+{
+	const Volume volume;
+	ASSERT_TRUE(volume.SetOrInsert("/a/data", uint32_t{ 0 }));
+	ASSERT_TRUE(volume.SetOrInsert("/b/data", uint32_t{ 0 }));
+
+	// renames racing each other into one another's subtrees, and writers going on under them
+	std::atomic<bool> stop{ false };
+	std::atomic<size_t> renamed{ 0 };
+	std::vector<std::thread> threads;
+	threads.emplace_back([&]()
+	{
+		while (!stop.load())
+			renamed += volume.Rename("/a", "/b/a") || volume.Rename("/b/a", "/a");
+	});
+	threads.emplace_back([&]()
+	{
+		while (!stop.load())
+			renamed += volume.Rename("/b", "/a/b") || volume.Rename("/a/b", "/b");
+	});
+	threads.emplace_back([&]()
+	{
+		// handles follow the nodes wherever they're moved
+		const auto a{ volume.Open("/a/data") };
+		const auto b{ volume.Open("/b/data") };
+
+		for (uint32_t i{ 0 }; !stop.load(); ++i)
+		{
+			a.SetOrInsert("/" + std::to_string(i % 16), Blob(i % 5));
+			b.SetOrInsert("/" + std::to_string(i % 16) + "/x", Blob(i % 3));
+			b.Delete("/" + std::to_string(i % 7));
+		}
+	});
+
+	// every snapshot sees each subtree at one place exactly
+	for (size_t round{ 0 }; round < 500 || renamed.load() < 10000; ++round)
+	{
+		const auto snapshot{ volume.Snapshot() };
+
+		size_t found{ 0 };
+		for (const auto path : { "/a/data", "/b/data", "/b/a/data", "/a/b/data" })
+			found += snapshot.Get(path).has_value();
+
+		EXPECT_EQ(found, 2);
+	}
+
+	stop = true;
+	for (auto& thread : threads)
+		thread.join();
+
+	ExpectExactUsage(volume);
+}
@@ -65,3 +65,29 @@ TEST(SaveLoadTest, DontSaveLoadIfMounted)
 	const auto bar{ dst.Get("/foo/bar") };
 	ASSERT_NO_THROW(ASSERT_TRUE(bar && std::get<uint64_t>(*bar) == 42));
 }
+
+TEST(SaveLoadTest, Deep)
+{
+	std::string path;
+	for (size_t i{ 0 }; i < 200000; ++i)
+		path += "/a";
+
+	const Volume src;
+	ASSERT_TRUE(src.SetOrInsert(path, uint32_t{ 42 }));
+	ASSERT_TRUE(src.SetOrInsert("/b", uint32_t{ 43 }));
+
+	std::stringstream stream{ std::ios_base::in | std::ios_base::out | std::ios_base::binary };
+
+	ASSERT_TRUE(src.Save(stream));
+
+	const Volume dst;
+
+	stream.seekg(0, std::ios::beg);
+	ASSERT_TRUE(dst.Load(stream));
+
+	const auto leaf{ dst.Get(path) };
+	ASSERT_NO_THROW(ASSERT_TRUE(leaf && std::get<uint32_t>(*leaf) == 42));
+
+	const auto sibling{ dst.Get("/b") };
+	ASSERT_NO_THROW(ASSERT_TRUE(sibling && std::get<uint32_t>(*sibling) == 43));
+}
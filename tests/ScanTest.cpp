@@ -0,0 +1,169 @@
+#include "Storage.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+
+using namespace jb_storage;
+
+namespace
+{
+
+	using Names = std::vector<std::string>;
+
+	std::vector<std::pair<std::string, Value>> ScanAll(const IStorage& storage, const std::string_view path, const size_t batch)
+	{
+		std::vector<std::pair<std::string, Value>> visited;
+		std::string resume;
+
+		do
+		{
+			size_t left{ batch };
+			const auto scan = [&](const std::string_view path, const Value& value)
+			{
+				visited.emplace_back(path, value);
+				return --left != 0;
+			};
+
+			if (const auto volume{ dynamic_cast<const Volume*>(&storage) })
+				resume = volume->Scan(path, scan, resume);
+			else
+				resume = dynamic_cast<const Storage&>(storage).Scan(path, scan, resume);
+		}
+		while (!resume.empty());
+
+		return visited;
+	}
+
+}
+
+TEST(ScanTest, List)
+{
+	const Volume volume;
+
+	for (const auto* const path : { "/users/bob", "/users/alice/age", "/users/carol", "/groups/admins" })
+		ASSERT_TRUE(volume.SetOrInsert(path, uint32_t{ 1 }));
+
+	ASSERT_EQ(volume.List("/"), (Names{ "groups", "users" }));
+	ASSERT_EQ(volume.List("/users"), (Names{ "alice", "bob", "carol" }));
+	ASSERT_EQ(volume.List("/users/bob"), Names{ });
+	ASSERT_FALSE(volume.List("/none"));
+
+	ASSERT_EQ(volume.List("/users", 2), (Names{ "alice", "bob" }));
+	ASSERT_EQ(volume.List("/users", 2, "bob"), (Names{ "carol" }));
+	ASSERT_EQ(volume.List("/users", 0, "a"), (Names{ "alice", "bob", "carol" }));
+	ASSERT_EQ(volume.List("/users", 0, "carol"), Names{ });
+}
+
+TEST(ScanTest, Scan)
+{
+	const Volume volume;
+
+	ASSERT_TRUE(volume.SetOrInsert("/a/b", uint32_t{ 1 }));
+	ASSERT_TRUE(volume.SetOrInsert("/a/c/d", uint32_t{ 2 }));
+	ASSERT_TRUE(volume.SetOrInsert("/b", uint32_t{ 3 }));
+
+	const std::vector<std::string> expected{ "/a", "/a/b", "/a/c", "/a/c/d", "/b" };
+
+	for (const size_t batch : { 1, 2, 100 })
+	{
+		const auto visited{ ScanAll(volume, "/", batch) };
+		ASSERT_EQ(visited.size(), expected.size());
+
+		for (size_t i{ 0 }; i < expected.size(); ++i)
+			ASSERT_EQ(visited[i].first, expected[i]);
+
+		ASSERT_EQ(visited[1].second, Value{ uint32_t{ 1 } });
+		ASSERT_EQ(visited[0].second, Value{ });
+	}
+
+	const auto subtree{ ScanAll(volume, "/a/c", 100) };
+	ASSERT_EQ(subtree.size(), 1);
+	ASSERT_EQ(subtree[0].first, "/d");
+
+	ASSERT_TRUE(ScanAll(volume, "/none", 100).empty());
+
+	// resuming after the last visited node was deleted carries on with its next sibling
+	const auto resume{ volume.Scan("/", [](const std::string_view, const Value&) { return false; }) };
+	ASSERT_EQ(resume, "/a");
+	ASSERT_TRUE(volume.Delete("/a"));
+
+	std::vector<std::string> rest;
+	ASSERT_TRUE(volume.Scan("/", [&rest](const std::string_view path, const Value&) { rest.emplace_back(path); return true; }, resume).empty());
+	ASSERT_EQ(rest, Names{ "/b" });
+}
+
+TEST(ScanTest, Wide)
+{
+	const Volume volume;
+
+	std::map<std::string, uint32_t> expected;
+	for (uint32_t i{ 0 }; i < 1000; ++i)
+	{
+		const auto name{ std::to_string(i) };
+		expected.emplace('/' + name, i);
+		ASSERT_TRUE(volume.SetOrInsert("/wide/" + name, i));
+	}
+
+	size_t pages{ 0 };
+	Names listed;
+	for (std::string after; ; ++pages)
+	{
+		const auto page{ volume.List("/wide", 300, after) };
+		ASSERT_TRUE(page);
+
+		if (page->empty())
+			break;
+
+		listed.insert(listed.end(), page->begin(), page->end());
+		after = page->back();
+	}
+
+	ASSERT_EQ(pages, 4);
+	ASSERT_EQ(listed.size(), 1000);
+	ASSERT_TRUE(std::is_sorted(listed.begin(), listed.end()));
+
+	const auto visited{ ScanAll(volume, "/wide", 7) };
+	ASSERT_EQ(visited.size(), expected.size());
+
+	auto it{ expected.begin() };
+	for (const auto& [path, value] : visited)
+	{
+		ASSERT_EQ(path, it->first);
+		ASSERT_EQ(value, Value{ it->second });
+		++it;
+	}
+}
+
+TEST(ScanTest, Storage)
+{
+	const Volume older, newer;
+
+	ASSERT_TRUE(older.SetOrInsert("/a", uint32_t{ 1 }));
+	ASSERT_TRUE(older.SetOrInsert("/b", uint32_t{ 1 }));
+	ASSERT_TRUE(older.SetOrInsert("/d/e", uint32_t{ 1 }));
+	ASSERT_TRUE(newer.SetOrInsert("/b", uint32_t{ 2 }));
+	ASSERT_TRUE(newer.SetOrInsert("/c", uint32_t{ 2 }));
+
+	const Storage storage;
+
+	const auto older_token{ storage.Mount("/", older, "/") };
+	const auto newer_token{ storage.Mount("/", newer, "/") };
+	const auto virtual_token{ storage.Mount("/c/x", older, "/d") };
+	const auto nested_token{ storage.Mount("/z", newer, "/") };
+	ASSERT_TRUE(older_token && newer_token && virtual_token && nested_token);
+
+	// c comes from the newer volume shadowing the virtual node made for /c/x
+	ASSERT_EQ(storage.List("/"), (Names{ "a", "b", "c", "d", "z" }));
+	ASSERT_EQ(storage.List("/", 2, "a"), (Names{ "b", "c" }));
+	ASSERT_EQ(storage.List("/z"), (Names{ "b", "c" }));
+
+	const auto visited{ ScanAll(storage, "/", 2) };
+
+	std::vector<std::string> paths;
+	for (const auto& entry : visited)
+		paths.push_back(entry.first);
+
+	ASSERT_EQ(paths, (Names{ "/a", "/b", "/c", "/d", "/d/e", "/z", "/z/b", "/z/c" }));
+	ASSERT_EQ(visited[1].second, Value{ uint32_t{ 2 } });
+}
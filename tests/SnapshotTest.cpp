@@ -0,0 +1,173 @@
+#include "Storage.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+using namespace jb_storage;
+
+namespace
+{
+
+	using Names = std::vector<std::string>;
+
+	std::vector<std::string> ScanPaths(const Snapshot& snapshot, const std::string_view path)
+	{
+		std::vector<std::string> paths;
+		snapshot.Scan(path, [&paths](const std::string_view path, const Value&) { paths.emplace_back(path); return true; });
+
+		return paths;
+	}
+
+}
+
+TEST(SnapshotTest, Volume)
+{
+	const Volume volume;
+	ASSERT_TRUE(volume.SetOrInsert("/a/b", uint32_t{ 1 }));
+	ASSERT_TRUE(volume.SetOrInsert("/a/c", std::string{ "c" }));
+	ASSERT_TRUE(volume.SetOrInsert("/d", uint64_t{ 2 }));
+
+	const auto before{ volume.Snapshot() };
+
+	ASSERT_TRUE(volume.SetOrInsert("/a/b", uint32_t{ 10 }));
+	ASSERT_TRUE(volume.SetOrInsert("/a/e/f", uint32_t{ 11 }));
+	ASSERT_TRUE(volume.Delete("/a/c"));
+	ASSERT_TRUE(volume.FetchAdd("/d", uint64_t{ 5 }));
+
+	const auto after{ volume.Snapshot() };
+
+	ASSERT_TRUE(volume.Delete("/a"));
+	ASSERT_TRUE(volume.SetOrInsert("/", uint32_t{ 0 }));
+
+	ASSERT_EQ(before.Get("/a/b"), Value{ uint32_t{ 1 } });
+	ASSERT_EQ(before.Get("/a/c"), Value{ std::string{ "c" } });
+	ASSERT_EQ(before.Get("/d"), Value{ uint64_t{ 2 } });
+	ASSERT_EQ(before.Get("/"), Value{ });
+	ASSERT_FALSE(before.Get("/a/e"));
+	ASSERT_EQ(before.List("/a"), (Names{ "b", "c" }));
+	ASSERT_EQ(ScanPaths(before, "/"), (Names{ "/a", "/a/b", "/a/c", "/d" }));
+
+	ASSERT_EQ(after.Get("/a/b"), Value{ uint32_t{ 10 } });
+	ASSERT_FALSE(after.Get("/a/c"));
+	ASSERT_EQ(after.Get("/d"), Value{ uint64_t{ 7 } });
+	ASSERT_EQ(after.List("/a"), (Names{ "b", "e" }));
+	ASSERT_EQ(ScanPaths(after, "/a"), (Names{ "/b", "/e", "/e/f" }));
+
+	ASSERT_FALSE(volume.Get("/a"));
+	ASSERT_EQ(volume.Get("/"), Value{ uint32_t{ 0 } });
+	ASSERT_EQ(volume.Snapshot().List("/"), Names{ "d" });
+}
+
+TEST(SnapshotTest, Consistent)
+{
+	const Volume volume;
+
+	constexpr uint64_t accounts{ 16 }, initial{ 100 };
+	for (uint64_t account{ 0 }; account < accounts; ++account)
+		ASSERT_TRUE(volume.SetOrInsert("/accounts/" + std::to_string(account), initial));
+
+	std::atomic<bool> stop{ false };
+	std::atomic<uint64_t> committed{ 0 };
+	std::thread writer{ [&]()
+	{
+		auto transaction{ volume.BeginTransaction() };
+		for (uint64_t i{ 0 }; !stop.load(); ++i)
+		{
+			const auto from{ "/accounts/" + std::to_string(i % accounts) };
+			const auto to{ "/accounts/" + std::to_string(i * 7 % accounts) };
+			if (from == to)
+				continue;
+
+			const auto source{ std::get<uint64_t>(*transaction.Get(from)) };
+			const auto target{ std::get<uint64_t>(*transaction.Get(to)) };
+			transaction.SetOrInsert(from, source - 1);
+			transaction.SetOrInsert(to, target + 1);
+			committed += transaction.Commit();
+		}
+	} };
+
+	while (committed.load() < 100)
+		std::this_thread::yield();
+
+	for (size_t round{ 0 }; round < 200; ++round)
+	{
+		const auto snapshot{ volume.Snapshot() };
+
+		uint64_t scanned{ 0 }, read{ 0 };
+		snapshot.Scan("/accounts", [&scanned](const std::string_view, const Value& value) { scanned += std::get<uint64_t>(value); return true; });
+
+		for (uint64_t account{ 0 }; account < accounts; ++account)
+			read += std::get<uint64_t>(*snapshot.Get("/accounts/" + std::to_string(account)));
+
+		EXPECT_EQ(scanned, accounts * initial);
+		EXPECT_EQ(read, accounts * initial);
+	}
+
+	stop = true;
+	writer.join();
+}
+
+TEST(SnapshotTest, Counters)
+{
+	const Volume volume;
+	ASSERT_TRUE(volume.SetOrInsert("/first", uint64_t{ 0 }));
+	ASSERT_TRUE(volume.SetOrInsert("/second", uint64_t{ 0 }));
+
+	// both counters are bumped in turn, so that no snapshot sees the second one ahead of the first
+	std::atomic<bool> stop{ false };
+	std::thread writer{ [&]()
+	{
+		while (!stop.load())
+		{
+			volume.FetchAdd("/first", uint64_t{ 1 });
+			volume.FetchAdd("/second", uint64_t{ 1 });
+		}
+	} };
+
+	while (std::get<uint64_t>(*volume.Get("/second")) < 100)
+		std::this_thread::yield();
+
+	for (size_t round{ 0 }; round < 1000; ++round)
+	{
+		const auto snapshot{ volume.Snapshot() };
+		const auto second{ std::get<uint64_t>(*snapshot.Get("/second")) };
+		const auto first{ std::get<uint64_t>(*snapshot.Get("/first")) };
+
+		EXPECT_TRUE(first == second || first == second + 1);
+		EXPECT_EQ(snapshot.Get("/first"), Value{ first });
+	}
+
+	stop = true;
+	writer.join();
+}
+
+TEST(SnapshotTest, Storage)
+{
+	const Volume older, newer;
+	ASSERT_TRUE(older.SetOrInsert("/a", uint32_t{ 1 }));
+	ASSERT_TRUE(older.SetOrInsert("/b", uint32_t{ 1 }));
+	ASSERT_TRUE(newer.SetOrInsert("/b", uint32_t{ 2 }));
+
+	const Storage storage;
+	const auto older_token{ storage.Mount("/data", older, "/") };
+	const auto newer_token{ storage.Mount("/data", newer, "/") };
+	const auto nested_token{ storage.Mount("/deep/mount", older, "/") };
+	ASSERT_TRUE(older_token && newer_token && nested_token);
+
+	const auto snapshot{ storage.Snapshot() };
+
+	ASSERT_TRUE(storage.SetOrInsert("/data/b", uint32_t{ 3 }));
+	ASSERT_TRUE(storage.SetOrInsert("/data/c", uint32_t{ 3 }));
+	ASSERT_TRUE(older.Delete("/a"));
+
+	ASSERT_EQ(snapshot.Get("/data/a"), Value{ uint32_t{ 1 } });
+	ASSERT_EQ(snapshot.Get("/data/b"), Value{ uint32_t{ 2 } });
+	ASSERT_FALSE(snapshot.Get("/data/c"));
+	ASSERT_EQ(snapshot.List("/data"), (Names{ "a", "b" }));
+	ASSERT_EQ(snapshot.List("/"), (Names{ "data", "deep" }));
+	ASSERT_EQ(ScanPaths(snapshot, "/deep"), (Names{ "/mount", "/mount/a", "/mount/b" }));
+
+	ASSERT_EQ(storage.Snapshot().List("/data"), (Names{ "b", "c" }));
+}
@@ -0,0 +1,332 @@
+#include "Reclaimer.h"
+#include "Spiller.h"
+#include "Storage.h"
+#include "TestHelpers.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+using namespace jb_storage;
+
+namespace
+{
+
+	std::string GetSpillPath(const std::string_view name)
+	{ return (std::filesystem::temp_directory_path() / ("SpillTest." + std::string{ name } + ".spill")).string(); }
+
+	std::string GetValue(const size_t user, const size_t key)
+	{ return std::string(100, static_cast<char>('a' + (user + key) % 26)); }
+
+	// an operation over budget schedules a pass, run in the background
+	void WaitForPass()
+	{ utility::Spiller::Instance().Drain(); }
+
+	// a hundred users of twenty keys each, about 12k bytes of footprint per user
+	void Fill(const Volume& volume)
+	{
+		for (size_t user{ 0 }; user < 100; ++user)
+			for (size_t key{ 0 }; key < 20; ++key)
+				ASSERT_TRUE(volume.SetOrInsert("/users/" + std::to_string(user) + "/" + std::to_string(key), GetValue(user, key)));
+	}
+
+}
+
+TEST(SpillTest, Volume)
+{
+	const auto path{ GetSpillPath("Volume") };
+	{
+		const Volume volume;
+		Fill(volume);
+
+		// a quarter of the volume fits, a pass follows every read as long as it's over
+		const auto resident{ volume.GetStats().Spill.ResidentBytes };
+		ASSERT_TRUE(volume.SetMemoryBudget(resident / 4, path));
+		ASSERT_TRUE(std::filesystem::exists(path));
+
+		const auto handle{ volume.Open("/users/99") };
+		for (size_t pass{ 0 }; pass < 4; ++pass)
+			for (size_t user{ 0 }; user < 3; ++user)
+			{
+				ASSERT_EQ(volume.Get("/users/" + std::to_string(user) + "/0"), Value{ GetValue(user, 0) });
+				WaitForPass();
+			}
+
+		auto stats{ volume.GetStats().Spill };
+		ASSERT_GT(stats.Evictions, 0);
+		ASSERT_EQ(stats.Subtrees + stats.FaultIns, stats.Evictions);
+		ASSERT_LE(stats.ResidentBytes, resident / 4);
+		ASSERT_GT(stats.FileBytes, 0);
+		ASSERT_EQ(stats.Bytes + stats.ResidentBytes, resident);
+		ASSERT_EQ(volume.GetStats().Nodes, 2101);
+
+		// pinned by the handle
+		ASSERT_EQ(handle.Get("/0"), Value{ GetValue(99, 0) });
+		ASSERT_TRUE(handle.SetOrInsert("/0", std::string{ "changed" }));
+
+		// everything reads back as it was, the rest written over, deleted or moved around on the way
+		ASSERT_TRUE(volume.SetOrInsert("/users/50/0", std::string{ "changed" }));
+		ASSERT_TRUE(volume.Delete("/users/51"));
+		ASSERT_TRUE(volume.Rename("/users/52", "/moved"));
+		ASSERT_EQ(volume.List("/users/50")->size(), 20);
+
+		size_t values{ 0 };
+		volume.Scan("/users", [&values](const std::string_view, const Value& value) { values += std::holds_alternative<std::string>(value); return true; });
+		ASSERT_EQ(values, 98 * 20);
+		ASSERT_EQ(volume.Get("/users/50/0"), Value{ std::string{ "changed" } });
+		ASSERT_EQ(volume.Get("/users/99/0"), Value{ std::string{ "changed" } });
+		ASSERT_EQ(volume.Get("/users/7/19"), Value{ GetValue(7, 19) });
+		ASSERT_EQ(volume.Get("/moved/3"), Value{ GetValue(52, 3) });
+
+		stats = volume.GetStats().Spill;
+		ASSERT_GT(stats.FaultIns, 0);
+		ExpectExactUsage(volume);
+
+		// turned off, the subtrees are read back as they're touched
+		ASSERT_TRUE(volume.SetMemoryBudget(0, "ignored"));
+		for (size_t user{ 0 }; user < 100; ++user)
+			volume.List("/users/" + std::to_string(user));
+		ASSERT_EQ(volume.GetStats().Spill.Subtrees, 0);
+	}
+
+	ASSERT_FALSE(std::filesystem::exists(path));
+	ASSERT_FALSE(Volume{ }.Freeze().SetMemoryBudget(1, path));
+	ASSERT_FALSE(Volume{ }.Clone().SetMemoryBudget(1, path));
+}
+
+// operations over budget leave the pass to the background thread
+TEST(SpillTest, Background)
+{
+	const Volume volume;
+	Fill(volume);
+
+	std::mutex lock;
+	std::unique_lock held{ lock };
+	utility::Spiller::Instance().Schedule([&lock]() { std::lock_guard wait{ lock }; });
+
+	ASSERT_TRUE(volume.SetMemoryBudget(1, GetSpillPath("Background")));
+	for (size_t pass{ 0 }; pass < 3; ++pass)
+		ASSERT_TRUE(volume.SetOrInsert("/other", uint32_t{ 1 }));
+
+	ASSERT_EQ(volume.GetStats().Spill.Evictions, 0);
+
+	held.unlock();
+	WaitForPass();
+
+	for (size_t pass{ 0 }; pass < 2; ++pass)
+	{
+		ASSERT_TRUE(volume.SetOrInsert("/other", uint32_t{ 1 }));
+		WaitForPass();
+	}
+
+	ASSERT_GT(volume.GetStats().Spill.Evictions, 0);
+}
+
+// a stub takes the place of the node spilled, with its value and totals, and changes below it add up
+TEST(SpillTest, Replaced)
+{
+	const Volume volume;
+	Fill(volume);
+	for (size_t user{ 0 }; user < 100; ++user)
+		ASSERT_TRUE(volume.SetOrInsert("/users/" + std::to_string(user), uint64_t{ user }));
+
+	const auto usage{ volume.GetStats().Nodes };
+	ASSERT_TRUE(volume.SetMemoryBudget(1, GetSpillPath("Replaced")));
+	for (size_t pass{ 0 }; pass < 3; ++pass)
+	{
+		ASSERT_TRUE(volume.SetOrInsert("/other", uint32_t{ 1 }));
+		WaitForPass();
+	}
+
+	ASSERT_GT(volume.GetStats().Spill.Subtrees, 0);
+	ASSERT_EQ(volume.GetStats().Nodes, usage + 1);
+
+	for (size_t user{ 0 }; user < 100; ++user)
+		ASSERT_EQ(volume.Get("/users/" + std::to_string(user)), Value{ uint64_t{ user } });
+
+	ASSERT_TRUE(volume.Delete("/users/3/4"));
+	ASSERT_TRUE(volume.SetOrInsert("/users/5/20/deeper", std::string{ "added" }));
+	ASSERT_EQ(volume.Get("/users/3/5"), Value{ GetValue(3, 5) });
+	ExpectExactUsage(volume);
+}
+
+TEST(SpillTest, Snapshot)
+{
+	const Volume volume;
+	Fill(volume);
+
+	// subtrees a snapshot sees changes in stay, the others go and are read back for it
+	const auto snapshot{ volume.Snapshot() };
+	ASSERT_TRUE(volume.SetOrInsert("/users/0/0", uint32_t{ 1 }));
+	ASSERT_TRUE(volume.SetMemoryBudget(1, GetSpillPath("Snapshot")));
+	for (size_t pass{ 0 }; pass < 3; ++pass)
+	{
+		ASSERT_TRUE(volume.SetOrInsert("/other", uint32_t{ 1 }));
+		WaitForPass();
+	}
+
+	ASSERT_GT(volume.GetStats().Spill.Subtrees, 0);
+	ASSERT_EQ(snapshot.Get("/users/0/0"), Value{ GetValue(0, 0) });
+	ASSERT_EQ(snapshot.Get("/users/42/5"), Value{ GetValue(42, 5) });
+	ASSERT_EQ(volume.Get("/users/0/0"), Value{ uint32_t{ 1 } });
+	ASSERT_EQ(snapshot.List("/users/7")->size(), 20);
+}
+
+// states kept for a snapshot go once it's released, changed subtrees spilled then as well
+TEST(SpillTest, SnapshotReleased)
+{
+	const Volume volume;
+	Fill(volume);
+
+	{
+		const auto snapshot{ volume.Snapshot() };
+		for (size_t user{ 0 }; user < 100; ++user)
+			ASSERT_TRUE(volume.SetOrInsert("/users/" + std::to_string(user) + "/0", uint32_t{ 1 }));
+	}
+
+	utility::Reclaimer::Instance().Drain();
+	ASSERT_TRUE(volume.SetMemoryBudget(1, GetSpillPath("SnapshotReleased")));
+	for (size_t pass{ 0 }; pass < 3; ++pass)
+	{
+		ASSERT_TRUE(volume.SetOrInsert("/other", uint32_t{ 1 }));
+		WaitForPass();
+	}
+
+	ASSERT_GT(volume.GetStats().Spill.Subtrees, 0);
+	ASSERT_EQ(volume.Get("/users/42/0"), Value{ uint32_t{ 1 } });
+	ASSERT_EQ(volume.Get("/users/42/1"), Value{ GetValue(42, 1) });
+}
+
+TEST(SpillTest, Save)
+{
+	// payloads are shared within subtrees spilled and across them
+	const Volume volume;
+	volume.SetDedupThreshold(50);
+	Fill(volume);
+	ASSERT_TRUE(volume.SetMemoryBudget(1, GetSpillPath("Save")));
+	for (size_t pass{ 0 }; pass < 3; ++pass)
+	{
+		ASSERT_TRUE(volume.SetOrInsert("/other", uint32_t{ 1 }));
+		WaitForPass();
+	}
+
+	// subtrees are copied from the file, none read back
+	const auto before{ volume.GetStats().Spill };
+	ASSERT_GT(before.Subtrees, 0);
+
+	std::stringstream stream;
+	ASSERT_TRUE(volume.Save(stream));
+
+	const auto after{ volume.GetStats().Spill };
+	ASSERT_EQ(after.FaultIns, before.FaultIns);
+	ASSERT_EQ(after.Subtrees, before.Subtrees);
+	ASSERT_LT(stream.str().size(), 100 * 20 * 100);
+
+	const Volume loaded;
+	ASSERT_TRUE(loaded.Load(stream));
+	ASSERT_EQ(loaded.GetStats().Nodes, 2102);
+	for (size_t user{ 0 }; user < 100; ++user)
+		for (size_t key{ 0 }; key < 20; ++key)
+			ASSERT_EQ(loaded.Get("/users/" + std::to_string(user) + "/" + std::to_string(key)), Value{ GetValue(user, key) });
+	ASSERT_EQ(loaded.Get("/other"), Value{ uint32_t{ 1 } });
+	ExpectExactUsage(loaded);
+}
+
+TEST(SpillTest, Reuse)
+{
+	const Volume volume;
+	Fill(volume);
+	ASSERT_TRUE(volume.SetMemoryBudget(1, GetSpillPath("Reuse")));
+
+	const auto spill = [&volume]()
+	{
+		for (size_t pass{ 0 }; pass < 3; ++pass)
+		{
+			ASSERT_TRUE(volume.SetOrInsert("/other", uint32_t{ 1 }));
+			WaitForPass();
+		}
+	};
+
+	spill();
+	const auto first{ volume.GetStats().Spill };
+	ASSERT_GT(first.Subtrees, 0);
+	ASSERT_EQ(first.DeadBytes, 0);
+
+	// subtrees read back and spilled again, over and over, take the space they left
+	for (size_t round{ 0 }; round < 5; ++round)
+	{
+		for (size_t user{ 0 }; user < 100; ++user)
+			ASSERT_EQ(volume.List("/users/" + std::to_string(user))->size(), 20);
+
+		ASSERT_GT(volume.GetStats().Spill.DeadBytes, 0);
+		spill();
+	}
+
+	const auto stats{ volume.GetStats().Spill };
+	ASSERT_GT(stats.FaultIns, first.Subtrees);
+	ASSERT_LT(stats.FileBytes, first.FileBytes * 2);
+	ASSERT_LT(stats.DeadBytes, stats.FileBytes);
+
+	// all read back, the whole file is given up
+	ASSERT_TRUE(volume.SetMemoryBudget(0, "ignored"));
+	for (size_t user{ 0 }; user < 100; ++user)
+		volume.List("/users/" + std::to_string(user));
+	volume.List("/users");
+
+	ASSERT_EQ(volume.GetStats().Spill.Subtrees, 0);
+	ASSERT_EQ(volume.GetStats().Spill.DeadBytes, volume.GetStats().Spill.FileBytes);
+}
+
+TEST(SpillTest, Concurrent)
+{
+	const Volume volume;
+	Fill(volume);
+	ASSERT_TRUE(volume.SetMemoryBudget(volume.GetStats().Spill.ResidentBytes / 8, GetSpillPath("Concurrent")));
+
+	// every user's keys are counters of the same value, readers fault them in while others are spilled
+	std::atomic<bool> stop{ false };
+	std::thread writer{ [&volume, &stop]()
+	{
+		for (size_t i{ 0 }; !stop.load(); ++i)
+		{
+			const auto user{ "/users/" + std::to_string(i * 7 % 100) };
+			for (size_t key{ 0 }; key < 20; ++key)
+				volume.SetOrInsert(user + "/" + std::to_string(key), uint64_t{ i });
+		}
+	} };
+
+	// the writer is still running, so failures are reported without returning
+	for (size_t i{ 0 }; i < 2000; ++i)
+	{
+		const auto user{ "/users/" + std::to_string(i * 13 % 100) };
+		EXPECT_TRUE(volume.Get(user + "/0"));
+
+		const auto children{ volume.List(user) };
+		EXPECT_TRUE(children && children->size() == 20);
+	}
+
+	stop = true;
+	writer.join();
+	WaitForPass();
+
+	// passes may have found no cold subtree while the writer went round, these find every one untouched
+	for (size_t pass{ 0 }; pass < 3; ++pass)
+	{
+		volume.Get("/other");
+		WaitForPass();
+	}
+
+	const auto spilled{ volume.GetStats().Spill };
+	ASSERT_GT(spilled.Evictions, 0);
+	ASSERT_GT(spilled.Subtrees, 0);
+
+	for (size_t user{ 0 }; user < 100; ++user)
+		ASSERT_EQ(volume.List("/users/" + std::to_string(user))->size(), 20);
+
+	ASSERT_GT(volume.GetStats().Spill.FaultIns, spilled.FaultIns);
+	ExpectExactUsage(volume);
+}
@@ -0,0 +1,240 @@
+#include "Reclaimer.h"
+#include "Storage.h"
+#include "TestSet.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using namespace jb_storage;
+
+TEST(StatsTest, Histogram)
+{
+	for (uint64_t value{ 0 }; value < 1000000; value = value * 3 / 2 + 1)
+	{
+		const auto index{ LatencyHistogram::GetBucketIndex(value) };
+		const auto upper{ LatencyHistogram::GetBucketUpperBound(index) };
+
+		ASSERT_GE(upper, value);
+		ASSERT_LE(upper - value, value / 16);
+		ASSERT_TRUE(!index || LatencyHistogram::GetBucketUpperBound(index - 1) < value);
+	}
+
+	ASSERT_EQ(LatencyHistogram::GetBucketIndex(~uint64_t{ 0 }), LatencyHistogram::BucketCount - 1);
+
+	LatencyHistogram histogram;
+	ASSERT_EQ(histogram.GetPercentile(50), 0);
+
+	for (uint64_t value{ 1 }; value <= 1000; ++value)
+		histogram.Record(value * 1000);
+
+	ASSERT_EQ(histogram.GetCount(), 1000);
+	ASSERT_EQ(histogram.GetMin(), 1000);
+	ASSERT_EQ(histogram.GetMax(), 1000000);
+	ASSERT_DOUBLE_EQ(histogram.GetMean(), 500500.);
+
+	for (const double percentile : { 50., 90., 99., 99.9 })
+	{
+		const auto expected{ static_cast<double>(percentile * 10000) };
+		const auto reported{ static_cast<double>(histogram.GetPercentile(percentile)) };
+		ASSERT_GE(reported, expected);
+		ASSERT_LE(reported, expected * 17 / 16);
+	}
+
+	ASSERT_EQ(histogram.GetPercentile(100), 1000000);
+
+	LatencyHistogram other;
+	other.Record(1);
+	other.Merge(histogram);
+	ASSERT_EQ(other.GetCount(), 1001);
+	ASSERT_EQ(other.GetMin(), 1);
+	ASSERT_EQ(other.GetMax(), 1000000);
+}
+
+TEST(StatsTest, Volume)
+{
+	const Volume volume;
+
+	ASSERT_TRUE(volume.SetOrInsert("/uncounted", uint32_t{ 1 }));
+
+	auto stats{ volume.GetStats() };
+	ASSERT_FALSE(stats.Enabled);
+	ASSERT_EQ(stats.SetOrInsert.Calls, 0);
+
+	volume.EnableStats();
+
+	ASSERT_TRUE(volume.SetOrInsert("/foo/bar", std::string{ "abcd" }));
+	ASSERT_TRUE(volume.SetOrInsert("/foo/baz", uint64_t{ 42 }));
+	ASSERT_TRUE(volume.Get("/foo/bar"));
+	ASSERT_FALSE(volume.Get("/none"));
+	ASSERT_FALSE(volume.Delete("/none"));
+	ASSERT_TRUE(volume.Delete("/uncounted"));
+
+	stats = volume.GetStats();
+	ASSERT_TRUE(stats.Enabled);
+	ASSERT_EQ(stats.SetOrInsert.Calls, 2);
+	ASSERT_EQ(stats.SetOrInsert.Hits, 2);
+	ASSERT_EQ(stats.Get.Calls, 2);
+	ASSERT_EQ(stats.Get.Hits, 1);
+	ASSERT_EQ(stats.Delete.Calls, 2);
+	ASSERT_EQ(stats.Delete.Hits, 1);
+	ASSERT_EQ(stats.Get.Latency.GetCount(), 2);
+
+	ASSERT_EQ(stats.Nodes, 3);
+	ASSERT_EQ(stats.KeyBytes, 9);
+	ASSERT_EQ(stats.ValueBytes, 12);
+
+	volume.EnableStats(false);
+	ASSERT_TRUE(volume.Get("/foo/bar"));
+
+	stats = volume.GetStats();
+	ASSERT_FALSE(stats.Enabled);
+	ASSERT_EQ(stats.Get.Calls, 2);
+}
+
+TEST(StatsTest, Storage)
+{
+	const Volume volume;
+	const Storage storage;
+
+	storage.EnableStats();
+
+	const auto token{ storage.Mount("/", volume, "/") };
+	ASSERT_TRUE(token);
+
+	ASSERT_TRUE(storage.SetOrInsert("/foo", uint32_t{ 1 }));
+	ASSERT_TRUE(storage.GetAsync("/foo").get());
+	ASSERT_TRUE(storage.Delete("/foo"));
+
+	const auto stats{ storage.GetStats() };
+	ASSERT_EQ(stats.SetOrInsert.Hits, 1);
+	ASSERT_EQ(stats.Get.Hits, 1);
+	ASSERT_EQ(stats.Delete.Hits, 1);
+	ASSERT_EQ(stats.Nodes, 0);
+
+	ASSERT_EQ(volume.GetStats().Get.Calls, 0);
+}
+
+TEST(StatsTest, Concurrent)
+{
+	const Volume volume;
+	volume.EnableStats();
+
+	const auto test_set{ GenerateTestSet("", 3, 4) };
+
+	std::vector<std::thread> threads;
+	for (size_t i{ 0 }; i < 8; ++i)
+		threads.emplace_back([&volume, &test_set]()
+		{
+			for (const auto& entity : test_set)
+			{
+				volume.SetOrInsert(entity.Path, entity.Value_);
+				volume.Get(entity.Path);
+			}
+		});
+
+	for (auto& thread : threads)
+		thread.join();
+
+	const auto stats{ volume.GetStats() };
+	ASSERT_EQ(stats.SetOrInsert.Calls, 8 * test_set.size());
+	ASSERT_EQ(stats.Get.Hits, 8 * test_set.size());
+	ASSERT_EQ(stats.Get.Latency.GetCount(), 8 * test_set.size());
+}
+
+TEST(StatsTest, ThreadsComeAndGo)
+{
+	const Volume volume;
+	volume.EnableStats();
+	ASSERT_TRUE(volume.SetOrInsert("/foo", uint32_t{ 1 }));
+
+	// counts of finished threads stay as their shards are taken over, those of volumes gone are of no harm
+	for (size_t round{ 0 }; round < 4; ++round)
+	{
+		std::vector<std::thread> threads;
+		for (size_t i{ 0 }; i < 4; ++i)
+			threads.emplace_back([&volume]()
+			{
+				const Volume transient;
+				transient.EnableStats();
+
+				for (size_t j{ 0 }; j < 100; ++j)
+				{
+					ASSERT_TRUE(volume.Get("/foo"));
+					ASSERT_FALSE(transient.Get("/foo"));
+				}
+
+				ASSERT_EQ(transient.GetStats().Get.Calls, 100);
+			});
+
+		for (auto& thread : threads)
+			thread.join();
+
+		const auto stats{ volume.GetStats() };
+		ASSERT_EQ(stats.Get.Calls, (round + 1) * 4 * 100);
+		ASSERT_EQ(stats.Get.Hits, (round + 1) * 4 * 100);
+	}
+}
+
+// a burst of deletes leaves no more garbage queued than the reclaimer takes, the rest is destroyed in place
+TEST(StatsTest, ReclaimQueue)
+{
+	const Volume volume;
+	constexpr size_t subtrees{ utility::Reclaimer::Capacity * 4 };
+
+	for (size_t i{ 0 }; i < subtrees; ++i)
+		for (size_t j{ 0 }; j < 4; ++j)
+			ASSERT_TRUE(volume.SetOrInsert("/" + std::to_string(i) + "/" + std::to_string(j), uint64_t{ j }));
+
+	const auto inline_before{ volume.GetStats().Reclaim.Inline };
+
+	std::atomic<bool> done{ false };
+	std::thread deleter{ [&]()
+	{
+		for (size_t i{ 0 }; i < subtrees; ++i)
+			ASSERT_TRUE(volume.Delete("/" + std::to_string(i)));
+
+		done.store(true);
+	} };
+
+	while (!done.load())
+		ASSERT_LE(volume.GetStats().Reclaim.Queued, utility::Reclaimer::Capacity);
+
+	deleter.join();
+	utility::Reclaimer::Instance().Drain();
+
+	const auto stats{ volume.GetStats() };
+	ASSERT_EQ(stats.Reclaim.Queued, 0);
+	ASSERT_GE(stats.Reclaim.Inline, inline_before);
+	ASSERT_EQ(stats.Nodes, 0);
+}
+
+// garbage retired with node locks held is queued past the cap as well, never destroyed by the caller
+TEST(StatsTest, ReclaimLocked)
+{
+	auto& reclaimer{ utility::Reclaimer::Instance() };
+	const auto caller{ std::this_thread::get_id() };
+	std::atomic<size_t> in_place{ 0 };
+
+	std::mutex lock;
+	std::unique_lock held{ lock };
+	reclaimer.Defer([&lock]() { std::lock_guard wait{ lock }; });
+
+	for (size_t i{ 0 }; i < utility::Reclaimer::Capacity * 2; ++i)
+		reclaimer.RetireLocked(std::shared_ptr<const void>{ new int{ 0 }, [&in_place, caller](const void* const garbage)
+		{
+			in_place += std::this_thread::get_id() == caller;
+			delete static_cast<const int*>(garbage);
+		} });
+
+	ReclaimStats stats;
+	reclaimer.GetStats(stats);
+	ASSERT_GE(stats.Queued, utility::Reclaimer::Capacity * 2);
+
+	held.unlock();
+	reclaimer.Drain();
+	ASSERT_EQ(in_place, 0);
+}
@@ -148,3 +148,26 @@ TEST(StorageTest, NoDataInVirtualNode)
 		ASSERT_FALSE(storage.SetOrInsert("/foo", uint32_t{ 42 }));
 	}
 }
+
+TEST(StorageTest, Segments)
+{
+	const Volume volume;
+	const Storage storage;
+
+	ASSERT_TRUE(volume.SetOrInsert("/foo/bar", uint32_t{ 42 }));
+
+	const auto token{ storage.Mount("/vol", volume, "/foo") };
+	ASSERT_TRUE(token);
+
+	const std::string mount_point{ "vol" };
+	const std::string_view key{ "bar" };
+
+	const auto bar{ storage.Get(MakePath(mount_point, key)) };
+	ASSERT_NO_THROW(ASSERT_TRUE(bar && std::get<uint32_t>(*bar) == 42));
+
+	ASSERT_TRUE(storage.SetOrInsert(MakePath(mount_point, "baz"), "42"));
+	ASSERT_TRUE(volume.Get("/foo/baz"));
+
+	ASSERT_TRUE(storage.Delete(MakePath(mount_point, key)));
+	ASSERT_FALSE(volume.Get("/foo/bar"));
+}
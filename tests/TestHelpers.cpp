@@ -0,0 +1,24 @@
+#include "TestHelpers.h"
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+using namespace jb_storage;
+
+void ExpectExactUsage(const Volume& volume)
+{
+	std::stringstream stream;
+	ASSERT_TRUE(volume.Save(stream));
+
+	const Volume copy;
+	ASSERT_TRUE(copy.Load(stream));
+
+	const auto usage{ volume.GetUsage("/") };
+	const auto expected{ copy.GetUsage("/") };
+	ASSERT_TRUE(usage && expected);
+
+	EXPECT_EQ(usage->Nodes, expected->Nodes);
+	EXPECT_EQ(usage->KeyBytes, expected->KeyBytes);
+	EXPECT_EQ(usage->ValueBytes, expected->ValueBytes);
+}
@@ -0,0 +1,14 @@
+#ifndef STORAGE_TESTS_TESTHELPERS_H
+#define STORAGE_TESTS_TESTHELPERS_H
+
+#include "Volume.h"
+
+#include <string>
+#include <vector>
+
+using Names = std::vector<std::string>;
+
+// totals kept along the changes against those counted from scratch by a copy made through a stream
+void ExpectExactUsage(const jb_storage::Volume& volume);
+
+#endif
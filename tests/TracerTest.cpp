@@ -0,0 +1,90 @@
+#include "Storage.h"
+#include "Tracer.h"
+
+#include <gtest/gtest.h>
+
+#include <set>
+#include <sstream>
+#include <thread>
+
+using namespace jb_storage;
+
+TEST(TracerTest, Dump)
+{
+	const Volume volume;
+	const Storage storage;
+
+	const auto token{ storage.Mount("/mnt", volume, "/") };
+	ASSERT_TRUE(token);
+
+	Tracer::Reset();
+	Tracer::Enable();
+
+	ASSERT_TRUE(volume.SetOrInsert("/foo/bar", uint32_t{ 1 }));
+	ASSERT_TRUE(volume.Get("/foo/bar"));
+	ASSERT_TRUE(storage.Get("/mnt/foo/bar"));
+	ASSERT_TRUE(volume.Delete("/foo"));
+
+	Tracer::Enable(false);
+
+	ASSERT_FALSE(volume.Get("/untraced"));
+
+	std::stringstream stream;
+	Tracer::Dump(stream);
+	const auto trace{ stream.str() };
+
+	ASSERT_EQ(trace.find("{"), 0);
+	ASSERT_NE(trace.find("\"traceEvents\":["), std::string::npos);
+
+	if (!Tracer::IsAvailable())
+		return;
+
+	for (const auto* const name : { "\"Get\"", "\"SetOrInsert\"", "\"Delete\"", "\"parse path\"", "\"traverse\"",
+									"\"lock wait\"", "\"copy value\"", "\"grow branch\"", "\"detach\"", "\"resolve mount\"" })
+		ASSERT_NE(trace.find(name), std::string::npos) << name;
+
+	ASSERT_NE(trace.find("\"args\":{\"depth\":2}"), std::string::npos);
+	ASSERT_NE(trace.find("\"ph\":\"X\""), std::string::npos);
+
+	Tracer::Reset();
+
+	std::stringstream empty;
+	Tracer::Dump(empty);
+	ASSERT_EQ(empty.str().find("\"name\""), std::string::npos);
+}
+
+TEST(TracerTest, ThreadsComeAndGo)
+{
+	if (!Tracer::IsAvailable())
+		return;
+
+	const Volume volume;
+	ASSERT_TRUE(volume.SetOrInsert("/foo", uint32_t{ 1 }));
+
+	Tracer::Reset();
+	Tracer::Enable();
+
+	// threads one after another write into the same ring, the events of those finished are kept
+	for (size_t round{ 0 }; round < 3; ++round)
+		std::thread{ [&volume]() { ASSERT_TRUE(volume.Get("/foo")); } }.join();
+
+	Tracer::Enable(false);
+
+	std::stringstream stream;
+	Tracer::Dump(stream);
+	const auto trace{ stream.str() };
+
+	const std::string name{ "\"name\":\"Get\"" }, tid{ "\"tid\":" };
+	size_t events{ 0 };
+	std::set<std::string> threads;
+
+	for (auto found{ trace.find(name) }; found != std::string::npos; found = trace.find(name, found + 1))
+	{
+		const auto begin{ trace.find(tid, found) + tid.size() };
+		threads.insert(trace.substr(begin, trace.find(',', begin) - begin));
+		++events;
+	}
+
+	ASSERT_EQ(events, 3);
+	ASSERT_EQ(threads.size(), 1);
+}
@@ -0,0 +1,247 @@
+#include "Storage.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+using namespace jb_storage;
+
+TEST(TransactionTest, Basic)
+{
+	const Volume volume;
+	ASSERT_TRUE(volume.SetOrInsert("/a/b", uint32_t{ 1 }));
+	ASSERT_TRUE(volume.SetOrInsert("/c", uint32_t{ 2 }));
+
+	auto transaction{ volume.BeginTransaction() };
+	ASSERT_TRUE(transaction.SetOrInsert("/a/b", uint32_t{ 10 }));
+	ASSERT_TRUE(transaction.SetOrInsert("/x/y/z", uint32_t{ 20 }));
+	ASSERT_TRUE(transaction.Delete("/c"));
+	ASSERT_FALSE(transaction.Delete("/"));
+	ASSERT_FALSE(transaction.SetOrInsert("bad", uint32_t{ 0 }));
+
+	// nothing is visible before commit
+	ASSERT_EQ(volume.Get("/a/b"), Value{ uint32_t{ 1 } });
+	ASSERT_FALSE(volume.Get("/x"));
+	ASSERT_TRUE(volume.Get("/c"));
+
+	ASSERT_TRUE(transaction.Commit());
+
+	ASSERT_EQ(volume.Get("/a/b"), Value{ uint32_t{ 10 } });
+	ASSERT_EQ(volume.Get("/x/y/z"), Value{ uint32_t{ 20 } });
+	ASSERT_FALSE(volume.Get("/c"));
+	ASSERT_EQ(volume.GetStats().Nodes, 5);
+
+	// an empty one commits trivially
+	ASSERT_TRUE(transaction.Commit());
+}
+
+TEST(TransactionTest, ReadYourWrites)
+{
+	const Volume volume;
+	ASSERT_TRUE(volume.SetOrInsert("/a/b", uint32_t{ 1 }));
+	ASSERT_TRUE(volume.SetOrInsert("/a/c", uint32_t{ 2 }));
+
+	auto transaction{ volume.BeginTransaction() };
+	ASSERT_EQ(transaction.Get("/a/b"), Value{ uint32_t{ 1 } });
+
+	ASSERT_TRUE(transaction.SetOrInsert("/a/b", uint32_t{ 3 }));
+	ASSERT_EQ(transaction.Get("//a/b/"), Value{ uint32_t{ 3 } });
+
+	ASSERT_TRUE(transaction.Delete("/a"));
+	ASSERT_FALSE(transaction.Get("/a/b"));
+	ASSERT_FALSE(transaction.Get("/a/c"));
+
+	ASSERT_TRUE(transaction.SetOrInsert("/a/d/e", uint32_t{ 4 }));
+	ASSERT_EQ(transaction.Get("/a"), Value{ });
+	ASSERT_EQ(transaction.Get("/a/d"), Value{ });
+	ASSERT_FALSE(transaction.Get("/a/c"));
+
+	ASSERT_TRUE(transaction.Commit());
+
+	ASSERT_EQ(volume.List("/a"), std::vector<std::string>{ "d" });
+	ASSERT_EQ(volume.Get("/a/d/e"), Value{ uint32_t{ 4 } });
+	ASSERT_EQ(volume.Get("/a"), Value{ });
+}
+
+TEST(TransactionTest, Conflict)
+{
+	const Volume volume;
+	ASSERT_TRUE(volume.SetOrInsert("/a", uint32_t{ 1 }));
+	ASSERT_TRUE(volume.SetOrInsert("/b", uint32_t{ 1 }));
+
+	// a value read is changed
+	auto transaction{ volume.BeginTransaction() };
+	ASSERT_TRUE(transaction.Get("/a"));
+	ASSERT_TRUE(transaction.SetOrInsert("/b", uint32_t{ 2 }));
+	ASSERT_TRUE(volume.SetOrInsert("/a", uint32_t{ 5 }));
+	ASSERT_FALSE(transaction.Commit());
+	ASSERT_EQ(volume.Get("/b"), Value{ uint32_t{ 1 } });
+
+	// a path found missing shows up
+	ASSERT_FALSE(transaction.Get("/n"));
+	ASSERT_TRUE(transaction.SetOrInsert("/b", uint32_t{ 2 }));
+	ASSERT_TRUE(volume.SetOrInsert("/n", uint32_t{ 1 }));
+	ASSERT_FALSE(transaction.Commit());
+
+	// a node read is deleted along with its parent
+	ASSERT_TRUE(volume.SetOrInsert("/p/q", uint32_t{ 1 }));
+	ASSERT_TRUE(transaction.Get("/p/q"));
+	ASSERT_TRUE(transaction.SetOrInsert("/b", uint32_t{ 2 }));
+	ASSERT_TRUE(volume.Delete("/p"));
+	ASSERT_FALSE(transaction.Commit());
+
+	// writes to what nobody read don't conflict
+	ASSERT_TRUE(transaction.Get("/a"));
+	ASSERT_TRUE(transaction.SetOrInsert("/b", uint32_t{ 2 }));
+	ASSERT_TRUE(volume.SetOrInsert("/b", uint32_t{ 3 }));
+	ASSERT_TRUE(volume.SetOrInsert("/c", uint32_t{ 3 }));
+	ASSERT_TRUE(transaction.Commit());
+	ASSERT_EQ(volume.Get("/b"), Value{ uint32_t{ 2 } });
+
+	// nor does a branch grown meanwhile where a write lands
+	ASSERT_TRUE(transaction.SetOrInsert("/x/y", uint32_t{ 1 }));
+	ASSERT_TRUE(volume.SetOrInsert("/x/z", uint32_t{ 1 }));
+	ASSERT_TRUE(transaction.Commit());
+	ASSERT_EQ(volume.List("/x"), (std::vector<std::string>{ "y", "z" }));
+}
+
+TEST(TransactionTest, Rename)
+{
+	const Volume volume;
+	ASSERT_TRUE(volume.SetOrInsert("/a/b", uint32_t{ 1 }));
+	ASSERT_TRUE(volume.SetOrInsert("/e", uint32_t{ 1 }));
+
+	// a node read is moved along with its parent, the path read leads nowhere
+	auto transaction{ volume.BeginTransaction() };
+	ASSERT_EQ(transaction.Get("/a/b"), Value{ uint32_t{ 1 } });
+	ASSERT_TRUE(transaction.SetOrInsert("/x", uint32_t{ 1 }));
+	ASSERT_TRUE(volume.Rename("/a", "/c"));
+	ASSERT_FALSE(transaction.Commit());
+	ASSERT_FALSE(volume.Get("/x"));
+
+	// and so does a path found missing below it
+	ASSERT_FALSE(transaction.Get("/c/n"));
+	ASSERT_TRUE(transaction.SetOrInsert("/x", uint32_t{ 1 }));
+	ASSERT_TRUE(volume.Rename("/c", "/a"));
+	ASSERT_FALSE(transaction.Commit());
+	ASSERT_FALSE(volume.Get("/x"));
+
+	// a path read through the new name is as good as any other
+	ASSERT_EQ(transaction.Get("/a/b"), Value{ uint32_t{ 1 } });
+	ASSERT_TRUE(transaction.SetOrInsert("/a/b", uint32_t{ 2 }));
+	ASSERT_TRUE(transaction.Commit());
+	ASSERT_EQ(volume.Get("/a/b"), Value{ uint32_t{ 2 } });
+
+	// moves elsewhere don't conflict, nor do writes resolved once committed
+	ASSERT_EQ(transaction.Get("/e"), Value{ uint32_t{ 1 } });
+	ASSERT_TRUE(transaction.SetOrInsert("/a/b/y", uint32_t{ 1 }));
+	ASSERT_TRUE(volume.Rename("/a/b", "/f"));
+	ASSERT_TRUE(transaction.Commit());
+	ASSERT_FALSE(volume.Get("/f/y"));
+	ASSERT_EQ(volume.Get("/a/b/y"), Value{ uint32_t{ 1 } });
+}
+
+TEST(TransactionTest, Transfers)
+{
+	const Volume volume;
+
+	constexpr uint64_t accounts{ 8 }, initial{ 1000 };
+	for (uint64_t account{ 0 }; account < accounts; ++account)
+		ASSERT_TRUE(volume.SetOrInsert("/accounts/" + std::to_string(account), initial));
+
+	constexpr size_t threads_count{ 4 }, transfers{ 500 };
+	std::vector<std::thread> threads;
+	std::atomic<size_t> conflicts{ 0 };
+
+	for (size_t thread{ 0 }; thread < threads_count; ++thread)
+		threads.emplace_back([&, thread]()
+		{
+			auto transaction{ volume.BeginTransaction() };
+			for (size_t i{ 0 }; i < transfers; ++i)
+			{
+				const auto from{ "/accounts/" + std::to_string((thread + i) % accounts) };
+				const auto to{ "/accounts/" + std::to_string((thread * 3 + i * 5 + 1) % accounts) };
+				if (from == to)
+					continue;
+
+				for (;;)
+				{
+					const auto source{ std::get<uint64_t>(*transaction.Get(from)) };
+					const auto target{ std::get<uint64_t>(*transaction.Get(to)) };
+					transaction.SetOrInsert(from, source - 1);
+					transaction.SetOrInsert(to, target + 1);
+
+					if (transaction.Commit())
+						break;
+
+					++conflicts;
+				}
+			}
+		});
+
+	// a reader sees the total intact
+	threads.emplace_back([&]()
+	{
+		auto transaction{ volume.BeginTransaction() };
+		for (size_t i{ 0 }; i < transfers; )
+		{
+			uint64_t total{ 0 };
+			for (uint64_t account{ 0 }; account < accounts; ++account)
+				total += std::get<uint64_t>(*transaction.Get("/accounts/" + std::to_string(account)));
+
+			if (transaction.Commit())
+			{
+				EXPECT_EQ(total, accounts * initial);
+				++i;
+			}
+		}
+	});
+
+	for (auto& thread : threads)
+		thread.join();
+
+	uint64_t total{ 0 };
+	for (uint64_t account{ 0 }; account < accounts; ++account)
+		total += std::get<uint64_t>(*volume.Get("/accounts/" + std::to_string(account)));
+
+	ASSERT_EQ(total, accounts * initial);
+}
+
+TEST(TransactionTest, Storage)
+{
+	const Volume older, newer;
+	ASSERT_TRUE(older.SetOrInsert("/a", uint32_t{ 1 }));
+	ASSERT_TRUE(older.SetOrInsert("/b", uint32_t{ 1 }));
+	ASSERT_TRUE(newer.SetOrInsert("/b", uint32_t{ 2 }));
+
+	const Storage storage;
+	const auto older_token{ storage.Mount("/data", older, "/") };
+	const auto newer_token{ storage.Mount("/data", newer, "/") };
+	const auto nested_token{ storage.Mount("/deep/mount", older, "/") };
+	ASSERT_TRUE(older_token && newer_token && nested_token);
+
+	auto transaction{ storage.BeginTransaction() };
+	ASSERT_EQ(transaction.Get("/data/a"), Value{ uint32_t{ 1 } });
+	ASSERT_EQ(transaction.Get("/data/b"), Value{ uint32_t{ 2 } });
+	ASSERT_TRUE(transaction.Delete("/data/a"));
+	ASSERT_TRUE(transaction.SetOrInsert("/data/c", uint32_t{ 3 }));
+	ASSERT_TRUE(transaction.Commit());
+
+	ASSERT_FALSE(older.Get("/a"));
+	ASSERT_EQ(newer.Get("/c"), Value{ uint32_t{ 3 } });
+	ASSERT_FALSE(older.Get("/c"));
+
+	// a change made through the volume directly is a conflict all the same
+	ASSERT_TRUE(transaction.Get("/data/b"));
+	ASSERT_TRUE(transaction.SetOrInsert("/data/d", uint32_t{ 4 }));
+	ASSERT_TRUE(newer.SetOrInsert("/b", uint32_t{ 5 }));
+	ASSERT_FALSE(transaction.Commit());
+
+	// nodes leading to mount points belong to no volume
+	ASSERT_TRUE(transaction.SetOrInsert("/elsewhere", uint32_t{ 1 }));
+	ASSERT_FALSE(transaction.Commit());
+	ASSERT_TRUE(transaction.Delete("/deep/mount"));
+	ASSERT_FALSE(transaction.Commit());
+	ASSERT_TRUE(storage.Get("/deep/mount/b"));
+}
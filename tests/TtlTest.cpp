@@ -0,0 +1,225 @@
+#include "Storage.h"
+#include "TestHelpers.h"
+#include "TimerWheel.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <sstream>
+#include <thread>
+
+using namespace jb_storage;
+using namespace std::chrono_literals;
+
+namespace
+{
+
+	// polls until the condition holds, for as long as a loaded machine may take to reap
+	template < typename Condition >
+	bool WaitFor(Condition&& condition)
+	{
+		for (const auto until{ std::chrono::steady_clock::now() + 10s }; std::chrono::steady_clock::now() < until; std::this_thread::sleep_for(5ms))
+			if (condition())
+				return true;
+
+		return condition();
+	}
+
+}
+
+TEST(TtlTest, TimerWheel)
+{
+	constexpr int64_t start{ 1000 };
+	const std::vector<int64_t> deadlines{ start - 5, start + 1, start + 63, start + 64, start + 65, start + 4095, start + 4096, start + 4097, start + 70000, start + 300001 };
+
+	utility::TimerWheel<int64_t> wheel{ start };
+	ASSERT_FALSE(wheel.GetNextTick());
+
+	for (const auto deadline : deadlines)
+		wheel.Schedule(deadline, int64_t{ deadline });
+	ASSERT_EQ(wheel.GetSize(), deadlines.size());
+	ASSERT_EQ(wheel.GetNextTick(), start);
+
+	// every timer fires on its tick, not a tick earlier or later, however far the wheel is moved at a time,
+	// and the next tick to move to is never past the earliest one left
+	std::vector<int64_t> fired;
+	int64_t reached{ start };
+	for (int64_t now{ start }, step{ 1 }; wheel.GetSize(); reached = now, now += step, step = step % 97 + 1)
+	{
+		const auto next{ wheel.GetNextTick() };
+		ASSERT_TRUE(next);
+		ASSERT_LE(*next, std::max(deadlines[fired.size()], reached));
+
+		std::vector<int64_t> due;
+		wheel.Advance(now, due);
+
+		for (const auto deadline : due)
+		{
+			// one scheduled for the past fires on the first move
+			ASSERT_LE(deadline, now);
+			ASSERT_TRUE(deadline > reached || (deadline <= start && reached == start));
+			fired.push_back(deadline);
+		}
+	}
+
+	ASSERT_EQ(fired, deadlines);
+	ASSERT_FALSE(wheel.GetNextTick());
+}
+
+TEST(TtlTest, Volume)
+{
+	const Volume volume;
+	ASSERT_TRUE(volume.SetOrInsert("/a/b", uint32_t{ 1 }, 50ms));
+	ASSERT_TRUE(volume.SetOrInsert("/a/c", uint32_t{ 2 }));
+	ASSERT_TRUE(volume.SetOrInsert("/a/d/e", uint32_t{ 3 }, 50ms));
+	ASSERT_FALSE(volume.SetOrInsert("/", uint32_t{ 4 }, 50ms));
+
+	ASSERT_EQ(volume.Get("/a/b"), Value{ uint32_t{ 1 } });
+	ASSERT_EQ(volume.List("/a"), (Names{ "b", "c", "d" }));
+
+	// nodes a clone copies expire in it as well, yet nothing takes them out of it
+	const auto clone{ volume.Clone() };
+	ASSERT_TRUE(clone.List("/a"));
+
+	ASSERT_TRUE(WaitFor([&volume]() { return !volume.Get("/a/b") && !volume.Get("/a/d/e"); }));
+	ASSERT_EQ(volume.List("/a"), (Names{ "c", "d" }));
+	ASSERT_EQ(clone.List("/a"), (Names{ "c", "d" }));
+	ASSERT_EQ(clone.List("/a/d"), Names{ });
+
+	size_t scanned{ 0 };
+	volume.Scan("/", [&scanned](const std::string_view, const Value&) { return ++scanned; });
+	ASSERT_EQ(scanned, 3);
+	ASSERT_EQ(*clone.Aggregate("/", Aggregation::Sum), 2);
+
+	// expired nodes leave the totals once they're taken out, and saves right away
+	ASSERT_TRUE(WaitFor([&volume]() { return volume.GetUsage("/")->Nodes == 3; }));
+	ExpectExactUsage(volume);
+
+	std::stringstream stream;
+	ASSERT_TRUE(clone.Save(stream));
+	const Volume copy;
+	ASSERT_TRUE(copy.Load(stream));
+	ASSERT_EQ(copy.GetUsage("/")->Nodes, 3);
+	ASSERT_EQ(clone.GetUsage("/")->Nodes, 5);
+}
+
+TEST(TtlTest, SetAnew)
+{
+	const Volume volume;
+
+	// no ttl keeps the node for good, a later one replaces the earlier
+	ASSERT_TRUE(volume.SetOrInsert("/kept", uint32_t{ 1 }, 20ms));
+	ASSERT_TRUE(volume.SetOrInsert("/kept", uint32_t{ 2 }));
+	ASSERT_TRUE(volume.SetOrInsert("/extended", uint32_t{ 1 }, 20ms));
+	ASSERT_TRUE(volume.SetOrInsert("/extended", uint32_t{ 2 }, 1h));
+	ASSERT_TRUE(volume.SetOrInsert("/renamed", uint32_t{ 3 }, 100ms));
+	ASSERT_TRUE(volume.Rename("/renamed", "/moved"));
+
+	std::this_thread::sleep_for(50ms);
+	ASSERT_EQ(volume.Get("/kept"), Value{ uint32_t{ 2 } });
+	ASSERT_EQ(volume.Get("/extended"), Value{ uint32_t{ 2 } });
+
+	// the deadline goes along with a rename, and so does the timer
+	ASSERT_TRUE(WaitFor([&volume]() { return volume.GetUsage("/")->Nodes == 2; }));
+	ASSERT_FALSE(volume.Get("/moved"));
+	ASSERT_EQ(volume.List("/"), (Names{ "extended", "kept" }));
+
+	// an expired node in the way is replaced, subtree and all, as if it was missing
+	ASSERT_TRUE(volume.SetOrInsert("/x/y/z", uint32_t{ 1 }));
+	ASSERT_TRUE(volume.SetOrInsert("/x/y", uint32_t{ 0 }, 1ms));
+	std::this_thread::sleep_for(5ms);
+	ASSERT_FALSE(volume.Get("/x/y"));
+	ASSERT_TRUE(volume.SetOrInsert("/x/y/w", uint32_t{ 2 }));
+	ASSERT_EQ(volume.List("/x/y"), Names{ "w" });
+	ASSERT_TRUE(volume.SetOrInsert("/x/t", uint32_t{ 3 }, 1ms));
+	std::this_thread::sleep_for(5ms);
+	ASSERT_TRUE(volume.Rename("/x/y", "/x/t"));
+	ASSERT_EQ(volume.Get("/x/t/w"), Value{ uint32_t{ 2 } });
+	ExpectExactUsage(volume);
+}
+
+// snapshots read nodes set to expire as of the time they're taken, clones inherit the deadlines as of then
+TEST(TtlTest, Snapshot)
+{
+	const Volume volume;
+	ASSERT_TRUE(volume.SetOrInsert("/a", uint32_t{ 1 }, 200ms));
+	ASSERT_TRUE(volume.SetOrInsert("/c", uint32_t{ 2 }));
+	ASSERT_TRUE(volume.SetOrInsert("/d", uint32_t{ 3 }, 200ms));
+
+	const auto before{ volume.Snapshot() };
+	const auto clone{ volume.Clone() };
+	const auto clone_before{ clone.Snapshot() };
+
+	// set anew for good in the volume only
+	ASSERT_TRUE(volume.SetOrInsert("/d", uint32_t{ 4 }));
+
+	ASSERT_TRUE(WaitFor([&volume]() { return !volume.Get("/a"); }));
+	ASSERT_TRUE(WaitFor([&clone]() { return !clone.Get("/d"); }));
+	ASSERT_TRUE(WaitFor([&volume]() { return volume.GetUsage("/")->Nodes == 2; }));
+
+	ASSERT_EQ(volume.List("/"), (Names{ "c", "d" }));
+	ASSERT_EQ(clone.List("/"), Names{ "c" });
+
+	ASSERT_EQ(before.Get("/a"), Value{ uint32_t{ 1 } });
+	ASSERT_EQ(before.Get("/d"), Value{ uint32_t{ 3 } });
+	ASSERT_EQ(before.List("/"), (Names{ "a", "c", "d" }));
+
+	size_t scanned{ 0 };
+	before.Scan("/", [&scanned](const std::string_view, const Value&) { return ++scanned; });
+	ASSERT_EQ(scanned, 3);
+
+	ASSERT_EQ(clone_before.Get("/a"), Value{ uint32_t{ 1 } });
+	ASSERT_EQ(clone_before.List("/"), (Names{ "a", "c", "d" }));
+}
+
+TEST(TtlTest, Batch)
+{
+	const Volume volume;
+
+	constexpr size_t count{ 10000 };
+	for (size_t i{ 0 }; i < count; ++i)
+		ASSERT_TRUE(volume.SetOrInsert("/sessions/" + std::to_string(i % 10) + "/" + std::to_string(i), uint64_t{ i }, 30ms));
+	ASSERT_TRUE(volume.SetOrInsert("/sessions/0/kept", uint64_t{ count }));
+
+	// readers and writers go on meanwhile
+	std::thread writer{ [&volume]()
+	{
+		for (size_t i{ 0 }; i < 1000; ++i)
+			volume.SetOrInsert("/sessions/" + std::to_string(i % 10) + "/" + std::to_string(i), uint64_t{ i }, 5ms);
+	} };
+
+	size_t scanned{ 0 };
+	volume.Scan("/sessions", [&scanned](const std::string_view, const Value&) { return ++scanned; });
+	writer.join();
+
+	ASSERT_TRUE(WaitFor([&volume]() { return volume.GetUsage("/")->Nodes == 12; }));
+	ASSERT_EQ(volume.List("/sessions/0"), Names{ "kept" });
+	ASSERT_EQ(*volume.Aggregate("/sessions", Aggregation::Sum), count);
+	ExpectExactUsage(volume);
+}
+
+// the expirer takes nodes out below the root while a save goes on, each save is of a tree as it was then
+TEST(TtlTest, SaveWhileExpiring)
+{
+	const Volume volume;
+
+	constexpr size_t count{ 5000 };
+	for (size_t i{ 0 }; i < count; ++i)
+		ASSERT_TRUE(volume.SetOrInsert("/sessions/" + std::to_string(i % 10) + "/" + std::to_string(i), uint64_t{ i }, std::chrono::milliseconds{ 1 + i % 200 }));
+	ASSERT_TRUE(volume.SetOrInsert("/sessions/0/kept", uint64_t{ count }));
+
+	bool saved{ true };
+	ASSERT_TRUE(WaitFor([&volume, &saved]()
+	{
+		const auto expired{ volume.GetUsage("/")->Nodes == 12 };
+
+		std::stringstream stream{ std::ios_base::in | std::ios_base::out | std::ios_base::binary };
+		const Volume copy;
+		saved = saved && volume.Save(stream) && copy.Load(stream) && copy.Get("/sessions/0/kept") == Value{ uint64_t{ count } };
+
+		return expired || !saved;
+	}));
+
+	ASSERT_TRUE(saved);
+	ASSERT_EQ(volume.List("/sessions/0"), Names{ "kept" });
+}
@@ -0,0 +1,163 @@
+#include "Storage.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <sstream>
+#include <thread>
+
+using namespace jb_storage;
+
+namespace
+{
+
+	uint64_t GetSize(const Value& value)
+	{
+		return std::visit([](const auto& value) -> uint64_t
+		{
+			using Type = std::decay_t<decltype(value)>;
+
+			if constexpr (std::is_same_v<Type, std::monostate>)
+				return 0;
+			else if constexpr (std::is_arithmetic_v<Type>)
+				return sizeof(value);
+			else
+				return value.size();
+		}, value);
+	}
+
+	// the same totals the hard way
+	Usage Recount(const Volume& volume, const std::string_view path)
+	{
+		Usage usage;
+		usage.ValueBytes = GetSize(*volume.Get(path));
+
+		volume.Scan(path, [&usage](const std::string_view path, const Value& value)
+		{
+			++usage.Nodes;
+			usage.KeyBytes += path.size() - path.rfind('/') - 1;
+			usage.ValueBytes += GetSize(value);
+			return true;
+		});
+
+		return usage;
+	}
+
+	void ExpectUsage(const std::optional<Usage>& usage, const Usage& expected)
+	{
+		ASSERT_TRUE(usage);
+		ASSERT_EQ(usage->Nodes, expected.Nodes);
+		ASSERT_EQ(usage->KeyBytes, expected.KeyBytes);
+		ASSERT_EQ(usage->ValueBytes, expected.ValueBytes);
+	}
+
+}
+
+TEST(UsageTest, Volume)
+{
+	const Volume volume;
+
+	ExpectUsage(volume.GetUsage("/"), Usage{ });
+
+	ASSERT_TRUE(volume.SetOrInsert("/tenant/a/files/x", std::string{ "hello" }));
+	ASSERT_TRUE(volume.SetOrInsert("/tenant/a/files/y", uint64_t{ 1 }));
+	ASSERT_TRUE(volume.SetOrInsert("/tenant/b", Blob(100)));
+
+	ExpectUsage(volume.GetUsage("/tenant/a"), Usage{ 3, 7, 13 });
+	ExpectUsage(volume.GetUsage("/tenant/a/files/x"), Usage{ 0, 0, 5 });
+	ExpectUsage(volume.GetUsage("/"), Usage{ 6, 15, 113 });
+	ASSERT_FALSE(volume.GetUsage("/none"));
+
+	// overwriting changes bytes only
+	ASSERT_TRUE(volume.SetOrInsert("/tenant/a/files/x", std::string{ "hi" }));
+	ASSERT_TRUE(volume.SetOrInsert("/tenant/a", uint32_t{ 1 }));
+	ExpectUsage(volume.GetUsage("/tenant/a"), Usage{ 3, 7, 14 });
+
+	ASSERT_TRUE(volume.Delete("/tenant/a/files"));
+	ExpectUsage(volume.GetUsage("/tenant/a"), Usage{ 0, 0, 4 });
+	ExpectUsage(volume.GetUsage("/"), Usage{ 3, 8, 104 });
+	ExpectUsage(volume.GetUsage("/"), Recount(volume, "/"));
+
+	const auto stats{ volume.GetStats() };
+	ASSERT_EQ(stats.Nodes, 3);
+	ASSERT_EQ(stats.KeyBytes, 8);
+	ASSERT_EQ(stats.ValueBytes, 104);
+}
+
+TEST(UsageTest, Load)
+{
+	const Volume source;
+
+	for (uint32_t i{ 0 }; i < 100; ++i)
+		ASSERT_TRUE(source.SetOrInsert("/a/" + std::to_string(i % 7) + "/" + std::to_string(i), i));
+
+	std::stringstream stream;
+	ASSERT_TRUE(source.Save(stream));
+
+	const Volume volume;
+	ASSERT_TRUE(volume.SetOrInsert("/gone/soon", uint64_t{ 1 }));
+	ASSERT_TRUE(volume.Load(stream));
+
+	ExpectUsage(volume.GetUsage("/"), Recount(source, "/"));
+	ExpectUsage(volume.GetUsage("/a/3"), Recount(source, "/a/3"));
+
+	// the loaded tree keeps counting
+	ASSERT_TRUE(volume.SetOrInsert("/a/3/x/y", uint32_t{ 1 }));
+	ASSERT_TRUE(volume.Delete("/a/4"));
+	ExpectUsage(volume.GetUsage("/"), Recount(volume, "/"));
+}
+
+TEST(UsageTest, Concurrent)
+{
+	const Volume volume;
+
+	// writers and deleters race over the same few subtrees
+	std::vector<std::thread> threads;
+	for (unsigned thread{ 0 }; thread < 8; ++thread)
+		threads.emplace_back([&volume, thread]()
+		{
+			std::mt19937 engine{ thread };
+			for (size_t i{ 0 }; i < 5000; ++i)
+			{
+				const auto path{ "/" + std::to_string(engine() % 4) + "/" + std::to_string(engine() % 4) + "/" + std::to_string(engine() % 16) };
+
+				if (engine() % 8)
+					volume.SetOrInsert(path, std::string(engine() % 32, 'x'));
+				else
+					volume.Delete(path.substr(0, path.find('/', 1 + engine() % 2 * 2)));
+			}
+		});
+
+	for (auto& thread : threads)
+		thread.join();
+
+	ExpectUsage(volume.GetUsage("/"), Recount(volume, "/"));
+	for (const auto* const path : { "/0", "/1", "/2/3" })
+		if (volume.Get(path))
+			ExpectUsage(volume.GetUsage(path), Recount(volume, path));
+}
+
+TEST(UsageTest, Storage)
+{
+	const Volume first, second;
+
+	ASSERT_TRUE(first.SetOrInsert("/data/x", uint32_t{ 1 }));
+	ASSERT_TRUE(second.SetOrInsert("/y", uint64_t{ 2 }));
+
+	const Storage storage;
+	const auto first_token{ storage.Mount("/mnt/first", first, "/data") };
+	const auto second_token{ storage.Mount("/mnt/second", second, "/") };
+	ASSERT_TRUE(first_token && second_token);
+
+	ExpectUsage(storage.GetUsage("/mnt/first"), Usage{ 1, 1, 4 });
+	ExpectUsage(storage.GetUsage("/mnt/second"), Usage{ 1, 1, 8 });
+	ExpectUsage(storage.GetUsage("/mnt"), Usage{ 4, 13, 12 });
+
+	// writes through the storage show up in the volume and the other way round
+	ASSERT_TRUE(storage.SetOrInsert("/mnt/first/z", uint32_t{ 3 }));
+	ASSERT_TRUE(second.Delete("/y"));
+
+	ExpectUsage(first.GetUsage("/data"), Usage{ 2, 2, 8 });
+	ExpectUsage(storage.GetUsage("/mnt"), Usage{ 4, 13, 8 });
+	ASSERT_FALSE(storage.GetUsage("/none"));
+}
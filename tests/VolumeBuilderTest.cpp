@@ -0,0 +1,133 @@
+#include "Storage.h"
+#include "TestHelpers.h"
+#include "VolumeBuilder.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <thread>
+
+using namespace jb_storage;
+
+namespace
+{
+
+	std::map<std::string, Value> ScanAll(const Volume& volume)
+	{
+		std::map<std::string, Value> visited;
+		volume.Scan("/", [&visited](const std::string_view path, const Value& value) { return visited.emplace(path, value).second; });
+
+		return visited;
+	}
+
+	std::string GetShardPath(const size_t shard)
+	{ return "/shards/" + std::to_string(1000 + shard); }
+
+}
+
+TEST(VolumeBuilderTest, Build)
+{
+	VolumeBuilder builder;
+	ASSERT_TRUE(builder.Add("/", uint32_t{ 1 }));
+	ASSERT_TRUE(builder.Add("/a/b/c", std::string{ "c" }));
+	ASSERT_TRUE(builder.Add("/a/b/d", Blob{ 1, 2 }));
+	ASSERT_TRUE(builder.Add("/a/e", uint64_t{ 2 }));
+	ASSERT_TRUE(builder.Add("/f", double{ 3 }));
+
+	// out of order, taken already, or the root once something else is in
+	ASSERT_FALSE(builder.Add("/a/z", uint32_t{ 0 }));
+	ASSERT_FALSE(builder.Add("/f", uint32_t{ 0 }));
+	ASSERT_FALSE(builder.Add("/", uint32_t{ 0 }));
+	ASSERT_FALSE(builder.Add("/e", uint32_t{ 0 }));
+	ASSERT_TRUE(builder.Add("/f/g", uint32_t{ 4 }));
+	ASSERT_TRUE(builder.Add("/g", uint32_t{ 5 }));
+
+	const auto volume{ builder.Build() };
+
+	const Volume expected;
+	ASSERT_TRUE(expected.SetOrInsert("/", uint32_t{ 1 }));
+	ASSERT_TRUE(expected.SetOrInsert("/a/b/c", std::string{ "c" }));
+	ASSERT_TRUE(expected.SetOrInsert("/a/b/d", Blob{ 1, 2 }));
+	ASSERT_TRUE(expected.SetOrInsert("/a/e", uint64_t{ 2 }));
+	ASSERT_TRUE(expected.SetOrInsert("/f", double{ 3 }));
+	ASSERT_TRUE(expected.SetOrInsert("/f/g", uint32_t{ 4 }));
+	ASSERT_TRUE(expected.SetOrInsert("/g", uint32_t{ 5 }));
+
+	ASSERT_EQ(ScanAll(volume), ScanAll(expected));
+	ASSERT_EQ(volume.Get("/"), Value{ uint32_t{ 1 } });
+	ASSERT_EQ(volume.Get("/a"), Value{ });
+	ASSERT_EQ(volume.GetUsage("/a")->Nodes, 4);
+	ExpectExactUsage(volume);
+
+	// segment by segment, "a" goes before "a.b"
+	ASSERT_TRUE(builder.Add("/a/b", uint32_t{ 1 }));
+	ASSERT_TRUE(builder.Add("/a.b", uint32_t{ 2 }));
+	ASSERT_FALSE(builder.Add("/a/c", uint32_t{ 3 }));
+	ASSERT_EQ(builder.Build().List("/"), (Names{ "a", "a.b" }));
+
+	// the volume built is like any other, and the builder is left empty
+	const auto snapshot{ volume.Snapshot() };
+	ASSERT_TRUE(volume.SetOrInsert("/a/b/c", uint32_t{ 6 }));
+	ASSERT_TRUE(volume.Delete("/f"));
+	ASSERT_EQ(snapshot.Get("/a/b/c"), Value{ std::string{ "c" } });
+	ASSERT_EQ(volume.List("/"), (Names{ "a", "g" }));
+	ExpectExactUsage(volume);
+
+	ASSERT_EQ(builder.Build().List("/"), Names{ });
+}
+
+TEST(VolumeBuilderTest, Parallel)
+{
+	constexpr size_t shards{ 8 }, keys{ 1000 };
+
+	const auto fill = [](VolumeBuilder& builder, const size_t shard)
+	{
+		for (size_t key{ 0 }; key < keys; ++key)
+		{
+			const auto path{ "/" + std::to_string(1000 + key) };
+			if (!builder.Add(path + "/qps", uint64_t{ shard * keys + key }) || !builder.Add(path + "/zone", std::string{ "z" }))
+				return false;
+		}
+
+		return true;
+	};
+
+	std::vector<VolumeBuilder> partitions(shards);
+	std::vector<std::thread> threads;
+	std::vector<char> filled(shards);
+	for (size_t shard{ 0 }; shard < shards; ++shard)
+		threads.emplace_back([&, shard]() { filled[shard] = fill(partitions[shard], shard); });
+
+	for (auto& thread : threads)
+		thread.join();
+
+	VolumeBuilder builder;
+	ASSERT_TRUE(builder.Add("/config", uint32_t{ 1 }));
+	for (size_t shard{ 0 }; shard < shards; ++shard)
+	{
+		ASSERT_TRUE(filled[shard]);
+		ASSERT_TRUE(builder.Attach(GetShardPath(shard), std::move(partitions[shard])));
+	}
+
+	// attached subtrees keep the order, and may be added to after their last nodes
+	ASSERT_FALSE(builder.Attach(GetShardPath(0), VolumeBuilder{ }));
+	ASSERT_FALSE(builder.Add(GetShardPath(shards - 1) + "/1000/none", uint32_t{ 0 }));
+	ASSERT_TRUE(builder.Add(GetShardPath(shards - 1) + "/total", uint32_t{ 0 }));
+
+	const auto volume{ builder.Build() };
+
+	const Volume expected;
+	ASSERT_TRUE(expected.SetOrInsert("/config", uint32_t{ 1 }));
+	for (size_t shard{ 0 }; shard < shards; ++shard)
+		for (size_t key{ 0 }; key < keys; ++key)
+		{
+			const auto path{ GetShardPath(shard) + "/" + std::to_string(1000 + key) };
+			ASSERT_TRUE(expected.SetOrInsert(path + "/qps", uint64_t{ shard * keys + key }));
+			ASSERT_TRUE(expected.SetOrInsert(path + "/zone", std::string{ "z" }));
+		}
+	ASSERT_TRUE(expected.SetOrInsert(GetShardPath(shards - 1) + "/total", uint32_t{ 0 }));
+
+	ASSERT_EQ(ScanAll(volume), ScanAll(expected));
+	ASSERT_EQ(*volume.Aggregate("/shards", Aggregation::Sum), double(shards * keys) * (shards * keys - 1) / 2);
+	ExpectExactUsage(volume);
+}
@@ -76,3 +76,43 @@ TEST(VolumeTest, DeleteNonRoot)
 		ASSERT_NO_THROW(ASSERT_TRUE(foo && std::get<double>(*foo) == 42.));
 	}
 }
+
+TEST(VolumeTest, Segments)
+{
+	const Volume volume;
+
+	ASSERT_TRUE(volume.SetOrInsert(MakePath("foo", "bar"), uint32_t{ 42 }));
+
+	const auto bar{ volume.Get("/foo/bar") };
+	ASSERT_NO_THROW(ASSERT_TRUE(bar && std::get<uint32_t>(*bar) == 42));
+
+	const std::vector<std::string_view> segments{ "foo", "bar" };
+	ASSERT_TRUE(volume.Get(segments) == bar);
+	ASSERT_TRUE(volume.Get(MakePath()) && !volume.Delete(MakePath()));
+
+	ASSERT_FALSE(volume.SetOrInsert(MakePath("foo", ""), uint32_t{ 42 }));
+	ASSERT_FALSE(volume.SetOrInsert(MakePath("foo", "bar/baz"), uint32_t{ 42 }));
+	ASSERT_FALSE(volume.Get(MakePath("foo", "bar/baz")));
+
+	ASSERT_TRUE(volume.Delete(segments));
+	ASSERT_FALSE(volume.Get("/foo/bar"));
+}
+
+TEST(VolumeTest, DeleteDeep)
+{
+	std::string path;
+	for (size_t i{ 0 }; i < 200000; ++i)
+		path += "/a";
+
+	{
+		const Volume volume;
+
+		ASSERT_TRUE(volume.SetOrInsert(path, uint32_t{ 42 }));
+		ASSERT_TRUE(volume.Get(path));
+
+		ASSERT_TRUE(volume.Delete("/a"));
+		ASSERT_FALSE(volume.Get("/a"));
+
+		ASSERT_TRUE(volume.SetOrInsert(path, uint32_t{ 42 }));
+	}
+}
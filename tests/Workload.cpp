@@ -0,0 +1,236 @@
+#include "Workload.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <future>
+#include <iomanip>
+#include <thread>
+
+using namespace jb_storage;
+
+namespace
+{
+
+	enum Operation : size_t
+	{
+		Read,
+		Write,
+		Delete,
+		Mount,
+		OperationCount
+	};
+
+	using Clock = std::chrono::steady_clock;
+
+	double Zeta(const uint64_t count, const double theta)
+	{
+		double sum{ 0 };
+		for (uint64_t i{ 1 }; i <= count; ++i)
+			sum += 1 / std::pow(static_cast<double>(i), theta);
+
+		return sum;
+	}
+
+	uint64_t Scramble(uint64_t value) noexcept
+	{
+		// FNV-1a over the bytes of value
+		uint64_t hash{ 14695981039346656037ull };
+		for (size_t i{ 0 }; i < sizeof(value); ++i, value >>= 8)
+			hash = (hash ^ (value & 0xff)) * 1099511628211ull;
+
+		return hash;
+	}
+
+	Value MakeValue(const WorkloadConfig& config, std::mt19937_64& engine)
+	{
+		const auto low{ std::min(config.MinValueSize, config.MaxValueSize) };
+		const auto high{ config.MaxValueSize };
+
+		size_t size{ high };
+		switch (config.ValueSizeDistribution)
+		{
+		case WorkloadConfig::ValueSize::Constant:
+			break;
+
+		case WorkloadConfig::ValueSize::Uniform:
+			size = std::uniform_int_distribution<size_t>{ low, high }(engine);
+			break;
+
+		case WorkloadConfig::ValueSize::Exponential:
+			{
+				const auto mean{ std::max(1., (low + high) / 2.) };
+				size = std::clamp(static_cast<size_t>(std::exponential_distribution<>{ 1 / mean }(engine)), low, high);
+			}
+			break;
+		}
+
+		if (!size)
+			return Value{ static_cast<uint64_t>(engine()) };
+
+		return Value{ Blob(size, static_cast<uint8_t>(engine())) };
+	}
+
+	template < typename Target, typename Mounter >
+	WorkloadReport Run(const Target& target, const WorkloadConfig& config, const Mounter& mount)
+	{
+		const std::array<double, OperationCount> weights{ config.ReadRatio, config.WriteRatio, config.DeleteRatio, config.MountRatio };
+		const ZipfianGenerator keys{ std::max<uint64_t>(config.KeyCount, 1), config.ZipfianTheta, true };
+
+		std::vector<std::array<OperationStats, OperationCount>> reports(config.Threads);
+		std::vector<std::thread> threads;
+
+		std::promise<Clock::time_point> start_promise;
+		const std::shared_future<Clock::time_point> start{ start_promise.get_future().share() };
+
+		for (size_t thread{ 0 }; thread < config.Threads; ++thread)
+			threads.emplace_back([&, thread]()
+			{
+				std::mt19937_64 engine{ config.Seed + thread };
+				std::discrete_distribution<size_t> operations{ weights.begin(), weights.end() };
+				auto& report{ reports[thread] };
+
+				const auto deadline{ start.get() + config.Duration };
+
+				for (size_t done{ 0 }; config.OperationsPerThread ? done < config.OperationsPerThread : Clock::now() < deadline; ++done)
+				{
+					const auto operation{ operations(engine) };
+					const auto key{ GetWorkloadKey(config, keys(engine)) };
+					auto value{ operation == Write ? MakeValue(config, engine) : Value{ } };
+
+					const auto begin{ Clock::now() };
+					bool hit{ false };
+
+					switch (operation)
+					{
+					case Read:		hit = !!target.Get(key); break;
+					case Write:		hit = target.SetOrInsert(key, std::move(value)); break;
+					case Delete:	hit = target.Delete(key); break;
+					case Mount:		hit = mount(thread, key); break;
+					}
+
+					const auto elapsed{ std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count() };
+
+					auto& stats{ report[operation] };
+					++stats.Calls;
+					stats.Hits += hit;
+					stats.Latency.Record(static_cast<uint64_t>(elapsed));
+				}
+			});
+
+		const auto started{ Clock::now() };
+		start_promise.set_value(started);
+
+		for (auto& thread : threads)
+			thread.join();
+
+		WorkloadReport result;
+		result.Seconds = std::chrono::duration<double>(Clock::now() - started).count();
+
+		OperationStats* const totals[]{ &result.Read, &result.Write, &result.Delete, &result.Mount };
+		for (const auto& report : reports)
+			for (size_t operation{ 0 }; operation < OperationCount; ++operation)
+			{
+				totals[operation]->Calls += report[operation].Calls;
+				totals[operation]->Hits += report[operation].Hits;
+				totals[operation]->Latency.Merge(report[operation].Latency);
+				result.Operations += report[operation].Calls;
+			}
+
+		return result;
+	}
+
+	void Preload(const Volume& volume, const WorkloadConfig& config)
+	{
+		std::mt19937_64 engine{ config.Seed };
+		for (uint64_t index{ 0 }; index < config.KeyCount; ++index)
+			volume.SetOrInsert(GetWorkloadKey(config, index), MakeValue(config, engine));
+	}
+
+	void PrintOperation(std::ostream& os, const char* const name, const OperationStats& stats)
+	{
+		if (!stats.Calls)
+			return;
+
+		const auto us = [&stats](const double percentile) { return stats.Latency.GetPercentile(percentile) / 1000.; };
+
+		os << std::setw(8) << name << ": " << stats.Calls << " calls, " << stats.Hits << " hits, latency us"
+			<< " p50 " << us(50) << " p90 " << us(90) << " p99 " << us(99) << " p99.9 " << us(99.9)
+			<< " max " << stats.Latency.GetMax() / 1000. << '\n';
+	}
+
+}
+
+std::ostream& operator << (std::ostream& os, const WorkloadReport& report)
+{
+	os << report.Operations << " operations in " << report.Seconds << " s, " << report.GetThroughput() << " ops/s\n";
+
+	PrintOperation(os, "read", report.Read);
+	PrintOperation(os, "write", report.Write);
+	PrintOperation(os, "delete", report.Delete);
+	PrintOperation(os, "mount", report.Mount);
+
+	return os;
+}
+
+ZipfianGenerator::ZipfianGenerator(const uint64_t count, const double theta, const bool scrambled)
+	: _count{ count }, _theta{ std::clamp(theta, 0., 0.9999) }, _scrambled{ scrambled }
+{
+	_alpha = 1 / (1 - _theta);
+	_zeta = Zeta(_count, _theta);
+	_eta = _count > 2 ? (1 - std::pow(2. / _count, 1 - _theta)) / (1 - Zeta(2, _theta) / _zeta) : 0;
+}
+
+uint64_t ZipfianGenerator::operator () (std::mt19937_64& engine) const
+{
+	const auto u{ std::uniform_real_distribution<>{ 0, 1 }(engine) };
+	const auto uz{ u * _zeta };
+
+	uint64_t rank{ 0 };
+	if (uz < 1 || _count < 2)
+		rank = 0;
+	else if (uz < 1 + std::pow(0.5, _theta) || _count < 3)
+		rank = 1;
+	else
+		rank = std::min(_count - 1, static_cast<uint64_t>(_count * std::pow(_eta * u - _eta + 1, _alpha)));
+
+	return _scrambled ? Scramble(rank) % _count : rank;
+}
+
+std::string GetWorkloadKey(const WorkloadConfig& config, uint64_t index)
+{
+	const auto depth{ std::max<size_t>(config.KeyDepth, 1) };
+	const auto fanout{ std::max<uint64_t>(2, static_cast<uint64_t>(std::ceil(std::pow(static_cast<double>(config.KeyCount), 1. / depth)))) };
+
+	std::string key;
+	for (size_t level{ 0 }; level < depth; ++level, index /= fanout)
+		(key += "/k") += std::to_string(index % fanout);
+
+	return key;
+}
+
+WorkloadReport RunWorkload(const Volume& volume, const WorkloadConfig& config)
+{
+	Preload(volume, config);
+
+	auto volume_config{ config };
+	volume_config.MountRatio = 0;
+
+	return Run(volume, volume_config, [](const size_t, const std::string&) { return false; });
+}
+
+WorkloadReport RunWorkload(const Storage& storage, const Volume& volume, const WorkloadConfig& config)
+{
+	Preload(volume, config);
+
+	const auto token{ storage.Mount("/", volume, "/") };
+	if (!token)
+		return { };
+
+	return Run(storage, config, [&storage, &volume](const size_t thread, const std::string& key)
+	{
+		const auto subtree{ key.substr(0, key.find('/', 1)) };
+		const auto mounted{ storage.Mount("/mounts/" + std::to_string(thread), volume, subtree) };
+		return !!mounted; // unmounted right away
+	});
+}
@@ -0,0 +1,83 @@
+#ifndef STORAGE_TESTS_WORKLOAD_H
+#define STORAGE_TESTS_WORKLOAD_H
+
+#include "Storage.h"
+
+#include <chrono>
+#include <ostream>
+#include <random>
+
+// YCSB-style load: every thread issues operations picked by ratio against keys picked with Zipfian skew
+// from a fixed key space, preloaded before the run. Keys are paths of KeyDepth segments, so that
+// neighbouring keys share ancestors and contend for their locks.
+struct WorkloadConfig
+{
+	enum class ValueSize
+	{
+		Constant,		// MaxValueSize
+		Uniform,		// MinValueSize to MaxValueSize
+		Exponential		// mean of MinValueSize and MaxValueSize, clamped to them
+	};
+
+	// relative weights, don't need to sum up to 1
+	double						ReadRatio{ 0.5 };
+	double						WriteRatio{ 0.4 };
+	double						DeleteRatio{ 0.1 };
+	double						MountRatio{ 0 };	// mounts and unmounts a subtree of the volume, Storage only
+
+	size_t						KeyCount{ 10000 };
+	size_t						KeyDepth{ 3 };
+	double						ZipfianTheta{ 0.99 };	// 0 is uniform, YCSB uses 0.99
+
+	ValueSize					ValueSizeDistribution{ ValueSize::Uniform };
+	size_t						MinValueSize{ 8 };
+	size_t						MaxValueSize{ 256 };
+
+	size_t						Threads{ 4 };
+	std::chrono::milliseconds	Duration{ 1000 };
+	size_t						OperationsPerThread{ 0 };	// if not 0, overrides Duration
+
+	uint64_t					Seed{ 0 };
+};
+
+struct WorkloadReport
+{
+	jb_storage::OperationStats	Read;
+	jb_storage::OperationStats	Write;
+	jb_storage::OperationStats	Delete;
+	jb_storage::OperationStats	Mount;
+
+	uint64_t					Operations{ 0 };
+	double						Seconds{ 0 };
+
+	double GetThroughput() const noexcept { return Seconds > 0 ? Operations / Seconds : 0; }
+};
+
+std::ostream& operator << (std::ostream& os, const WorkloadReport& report);
+
+// Zipfian ranks over [0, count) as generated by YCSB (Gray et al., "Quickly generating billion-record
+// synthetic databases"), rank 0 being the most popular; scrambled ones are spread over the key space
+class ZipfianGenerator
+{
+private:
+	uint64_t	_count;
+	double		_theta;
+	double		_alpha;
+	double		_zeta;
+	double		_eta;
+	bool		_scrambled;
+
+public:
+	ZipfianGenerator(const uint64_t count, const double theta, const bool scrambled);
+
+	uint64_t operator () (std::mt19937_64& engine) const;
+};
+
+std::string GetWorkloadKey(const WorkloadConfig& config, const uint64_t index);
+
+WorkloadReport RunWorkload(const jb_storage::Volume& volume, const WorkloadConfig& config);
+
+// volume is mounted to the root of storage for the run
+WorkloadReport RunWorkload(const jb_storage::Storage& storage, const jb_storage::Volume& volume, const WorkloadConfig& config);
+
+#endif
@@ -0,0 +1,87 @@
+#include "Workload.h"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <sstream>
+
+using namespace jb_storage;
+
+TEST(WorkloadTest, Zipfian)
+{
+	std::mt19937_64 engine{ 42 };
+
+	const ZipfianGenerator skewed{ 1000, 0.99, false };
+	const ZipfianGenerator uniform{ 1000, 0, false };
+
+	std::map<uint64_t, size_t> skewed_hits, uniform_hits;
+	for (size_t i{ 0 }; i < 100000; ++i)
+	{
+		const auto rank{ skewed(engine) };
+		ASSERT_LT(rank, 1000);
+		++skewed_hits[rank];
+		++uniform_hits[uniform(engine)];
+	}
+
+	// the most popular key gets about 1/zeta(1000, 0.99) of all hits, i.e. more than a tenth
+	ASSERT_GT(skewed_hits[0], 10000);
+	ASSERT_GT(skewed_hits[0], skewed_hits[1]);
+	ASSERT_GT(skewed_hits[1], skewed_hits[100]);
+	ASSERT_LT(uniform_hits[0], 300);
+}
+
+TEST(WorkloadTest, Keys)
+{
+	WorkloadConfig config;
+	config.KeyCount = 1000;
+	config.KeyDepth = 3;
+
+	ASSERT_EQ(GetWorkloadKey(config, 0), "/k0/k0/k0");
+	ASSERT_EQ(GetWorkloadKey(config, 999), "/k9/k9/k9");
+	ASSERT_EQ(GetWorkloadKey(config, 123), "/k3/k2/k1");
+}
+
+TEST(WorkloadTest, Volume)
+{
+	WorkloadConfig config;
+	config.KeyCount = 1000;
+	config.Threads = 4;
+	config.OperationsPerThread = 2000;
+	config.MountRatio = 1;
+
+	const Volume volume;
+	const auto report{ RunWorkload(volume, config) };
+
+	ASSERT_EQ(report.Operations, 8000);
+	ASSERT_EQ(report.Read.Calls + report.Write.Calls + report.Delete.Calls, 8000);
+	ASSERT_EQ(report.Mount.Calls, 0);
+	ASSERT_EQ(report.Write.Hits, report.Write.Calls);
+	ASSERT_GT(report.Read.Hits, 0);
+	ASSERT_EQ(report.Read.Latency.GetCount(), report.Read.Calls);
+	ASSERT_GT(report.GetThroughput(), 0);
+
+	std::ostringstream printed;
+	printed << report;
+	ASSERT_NE(printed.str().find("ops/s"), std::string::npos);
+}
+
+TEST(WorkloadTest, Storage)
+{
+	WorkloadConfig config;
+	config.KeyCount = 1000;
+	config.Threads = 4;
+	config.Duration = std::chrono::milliseconds{ 100 };
+	config.ReadRatio = 0.5;
+	config.WriteRatio = 0.3;
+	config.DeleteRatio = 0.1;
+	config.MountRatio = 0.1;
+	config.ValueSizeDistribution = WorkloadConfig::ValueSize::Exponential;
+
+	const Volume volume;
+	const Storage storage;
+	const auto report{ RunWorkload(storage, volume, config) };
+
+	ASSERT_GT(report.Operations, 0);
+	ASSERT_GT(report.Mount.Calls, 0);
+	ASSERT_GE(report.Seconds, 0.1);
+}